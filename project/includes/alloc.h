@@ -0,0 +1,24 @@
+/**
+ * @file   alloc.h
+ *
+ * @date   2026-10-19
+ * @author Jean-Lou Dupont
+ */
+
+#ifndef ALLOC_H_
+#define ALLOC_H_
+
+#include <stddef.h>
+
+
+	// PROTOTYPES
+	void *alloc_malloc(litm_alloc_class cls, size_t size);
+	void *alloc_calloc(litm_alloc_class cls, size_t count, size_t size);
+	void *alloc_memalign(litm_alloc_class cls, size_t alignment, size_t size);
+	void *alloc_realloc(litm_alloc_class cls, void *ptr, size_t old_size, size_t size);
+	void  alloc_free(litm_alloc_class cls, void *ptr, size_t size);
+	void  alloc_get_stats(litm_alloc_stats *stats);
+	char *alloc_class_name(litm_alloc_class cls);
+
+
+#endif /* ALLOC_H_ */
@@ -8,6 +8,8 @@
 #ifndef CONNECTION_H_
 #define CONNECTION_H_
 
+#	define LITM_CONNECTION_INDEX_SIZE 32 // power of 2, at least 2*LITM_CONNECTION_MAX
+
 
 	/**
 	 * Opens (creates) a new connection
@@ -33,5 +35,6 @@
 	void _litm_connection_unlock(litm_connection *conn);
 	litm_connection_status _litm_connection_get_status(litm_connection *conn);
 	void _litm_connection_signal_all(void);
+	litm_connection *_litm_connection_find(int id);
 
 #endif /* CONNECTION_H_ */
@@ -0,0 +1,21 @@
+/**
+ * @file   flight.h
+ *
+ * @date   2026-10-19
+ * @author Jean-Lou Dupont
+ */
+
+#ifndef FLIGHT_H_
+#define FLIGHT_H_
+
+
+	// PROTOTYPES
+	void      flight_enable(int enable);
+	void      flight_record(litm_flight_code code, unsigned int envelope, int conn);
+	void      flight_connection(int index, int id);
+	litm_code flight_dump(const char *path);
+	litm_code flight_dump_on_signal(const char *path);
+	char     *flight_code_name(litm_flight_code code);
+
+
+#endif /* FLIGHT_H_ */
@@ -202,6 +202,31 @@
  *								\li Corrected some shortcomings of the DEBIAN control files
  *								\li Fixed response to LITM_MESSAGE_TYPE_TIMER causing queue conditions to generate segfault
  *
+ *		\subsection release_1_2 Release 1.2
+ *
+ *								\li Added ``work-queue`` bus modes (litm_bus_set_mode): one recipient per message
+ *								\li Added ``partitioned`` bus mode and litm_send_keyed: per-key ordering through consistent hashing
+ *								\li Added litm_subscribe_filtered: message ``type`` filters evaluated in the switch
+ *								\li Added hierarchical ``topics`` with wildcard subscriptions (litm_topic_register, litm_subscribe_topic, litm_send_topic)
+ *								\li Added priority lanes (litm_send_priority): FIFO inside a priority class, with anti-starvation quota
+ *								\li Connection input queues are lock-free & allocation-free single-producer/single-consumer rings
+ *								\li Added pluggable queue backends (litm_set_queue_backend): list, lock-free MPSC, SPSC ring, bounded MPMC
+ *								\li Added per-message deadlines (litm_send_ttl): expired envelopes are dropped, never delivered
+ *								\li Added switch statistics (litm_get_switch_stats)
+ *								\li Added ``conflating`` bus mode: only the newest value per ``key`` is kept pending
+ *								\li Added per-bus replay caches (litm_bus_set_replay): new subscribers are primed with recent messages
+ *								\li Added litm_send_tracked: completion ``tokens`` resolved once all subscribers released the message
+ *								\li Added request / reply (litm_request, litm_reply): replies are matched by correlation id, no fan-out
+ *								\li Added litm_send_to: direct sends to a connection ``id``, no subscription involved
+ *								\li Added litm_send_multi: one envelope for several busses, each subscriber served once
+ *								\li Added litm_msg_alloc: size-classed per-connection message slabs, no cleaner needed
+ *								\li Added envelope timestamps (litm_set_timestamps, litm_get_timestamps): per-stage latency breakdown
+ *								\li Added allocation counters per subsystem (litm_get_alloc_stats)
+ *								\li Added the LITM_LOCK_PROFILE build: per-lock contention statistics (litm_get_lock_stats)
+ *								\li Added the flight recorder: per-thread rings of envelope events, dumped on demand or on a fatal signal
+ *								\li Added the watchdog: reports of the envelopes held too long, per-bus release timeouts
+ *								\li Added the traffic matrix: sampled messages, bytes & switch time per sender, bus and type
+ *
  * \todo Better connection close
  *
  */
@@ -227,6 +252,15 @@
 #	define LITM_BUSSES_MAX          7
 #	define LITM_DEFAULT_MAX_TIMEOUT 5
 #	define LITM_DEFAULT_MAX_BACKOFF 1
+#	define LITM_TYPE_SET_MAX        256
+#	define LITM_TOPICS_MAX          64
+#	define LITM_TOPIC_NAME_MAX      128
+#	define LITM_TOPIC_PATTERNS_MAX  64
+#	define LITM_PRIORITY_LEVELS     4
+#	define LITM_PRIORITY_QUOTA      8
+#	define LITM_CONFLATION_KEYS     1024
+#	define LITM_REPLAY_DEPTH_MAX     64
+#	define LITM_MSG_SIZE_MAX         4096
 
 
 		/**
@@ -237,6 +271,7 @@
 			LITM_MESSAGE_TYPE_INVALID = 0,
 			LITM_MESSAGE_TYPE_SHUTDOWN,
 			LITM_MESSAGE_TYPE_TIMER,
+			LITM_MESSAGE_TYPE_JOIN,		// switch internal: a subscriber joins a bus with a replay cache
 
 			// Start index of user message types
 			// =================================
@@ -244,6 +279,26 @@
 
 		};
 
+		/**
+		 * Message priorities
+		 *
+		 * Each priority class has its own lane in the switch's
+		 *  queue and in each connection's input queue: lanes are
+		 *  served in priority order, FIFO inside a lane.  A lane
+		 *  passed over LITM_PRIORITY_QUOTA times in a row is served
+		 *  next so that bulk traffic can't starve.
+		 *
+		 *  LITM_MESSAGE_TYPE_SHUTDOWN messages are always URGENT.
+		 */
+		enum _litm_priorities {
+
+			LITM_PRIORITY_URGENT = 0,
+			LITM_PRIORITY_HIGH,
+			LITM_PRIORITY_NORMAL,
+			LITM_PRIORITY_BULK
+
+		};
+
 		/**
 		 * Queue node - entry in a queue
 		 *
@@ -255,18 +310,57 @@
 			struct _queue_node *next;
 		} queue_node;
 
+		/**
+		 * Queue backends
+		 *
+		 * LITM_QUEUE_BACKEND_LIST: mutex protected linked list
+		 * LITM_QUEUE_BACKEND_MPSC: lock-free multiple-producers / single-consumer list
+		 * LITM_QUEUE_BACKEND_SPSC: bounded single-producer / single-consumer rings
+		 * LITM_QUEUE_BACKEND_MPMC: bounded multiple-producers / multiple-consumers arrays
+		 */
+		typedef enum _litm_queue_backends {
+			LITM_QUEUE_BACKEND_DEFAULT = 0,
+			LITM_QUEUE_BACKEND_LIST,
+			LITM_QUEUE_BACKEND_MPSC,
+			LITM_QUEUE_BACKEND_SPSC,
+			LITM_QUEUE_BACKEND_MPMC,
+
+			LITM_QUEUE_BACKEND_MAX
+		} litm_queue_backend;
+
+		/**
+		 * Queue roles
+		 *
+		 * LITM_QUEUE_ROLE_SWITCH:     the switch's queue, fed by all the connections
+		 * LITM_QUEUE_ROLE_CONNECTION: a connection's input queue, fed by the switch
+		 */
+		typedef enum _litm_queue_roles {
+			LITM_QUEUE_ROLE_SWITCH = 0,
+			LITM_QUEUE_ROLE_CONNECTION,
+
+			LITM_QUEUE_ROLE_MAX
+		} litm_queue_role;
+
 		/**
 		 * Queue - thread-safe
 		 *
-		 * @param mutex: mutex
-		 * @param cond:  the condition variable
-		 * @param head:  pointer to ``head``
-		 * @param tail:  pointer to ``tail``
+		 * @param ops:     the backend's operations (@see queue.h)
+		 * @param impl:    the backend's private state
+		 * @param waiting: number of consumers sleeping (lock-free backends)
+		 * @param mutex:   mutex
+		 * @param cond:    the condition variable
+		 * @param head:    pointer to ``head``, per priority lane (list backend)
+		 * @param tail:    pointer to ``tail``, per priority lane (list backend)
+		 * @param skipped: number of times a non-empty lane was passed over
 		 */
 		typedef struct {
+			const struct _queue_ops *ops;
+			void *impl;
+			int waiting;
 			pthread_cond_t  *cond;
 			pthread_mutex_t *mutex;
-			struct _queue_node *head, *tail;
+			struct _queue_node *head[LITM_PRIORITY_LEVELS], *tail[LITM_PRIORITY_LEVELS];
+			int skipped[LITM_PRIORITY_LEVELS];
 			int num;
 			int id;
 			int total_in;
@@ -274,11 +368,75 @@
 		} queue;
 
 
+		/**
+		 * Set of message ``types``
+		 *
+		 * Compact bitset covering the types [0, LITM_TYPE_SET_MAX).
+		 *  Use the litm_type_set_* functions to manipulate it.
+		 */
+		typedef struct {
+			unsigned int bits[LITM_TYPE_SET_MAX / 32];
+		} litm_type_set;
+
 		/**
 		 * ``Bus`` identifier type
 		 */
 		typedef int litm_bus;
 
+		/**
+		 * Set of ``busses``: bit ``bus_id`` set for each
+		 *  member (@see LITM_BUS_SET)
+		 */
+		typedef unsigned int litm_bus_set;
+
+#		define LITM_BUS_SET(bus_id) (1U << (bus_id))
+
+		/**
+		 * ``Topic`` handle type
+		 *
+		 * @see litm_topic_register
+		 */
+		typedef int litm_topic;
+
+		/**
+		 * ``Bus`` delivery modes
+		 *
+		 * LITM_BUS_MODE_BROADCAST:              every subscriber, turn-wise (default)
+		 * LITM_BUS_MODE_WORK_ROUND_ROBIN:       a single subscriber, picked in turn
+		 * LITM_BUS_MODE_WORK_SHORTEST_QUEUE:    a single subscriber, the one with the shortest input queue
+		 * LITM_BUS_MODE_WORK_LEAST_IN_FLIGHT:   a single subscriber, the one holding the fewest unreleased envelopes
+		 * LITM_BUS_MODE_PARTITIONED:            a single subscriber, picked by consistent hashing of the message ``key``
+		 * LITM_BUS_MODE_CONFLATING:             every subscriber, turn-wise, but a newer message with the same ``key``
+		 *                                       supersedes one that is still waiting for its turn
+		 *                                       (litm_send messages all carry the key 0: they collapse
+		 *                                       into a single slot, use litm_send_keyed)
+		 */
+		typedef enum _litm_bus_modes {
+			LITM_BUS_MODE_BROADCAST = 0,
+			LITM_BUS_MODE_WORK_ROUND_ROBIN,
+			LITM_BUS_MODE_WORK_SHORTEST_QUEUE,
+			LITM_BUS_MODE_WORK_LEAST_IN_FLIGHT,
+			LITM_BUS_MODE_PARTITIONED,
+			LITM_BUS_MODE_CONFLATING,
+
+			LITM_BUS_MODE_MAX
+		} litm_bus_mode;
+
+		/**
+		 * ``Bus`` replay modes
+		 *
+		 * LITM_REPLAY_NONE:          no replay (default)
+		 * LITM_REPLAY_LAST_N:        the last N messages
+		 * LITM_REPLAY_LAST_PER_TYPE: the last message of each ``type``, up to N types
+		 */
+		typedef enum _litm_replay_modes {
+			LITM_REPLAY_NONE = 0,
+			LITM_REPLAY_LAST_N,
+			LITM_REPLAY_LAST_PER_TYPE,
+
+			LITM_REPLAY_MAX
+		} litm_replay_mode;
+
 		/**
 		 * ``Connection Status`` type
 		 */
@@ -292,14 +450,19 @@
 		 * ``Connection`` type
 		 *
 		 * @param input_queue the connection's input queue
+		 * @param in_flight   envelopes delivered to the connection but not yet released
+		 * @param index       the connection's slot in the connections table
 		 */
 		typedef struct _litm_connection {
 			int received;
 			int released;
 			int sent;
+			int in_flight;
 			int id;
+			int index;
 			litm_connection_status status;
 			queue *input_queue;
+			void *slab;
 		} litm_connection;
 
 		//typedef _litm_connection litm_connection;
@@ -308,9 +471,14 @@
 		 * Envelope Routing
 		 *
 		 * @param pending Pending Status Flag
-		 * @param bus_id  Destination ``bus``
+		 * @param bus_id  Destination ``bus``, 0 for a direct send (@see litm_send_to)
 		 * @param sender  The sender's connection pointer
 		 * @param current The index of the current recipient in the subscriber's list
+		 * @param key     The partitioning / conflation key (@see litm_send_keyed)
+		 * @param slot    The conflation slot, -1 if none (@see LITM_BUS_MODE_CONFLATING)
+		 * @param target  The single recipient of the envelope, NULL for the bus' subscribers
+		 * @param bus_set The destination ``busses`` of a multi-bus envelope, 0 otherwise;
+		 *                ``current`` then encodes both the bus and the index
 		 */
 		typedef struct {
 			int				 pending;
@@ -318,8 +486,29 @@
 			litm_connection *sender;
 			int 			current;
 			litm_connection *current_conn;
+			unsigned int     key;
+			int              slot;
+			litm_connection *target;
+			litm_bus_set     bus_set;
 		} __litm_routing;
 
+		/**
+		 * Shared message payload
+		 *
+		 * A message referenced by more than one envelope (or by
+		 *  a replay cache): the ``cleaner`` runs once the last
+		 *  reference is dropped.
+		 *
+		 * @param refs    reference count
+		 * @param msg     the message
+		 * @param cleaner the message's cleaner, free() if NULL
+		 */
+		typedef struct _litm_payload {
+			int refs;
+			void *msg;
+			void (*cleaner)(void *msg);
+		} litm_payload;
+
 
 
 
@@ -350,16 +539,290 @@
 			LITM_CODE_ERROR_CONNECTION_ERROR,
 			LITM_CODE_ERROR_SUBSCRIPTION_ERROR,
 			LITM_CODE_ERROR_SEND_ERROR,
-			LITM_CODE_ERROR_RECEIVE_WAIT
+			LITM_CODE_ERROR_RECEIVE_WAIT,
+			LITM_CODE_ERROR_INVALID_MODE,
+			LITM_CODE_ERROR_INVALID_TYPE,
+			LITM_CODE_ERROR_INVALID_TOPIC,
+			LITM_CODE_ERROR_NO_MORE_TOPICS,
+			LITM_CODE_ERROR_INVALID_PRIORITY,
+			LITM_CODE_ERROR_INVALID_BACKEND,
+			LITM_CODE_ERROR_INVALID_TTL,
+			LITM_CODE_ERROR_REQUEST_EXPIRED,
+			LITM_CODE_ERROR_INVALID_TARGET,
+			LITM_CODE_ERROR_NOT_SUPPORTED,
+			LITM_CODE_ERROR_IO
 
 		} litm_code;
 
 
+		/**
+		 * Completion ``token`` of a tracked message
+		 *
+		 * @param state     0 whilst the message is in flight, 1 once finalized (futex word)
+		 * @param waiters   number of threads blocked on ``state``
+		 * @param refs      held by the sender and by the envelope
+		 * @param delivered number of deliveries to subscribers
+		 * @param released  number of releases by subscribers
+		 *
+		 * Tokens are pooled: use the litm_token_* functions only.
+		 */
+		typedef struct _litm_token {
+
+			volatile int state;
+			volatile int waiters;
+			int refs;
+			int delivered;
+			int released;
+
+		} litm_token;
+
+
+		/**
+		 * Subsystems accounting for the library's heap allocations
+		 *
+		 * LITM_ALLOC_QUEUE:      queue structures, rings & cells
+		 * LITM_ALLOC_QUEUE_NODE: list & MPSC queue nodes, one per queued item
+		 * LITM_ALLOC_ENVELOPE:   envelopes (recycled through the pool)
+		 * LITM_ALLOC_PAYLOAD:    shared payloads (replay caches)
+		 * LITM_ALLOC_TOKEN:      completion tokens (recycled)
+		 * LITM_ALLOC_CONNECTION: connections
+		 * LITM_ALLOC_SLAB:       message slabs (litm_msg_alloc)
+		 * LITM_ALLOC_SWITCH:     bus tables, replay caches, topics
+		 * LITM_ALLOC_DEBUG:      _DEBUG build timestamps
+		 * LITM_ALLOC_FLIGHT:     flight recorder rings, one per thread
+		 * LITM_ALLOC_TRAFFIC:    traffic matrix tables, one per thread
+		 */
+		typedef enum _litm_alloc_classes {
+
+			LITM_ALLOC_QUEUE = 0,
+			LITM_ALLOC_QUEUE_NODE,
+			LITM_ALLOC_ENVELOPE,
+			LITM_ALLOC_PAYLOAD,
+			LITM_ALLOC_TOKEN,
+			LITM_ALLOC_CONNECTION,
+			LITM_ALLOC_SLAB,
+			LITM_ALLOC_SWITCH,
+			LITM_ALLOC_DEBUG,
+			LITM_ALLOC_FLIGHT,
+			LITM_ALLOC_TRAFFIC,
+
+			LITM_ALLOC_CLASSES
+
+		} litm_alloc_class;
+
+		/**
+		 * Allocation counters of a subsystem
+		 *
+		 * @param allocs     heap allocations
+		 * @param frees      heap releases
+		 * @param live_bytes bytes currently allocated
+		 * @param peak_bytes highest ``live_bytes`` reached
+		 */
+		typedef struct {
+			long allocs;
+			long frees;
+			long live_bytes;
+			long peak_bytes;
+		} litm_alloc_counters;
+
+		/**
+		 * Allocation statistics, indexed by litm_alloc_class
+		 */
+		typedef struct {
+			litm_alloc_counters classes[LITM_ALLOC_CLASSES];
+		} litm_alloc_stats;
+
+
+		/**
+		 * The library's locks, as profiled by the LITM_LOCK_PROFILE build
+		 *
+		 * LITM_LOCK_SWITCH_QUEUE:      the switch's queue mutex
+		 * LITM_LOCK_CONNECTION_QUEUE:  the connections' input queue mutexes, together
+		 * LITM_LOCK_POOL:              the envelope pool
+		 * LITM_LOCK_TOKENS:            the completion token stack
+		 * LITM_LOCK_CONNECTIONS:       the connections table
+		 * LITM_LOCK_PENDING_DELETION:  the connections pending deletion
+		 * LITM_LOCK_SUBSCRIBERS:       the subscriptions & busses configuration
+		 * LITM_LOCK_REPLAY:            the replay caches
+		 * LITM_LOCK_TOPICS:            the topics tree
+		 * LITM_LOCK_WATCHDOG:          the watchdog's statistics
+		 */
+		typedef enum _litm_locks {
+
+			LITM_LOCK_SWITCH_QUEUE = 0,
+			LITM_LOCK_CONNECTION_QUEUE,
+			LITM_LOCK_POOL,
+			LITM_LOCK_TOKENS,
+			LITM_LOCK_CONNECTIONS,
+			LITM_LOCK_PENDING_DELETION,
+			LITM_LOCK_SUBSCRIBERS,
+			LITM_LOCK_REPLAY,
+			LITM_LOCK_TOPICS,
+			LITM_LOCK_WATCHDOG,
+
+			LITM_LOCKS
+
+		} litm_lock;
+
+		#define LITM_LOCK_HIST_BUCKETS 40 // bucket i: [2^i, 2^(i+1)) ns
+
+		/**
+		 * Contention statistics of a lock
+		 *
+		 * @param acquisitions     successful lock & trylock calls
+		 * @param contended        lock calls which had to wait
+		 * @param trylock_failures trylock calls returning EBUSY
+		 * @param wait_ns          total time waited by the contended lock calls
+		 * @param hold_ns          total time held
+		 * @param max_wait_ns      longest wait
+		 * @param max_hold_ns      longest hold
+		 * @param wait_hist        log2 histogram of the waits (contended calls only)
+		 * @param hold_hist        log2 histogram of the hold times
+		 *
+		 * A condition wait ends a hold and the wake-up starts another.
+		 */
+		typedef struct {
+			long acquisitions;
+			long contended;
+			long trylock_failures;
+			unsigned long long wait_ns;
+			unsigned long long hold_ns;
+			unsigned long long max_wait_ns;
+			unsigned long long max_hold_ns;
+			long wait_hist[LITM_LOCK_HIST_BUCKETS];
+			long hold_hist[LITM_LOCK_HIST_BUCKETS];
+		} litm_lock_counters;
+
+		/**
+		 * Lock statistics, indexed by litm_lock
+		 */
+		typedef struct {
+			litm_lock_counters locks[LITM_LOCKS];
+		} litm_lock_stats;
+
+
+		/**
+		 * Flight recorder event codes
+		 *
+		 * LITM_FLIGHT_SEND:      a litm_send* call created the envelope
+		 * LITM_FLIGHT_SEND_FAILED: refused by the switch's queue
+		 * LITM_FLIGHT_DISPATCH:  the switch dequeued it to find its next recipient
+		 * LITM_FLIGHT_DELIVER:   handed to the input queue of ``conn``
+		 * LITM_FLIGHT_BUSY:      ... which was full: requeued
+		 * LITM_FLIGHT_INACTIVE:  ... whose connection is going away: requeued
+		 * LITM_FLIGHT_RECEIVE:   ``conn`` received it
+		 * LITM_FLIGHT_RELEASE:   ``conn`` released it
+		 * LITM_FLIGHT_EXPIRE:    dropped past its deadline
+		 * LITM_FLIGHT_FINALIZE:  all done, the message was disposed of
+		 * LITM_FLIGHT_RECLAIM:   taken back from ``conn`` past the release timeout
+		 */
+		typedef enum _litm_flight_codes {
+
+			LITM_FLIGHT_NONE = 0,
+			LITM_FLIGHT_SEND,
+			LITM_FLIGHT_SEND_FAILED,
+			LITM_FLIGHT_DISPATCH,
+			LITM_FLIGHT_DELIVER,
+			LITM_FLIGHT_BUSY,
+			LITM_FLIGHT_INACTIVE,
+			LITM_FLIGHT_RECEIVE,
+			LITM_FLIGHT_RELEASE,
+			LITM_FLIGHT_EXPIRE,
+			LITM_FLIGHT_FINALIZE,
+			LITM_FLIGHT_RECLAIM,
+
+			LITM_FLIGHT_CODES
+
+		} litm_flight_code;
+
+		/**
+		 * Flight recorder event, 16 bytes
+		 *
+		 * @param ts       monotonic time in ns
+		 * @param envelope the envelope's id (@see litm_envelope)
+		 * @param conn     the connection's index, 0 if none
+		 * @param code     a litm_flight_code
+		 * @param ring     the index of the recording thread's ring
+		 */
+		typedef struct {
+			unsigned long long ts;
+			unsigned int envelope;
+			short conn;
+			unsigned char code;
+			unsigned char ring;
+		} litm_flight_event;
+
+		#define LITM_FLIGHT_MAGIC      "LITMFR01"
+		#define LITM_FLIGHT_RING_SIZE  4096
+		#define LITM_FLIGHT_RINGS_MAX  64
+
+		/**
+		 * Flight recorder dump file
+		 *
+		 * The header is followed with ``connections`` pairs of int
+		 *  (connection index, connection id) then, for each of the
+		 *  ``rings``, a pair of int (ring index, event count) and
+		 *  its events, oldest first.
+		 */
+		typedef struct {
+			char magic[8];
+			int rings;
+			int connections;
+		} litm_flight_header;
+
+
+		/**
+		 * Envelope timestamps, monotonic time in ns
+		 *
+		 * @param sent       the envelope was created by a litm_send* call
+		 * @param dispatched the switch dequeued it to look for its next recipient
+		 * @param delivered  the switch queued it to the recipient's input queue
+		 * @param received   the recipient got it from a litm_receive* call
+		 *
+		 * Only taken when enabled (@see litm_set_timestamps) at the
+		 *  time the message is sent: all fields are 0 otherwise.
+		 *  With several recipients, the last 3 stamps relate to the
+		 *  current one.
+		 */
+		typedef struct {
+			unsigned long long sent;
+			unsigned long long dispatched;
+			unsigned long long delivered;
+			unsigned long long received;
+		} litm_timestamps;
+
+
+		/**
+		 * Delivery state of an envelope, when the watchdog is on
+		 *
+		 * LITM_HELD_NONE:      not with a subscriber (or not tracked)
+		 * LITM_HELD_BY_CLIENT: delivered, not yet released
+		 * LITM_HELD_RECLAIMED: taken back by the watchdog: the
+		 *                      holder's release only finalizes it
+		 */
+		typedef enum _litm_held_states {
+
+			LITM_HELD_NONE = 0,
+			LITM_HELD_BY_CLIENT,
+			LITM_HELD_RECLAIMED
+
+		} litm_held_state;
+
+
 		/**
 		 * ``Envelope`` structure for messages
 		 *
-		 * @param cleaner The ``cleaner`` function to use
-		 * @param routes  The ``routing`` structure
+		 * @param cleaner  The ``cleaner`` function to use
+		 * @param priority The message priority (@see _litm_priorities)
+		 * @param deadline Monotonic time (ns) after which the message is dropped, 0 for none
+		 * @param payload  The shared payload holding ``msg`` if any, the ``cleaner`` is then unused
+		 * @param token    The completion token resolved on finalization, if any
+		 * @param correlation The request's correlation id, 0 if not part of a request / reply
+		 * @param stamps   The timestamps of the envelope's journey, if enabled
+		 * @param id       The message's serial number, for the flight recorder
+		 * @param held     The watchdog's view of the delivery (@see litm_held_state)
+		 * @param watch    The envelope's entry in the watchdog, -1 if none
+		 * @param routes   The ``routing`` structure
 		 * @param msg     The pointer to the message
 		 *
 		 * Contains the pointer to the message
@@ -377,15 +840,125 @@
 
 			DEBUG_PARAM(struct timeval *sent_time);
 			int type;
+			int priority;
+			unsigned long long deadline;
 			int requeued;
 			int released_count;
 			int delivery_count;
 			void (*cleaner)(void *msg);
 			__litm_routing routes;
+			litm_payload *payload;
+			litm_token *token;
+			unsigned int correlation;
+			litm_timestamps stamps;
+			unsigned int id;
+			volatile int held;
+			int watch;
 			void *msg;
 
 		} litm_envelope;
 
+		/**
+		 * Switch statistics
+		 *
+		 * @param dequeued  envelopes dequeued by the switch (incl. requeues & releases)
+		 * @param delivered deliveries to a subscriber's input queue
+		 * @param waited    number of times the switch went to sleep
+		 * @param pending   deliveries retried from the ``pending`` state
+		 * @param busy      deliveries deferred because of a full/busy input queue
+		 * @param expired   envelopes dropped past their deadline
+		 * @param conflated envelopes superseded by a newer one (conflating busses)
+		 */
+		typedef struct {
+			long dequeued;
+			long delivered;
+			long waited;
+			long pending;
+			long busy;
+			long expired;
+			long conflated;
+		} litm_switch_stats;
+
+		#define LITM_TRAFFIC_ENTRIES_MAX  256
+
+		/**
+		 * Traffic matrix entry
+		 *
+		 * @param sender     the sender's connection id
+		 * @param bus_id     the bus: 0 for direct sends, LITM_BUSSES_MAX + 1 + topic
+		 *                   for topics, the first bus of a multi-bus send
+		 * @param type       the message type
+		 * @param messages   messages sent
+		 * @param bytes      bytes sent, only known for the litm_msg_alloc messages
+		 *                   (rounded up to their size class)
+		 * @param dispatches turns of the switch on the messages, one per recipient
+		 *                   and per release
+		 * @param switch_ns  time spent by the switch on these turns
+		 *
+		 * The counts are estimates: each sample weighs the sampling rate.
+		 */
+		typedef struct {
+			int sender;
+			litm_bus bus_id;
+			int type;
+			long messages;
+			long bytes;
+			long dispatches;
+			unsigned long long switch_ns;
+		} litm_traffic_entry;
+
+		/**
+		 * Traffic matrix
+		 *
+		 * @param sampling the sampling rate, 1 message out of ``sampling``
+		 * @param dropped  messages & dispatches left out: no room in a thread's table or here
+		 * @param count    entries in use, by decreasing switch time
+		 */
+		typedef struct {
+			int sampling;
+			long dropped;
+			int count;
+			litm_traffic_entry entries[LITM_TRAFFIC_ENTRIES_MAX];
+		} litm_traffic_matrix;
+
+
+		// interval between two checks of the watchdog
+		#define LITM_WATCHDOG_PERIOD_USECS  10000
+
+		/**
+		 * Watchdog view of a holder
+		 *
+		 * @param id        the connection's id
+		 * @param stuck     envelopes it holds past the threshold
+		 * @param oldest_ns for how long it holds the oldest
+		 */
+		typedef struct {
+			int id;
+			int stuck;
+			unsigned long long oldest_ns;
+		} litm_watchdog_holder;
+
+		/**
+		 * Watchdog statistics
+		 *
+		 * @param in_flight  deliveries not yet released
+		 * @param stuck      ... of which past the threshold
+		 * @param oldest_ns  age of the oldest delivery not yet released
+		 * @param reported   deliveries which went past the threshold, in total
+		 * @param reclaimed  envelopes taken back past the release timeout of their bus, in total
+		 * @param holders    per connection slot, valid where ``stuck`` isn't 0
+		 *
+		 * All but the totals are as of the last check.
+		 */
+		typedef struct {
+			long in_flight;
+			long stuck;
+			unsigned long long oldest_ns;
+			long reported;
+			long reclaimed;
+			litm_watchdog_holder holders[LITM_CONNECTION_MAX+1];
+		} litm_watchdog_stats;
+
 
 	#ifdef __cplusplus
 		extern "C" {
@@ -460,6 +1033,101 @@
 		litm_code litm_subscribe(litm_connection *conn, litm_bus bus_id);
 
 
+		/**
+		 * Subscribe to a ``bus`` but only for some message ``types``
+		 *
+		 * @see litm_subscribe
+		 *
+		 * @param *conn connection reference
+		 * @param bus_id the ``bus`` identifier to subscribe to
+		 * @param *type_set the set of message types to receive (NULL: all)
+		 *
+		 * The switch skips the subscriber for any message whose
+		 *  type isn't in ``type_set``: such messages are never
+		 *  delivered to the connection.  The reserved types
+		 *  LITM_MESSAGE_TYPE_SHUTDOWN and LITM_MESSAGE_TYPE_TIMER
+		 *  are always delivered.
+		 *
+		 * If the connection is already subscribed to the ``bus``,
+		 *  its filter is replaced: a NULL ``type_set`` removes it.
+		 */
+		litm_code litm_subscribe_filtered(litm_connection *conn, litm_bus bus_id, const litm_type_set *type_set);
+
+
+		/**
+		 * Clears a set of message ``types``
+		 */
+		void litm_type_set_clear(litm_type_set *set);
+
+		/**
+		 * Adds a message ``type`` to a set
+		 *
+		 * @return LITM_CODE_ERROR_INVALID_TYPE if type isn't in [0, LITM_TYPE_SET_MAX)
+		 */
+		litm_code litm_type_set_add(litm_type_set *set, int type);
+
+		/**
+		 * Removes a message ``type`` from a set
+		 *
+		 * @return LITM_CODE_ERROR_INVALID_TYPE if type isn't in [0, LITM_TYPE_SET_MAX)
+		 */
+		litm_code litm_type_set_remove(litm_type_set *set, int type);
+
+		/**
+		 * Verifies if a message ``type`` is part of a set
+		 *
+		 * @return 1 if present, 0 otherwise
+		 */
+		int litm_type_set_has(const litm_type_set *set, int type);
+
+
+		/**
+		 * Registers a ``topic`` and returns its handle
+		 *
+		 * Topic names are hierarchical: levels are separated by a
+		 *  dot e.g. ``orders.eu.fills``.  Registering an already
+		 *  registered topic returns the same handle.
+		 *
+		 * The subscription patterns are resolved against the topic
+		 *  at registration time: sending on the topic handle involves
+		 *  no string matching.
+		 *
+		 * @param *name the topic name
+		 * @param *topic pointer to receive the topic handle
+		 *
+		 * @return LITM_CODE_ERROR_INVALID_TOPIC
+		 * @return LITM_CODE_ERROR_NO_MORE_TOPICS
+		 */
+		litm_code litm_topic_register(const char *name, litm_topic *topic);
+
+		/**
+		 * Subscribe to all the ``topics`` matching a pattern
+		 *
+		 * A pattern is a topic name in which:
+		 *  - a level ``*`` matches exactly one level
+		 *  - a level ``#`` matches zero or more levels
+		 *
+		 * e.g. ``orders.*.fills``, ``orders.#``
+		 *
+		 * The pattern applies to the topics already registered
+		 *  as well as those registered afterwards.
+		 *
+		 * @param *conn connection reference
+		 * @param *pattern subscription pattern
+		 */
+		litm_code litm_subscribe_topic(litm_connection *conn, const char *pattern);
+
+		/**
+		 * Unsubscribe from a ``topic`` pattern
+		 *
+		 * @see litm_subscribe_topic
+		 *
+		 * @param *conn connection reference
+		 * @param *pattern the pattern used to subscribe
+		 */
+		litm_code litm_unsubscribe_topic(litm_connection *conn, const char *pattern);
+
+
 		/**
 		 * Unsubscribe from a ``bus``
 		 *
@@ -471,6 +1139,114 @@
 		litm_code litm_unsubscribe(litm_connection *conn, litm_bus bus_id);
 
 
+		/**
+		 * Sets the delivery mode of a ``bus``
+		 *
+		 * By default, a ``bus`` is in LITM_BUS_MODE_BROADCAST mode
+		 *  i.e. each message is presented, turn-wise, to every subscriber.
+		 *
+		 * In one of the ``work-queue`` modes, each message is delivered
+		 *  to exactly one subscriber (other than the sender) and the
+		 *  message is finalized as soon as that subscriber releases it.
+		 *
+		 * In LITM_BUS_MODE_CONFLATING mode, messages are conflated per
+		 *  key (@see litm_send_keyed): those sent through litm_send
+		 *  share the key 0 and thus a single slot.
+		 *
+		 * @param bus_id the ``bus`` identifier
+		 * @param mode   the delivery mode
+		 *
+		 * @return LITM_CODE_ERROR_INVALID_BUS
+		 * @return LITM_CODE_ERROR_INVALID_MODE
+		 */
+		litm_code litm_bus_set_mode(litm_bus bus_id, litm_bus_mode mode);
+
+
+		/**
+		 * Sets the release timeout of a ``bus``
+		 *
+		 * A subscriber holding a message of the bus for longer
+		 *  has it taken back: the message goes on to the next
+		 *  subscriber as if released (on the busses with a single
+		 *  recipient per message, it is then done with).  The
+		 *  holder can still use the message until it releases it.
+		 *
+		 * The timeout is enforced by the watchdog, every
+		 *  LITM_WATCHDOG_PERIOD_USECS or so.
+		 *
+		 * @param bus_id the ``bus`` identifier
+		 * @param usecs  the timeout, 0 for none (default)
+		 *
+		 * @return LITM_CODE_ERROR_INVALID_BUS
+		 */
+		litm_code litm_bus_set_release_timeout(litm_bus bus_id, int usecs);
+
+
+		/**
+		 * Sets the release timeout of a ``topic``
+		 *
+		 * Same as litm_bus_set_release_timeout for the messages
+		 *  sent on a topic (@see litm_send_topic).
+		 *
+		 * @param topic the topic, from litm_topic_register
+		 * @param usecs the timeout, 0 for none (default)
+		 *
+		 * @return LITM_CODE_ERROR_INVALID_TOPIC
+		 */
+		litm_code litm_topic_set_release_timeout(litm_topic topic, int usecs);
+
+
+		/**
+		 * Configures the replay cache of a ``bus``
+		 *
+		 * The switch keeps the most recent messages of the ``bus``
+		 *  alive (the ``cleaner`` is deferred) and a connection
+		 *  subscribing to the ``bus`` is presented with them right
+		 *  away, oldest first, ahead of the messages sent afterwards.
+		 *  A message still on its way to the subscribers reaches the
+		 *  new one once: on its way if it still can, from the cache
+		 *  otherwise.
+		 *  A subscriber is never presented with its own messages and
+		 *  the type filters apply.
+		 *
+		 * On such a ``bus``, the subscription takes effect once the
+		 *  switch gets to it, in order with the messages sent before.
+		 *
+		 * Disabling the cache (LITM_REPLAY_NONE) releases the messages
+		 *  it holds: the corresponding ``cleaners`` might then run in
+		 *  the calling thread.
+		 *
+		 * @param bus_id the ``bus`` identifier
+		 * @param mode   one of LITM_REPLAY_*
+		 * @param depth  number of messages (or types) kept, up to LITM_REPLAY_DEPTH_MAX
+		 *
+		 * @return LITM_CODE_ERROR_INVALID_BUS
+		 * @return LITM_CODE_ERROR_INVALID_MODE for an invalid mode or depth
+		 */
+		litm_code litm_bus_set_replay(litm_bus bus_id, litm_replay_mode mode, int depth);
+
+
+		/**
+		 * Selects the queue backend for a role
+		 *
+		 * @param role    one of LITM_QUEUE_ROLE_*
+		 * @param backend one of LITM_QUEUE_BACKEND_*
+		 *
+		 * Only the queues created afterwards are affected: the switch's
+		 *  queue is created on the first connection.  Without a call to
+		 *  this function, the environment variables LITM_SWITCH_QUEUE
+		 *  and LITM_CONNECTION_QUEUE (``list``, ``mpsc``, ``spsc`` or ``mpmc``)
+		 *  are consulted; the defaults are ``list`` for the switch and
+		 *  ``spsc`` for the connections.
+		 *
+		 * The switch's queue has many producers and requeues into
+		 *  itself: only the unbounded LIST and MPSC backends are accepted.
+		 *
+		 * @return LITM_CODE_ERROR_INVALID_BACKEND
+		 */
+		litm_code litm_set_queue_backend(litm_queue_role role, litm_queue_backend backend);
+
+
 		/**
 		 * Send message on a ``bus``
 		 *
@@ -502,6 +1278,321 @@
 
 
 
+		/**
+		 * Send message on a ``bus`` with a given priority
+		 *
+		 * @see litm_send
+		 *
+		 * @param *conn connection reference
+		 * @param bus_id the ``bus`` to send the message onto
+		 * @param *msg the pointer to the message
+		 * @param *cleaner the pointer to the cleaner function
+		 * @param type message type
+		 * @param priority one of LITM_PRIORITY_*
+		 *
+		 * Messages sent through litm_send have the priority
+		 *  LITM_PRIORITY_NORMAL.  Higher priority messages overtake
+		 *  lower priority ones in the switch and in the recipients'
+		 *  input queues; messages of the same priority are never
+		 *  reordered.
+		 *
+		 * @return LITM_CODE_ERROR_INVALID_PRIORITY
+		 */
+		litm_code litm_send_priority(	litm_connection *conn,
+										litm_bus bus_id,
+										void *msg,
+										void (*cleaner)(void *msg),
+										int type,
+										int priority
+										);
+
+
+		/**
+		 * Send a ``keyed`` message on a ``bus``
+		 *
+		 * @see litm_send
+		 *
+		 * @param *conn connection reference
+		 * @param bus_id the ``bus`` to send the message onto
+		 * @param key the partitioning key
+		 * @param *msg the pointer to the message
+		 * @param *cleaner the pointer to the cleaner function
+		 * @param type message type
+		 *
+		 * On a LITM_BUS_MODE_PARTITIONED ``bus``, all messages
+		 *  with the same ``key`` are delivered to the same subscriber
+		 *  and thus are processed in order.  Subscribing or unsubscribing
+		 *  only remaps a small fraction of the keys.
+		 *
+		 * On a LITM_BUS_MODE_CONFLATING ``bus``, a single message per
+		 *  ``key`` makes its way through the subscribers; of the messages
+		 *  sent in the meantime, only the newest is kept (the ``cleaner``
+		 *  of the others runs) and it follows once the first is finalized.
+		 *  The backlog is thus bounded by the number of keys, up to
+		 *  LITM_CONFLATION_KEYS per ``bus``.
+		 *
+		 * Messages sent through litm_send carry the key 0: on a
+		 *  LITM_BUS_MODE_CONFLATING ``bus``, they all supersede
+		 *  one another.
+		 * On other ``bus`` modes, the key is ignored.
+		 */
+		litm_code litm_send_keyed(	litm_connection *conn,
+									litm_bus bus_id,
+									unsigned int key,
+									void *msg,
+									void (*cleaner)(void *msg),
+									int type
+									);
+
+
+		/**
+		 * Send a message with a time-to-live on a ``bus``
+		 *
+		 * @see litm_send
+		 *
+		 * @param *conn connection reference
+		 * @param bus_id the ``bus`` to send the message onto
+		 * @param *msg the pointer to the message
+		 * @param *cleaner the pointer to the cleaner function
+		 * @param type message type
+		 * @param ttl_usec time-to-live in microseconds
+		 *
+		 * Once its deadline has passed, the message is no longer
+		 *  delivered: the switch drops it (and the ``cleaner`` runs)
+		 *  and the receive functions skip it.  Subscribers which
+		 *  already received the message are unaffected.
+		 *
+		 * @return LITM_CODE_ERROR_INVALID_TTL
+		 */
+		litm_code litm_send_ttl(	litm_connection *conn,
+									litm_bus bus_id,
+									void *msg,
+									void (*cleaner)(void *msg),
+									int type,
+									int ttl_usec
+									);
+
+
+		/**
+		 * Send a message on a ``bus`` and track its completion
+		 *
+		 * @see litm_send
+		 *
+		 * @param *conn connection reference
+		 * @param bus_id the ``bus`` to send the message onto
+		 * @param *msg the pointer to the message
+		 * @param *cleaner the pointer to the cleaner function
+		 * @param type message type
+		 * @param **token pointer to receive the completion token
+		 *
+		 * The ``token`` resolves once the switch has finalized the
+		 *  message ie. all its recipients released it (or it expired,
+		 *  was superseded, ...).  It is waited on with litm_token_wait
+		 *  or polled with litm_token_poll and must be given back
+		 *  through litm_token_release.
+		 *
+		 * On failure, no token is returned.
+		 */
+		litm_code litm_send_tracked(	litm_connection *conn,
+										litm_bus bus_id,
+										void *msg,
+										void (*cleaner)(void *msg),
+										int type,
+										litm_token **token
+										);
+
+		/**
+		 * Allocates memory for a message
+		 *
+		 * @param *conn connection reference
+		 * @param size  the message size in bytes
+		 *
+		 * The memory comes from size-classed pools owned by the
+		 *  connection: sent with a NULL ``cleaner`` from the same
+		 *  connection, the message is returned to its pool once
+		 *  finalized, whichever thread finalizes it.  Any other use
+		 *  requires litm_msg_free as ``cleaner``.
+		 *
+		 * Must be called from the connection's thread.
+		 *
+		 * @return NULL on malloc error or if ``size`` exceeds LITM_MSG_SIZE_MAX
+		 */
+		void *litm_msg_alloc(litm_connection *conn, size_t size);
+
+		/**
+		 * Returns a message from litm_msg_alloc to its pool
+		 *
+		 * Usable as a ``cleaner``, from any thread.
+		 */
+		void litm_msg_free(void *msg);
+
+
+		/**
+		 * Send a message on several ``busses`` at once
+		 *
+		 * @see litm_send
+		 *
+		 * @param *conn connection reference
+		 * @param bus_set the ``busses`` to send the message onto (@see LITM_BUS_SET)
+		 * @param *msg the pointer to the message
+		 * @param *cleaner the pointer to the cleaner function
+		 * @param type message type
+		 *
+		 * A single envelope makes its way through the subscribers of
+		 *  all the ``busses``: a connection subscribed to more than one
+		 *  of them receives the message once and the ``cleaner`` runs
+		 *  once, after the last release.
+		 *
+		 * All the busses must be in LITM_BUS_MODE_BROADCAST.
+		 *
+		 * @return LITM_CODE_ERROR_INVALID_BUS for an empty set or an invalid bus
+		 * @return LITM_CODE_ERROR_INVALID_MODE if a bus isn't a broadcast one
+		 */
+		litm_code litm_send_multi(	litm_connection *conn,
+									litm_bus_set bus_set,
+									void *msg,
+									void (*cleaner)(void *msg),
+									int type
+									);
+
+		/**
+		 * Sends a message directly to a connection
+		 *
+		 * @see litm_send
+		 *
+		 * @param *conn connection reference
+		 * @param target_id the identifier of the recipient connection (@see litm_connect_ex)
+		 * @param *msg the pointer to the message
+		 * @param *cleaner the pointer to the cleaner function
+		 * @param type message type
+		 *
+		 * The message doesn't travel on any ``bus``: the switch hands
+		 *  it to the recipient regardless of its subscriptions (and
+		 *  type filters).  Should the recipient close its connection
+		 *  in the meantime, the message is dropped.
+		 *
+		 * @return LITM_CODE_ERROR_INVALID_TARGET if no active connection has ``target_id``
+		 */
+		litm_code litm_send_to(	litm_connection *conn,
+								int target_id,
+								void *msg,
+								void (*cleaner)(void *msg),
+								int type
+								);
+
+		/**
+		 * Sends a request on a ``bus`` and waits for the reply
+		 *
+		 * @see litm_send
+		 *
+		 * @param *conn connection reference
+		 * @param bus_id the ``bus`` to send the request onto
+		 * @param *msg the pointer to the request message
+		 * @param *cleaner the pointer to the cleaner function
+		 * @param type message type
+		 * @param usec_timer maximum wait in microseconds, negative for no limit
+		 * @param **reply pointer to receive the reply envelope
+		 *
+		 * The request is delivered like any message of the ``bus``;
+		 *  a recipient answers with litm_reply.  The reply is handed
+		 *  straight to the requester: it doesn't go through the
+		 *  connection's input queue nor any ``bus``.  Only the first
+		 *  reply is kept, the others are dropped.
+		 *
+		 * The reply envelope must be released (litm_release) as
+		 *  any received envelope.
+		 *
+		 * @return LITM_CODE_NO_MESSAGE if no reply came in time
+		 * @return LITM_CODE_BUSY if too many requests are pending
+		 */
+		litm_code litm_request(	litm_connection *conn,
+								litm_bus bus_id,
+								void *msg,
+								void (*cleaner)(void *msg),
+								int type,
+								int usec_timer,
+								litm_envelope **reply
+								);
+
+		/**
+		 * Answers a request
+		 *
+		 * @param *conn connection reference
+		 * @param *request the request envelope, not yet released
+		 * @param *msg the pointer to the reply message
+		 * @param *cleaner the pointer to the cleaner function
+		 * @param type message type
+		 *
+		 * @return LITM_CODE_ERROR_INVALID_ENVELOPE if ``request`` isn't a request
+		 * @return LITM_CODE_ERROR_REQUEST_EXPIRED if the requester stopped waiting
+		 *         or got a reply already: the ``cleaner`` has run
+		 */
+		litm_code litm_reply(	litm_connection *conn,
+								litm_envelope *request,
+								void *msg,
+								void (*cleaner)(void *msg),
+								int type
+								);
+
+		/**
+		 * Waits for a completion ``token`` to resolve
+		 *
+		 * @param *token the token from litm_send_tracked
+		 * @param usec_timer maximum wait in microseconds, negative for no limit
+		 *
+		 * @return LITM_CODE_OK once resolved
+		 * @return LITM_CODE_BUSY on timeout
+		 */
+		litm_code litm_token_wait(litm_token *token, int usec_timer);
+
+		/**
+		 * Verifies if a completion ``token`` is resolved
+		 *
+		 * @return LITM_CODE_OK once resolved
+		 * @return LITM_CODE_BUSY whilst the message is in flight
+		 */
+		litm_code litm_token_poll(litm_token *token);
+
+		/**
+		 * Retrieves the counts of a resolved ``token``
+		 *
+		 * @param *token the token
+		 * @param *delivered number of subscribers the message was delivered to
+		 * @param *released number of subscribers which released it
+		 *
+		 * @return LITM_CODE_BUSY if the token isn't resolved yet
+		 */
+		litm_code litm_token_get_counts(litm_token *token, int *delivered, int *released);
+
+		/**
+		 * Gives back a completion ``token``
+		 *
+		 * The token must not be used afterwards; it can be
+		 *  released before being resolved.
+		 */
+		void litm_token_release(litm_token *token);
+
+
+		/**
+		 * Send message on a ``topic``
+		 *
+		 * @see litm_send
+		 * @see litm_topic_register
+		 *
+		 * @param *conn connection reference
+		 * @param topic the ``topic`` handle
+		 * @param *msg the pointer to the message
+		 * @param *cleaner the pointer to the cleaner function
+		 * @param type message type
+		 */
+		litm_code litm_send_topic(	litm_connection *conn,
+									litm_topic topic,
+									void *msg,
+									void (*cleaner)(void *msg),
+									int type
+									);
+
+
 		/**
 		 * Receives (non-blocking) from any ``bus``
 		 *
@@ -569,6 +1660,191 @@
 		void *litm_get_message(litm_envelope *envlp, int *type);
 
 
+		/**
+		 * Retrieves a snapshot of the switch's statistics
+		 *
+		 * @param *stats the structure to fill
+		 *
+		 * The counters are maintained by the switch thread
+		 *  without locking: the snapshot is indicative.
+		 */
+		void litm_get_switch_stats(litm_switch_stats *stats);
+
+
+		/**
+		 * Sets the threshold of the watchdog
+		 *
+		 * The watchdog tracks the deliveries which aren't released
+		 *  yet: those held for longer than ``usecs`` are reported
+		 *  in the statistics and logged (once each) to syslog.
+		 *
+		 * The watchdog runs as long as a threshold or a release
+		 *  timeout (@see litm_bus_set_release_timeout) is set.
+		 *
+		 * @param usecs the threshold, 0 for none (default)
+		 */
+		void litm_watchdog_set(int usecs);
+
+
+		/**
+		 * Retrieves a snapshot of the watchdog's statistics
+		 *
+		 * @param *stats the structure to fill
+		 */
+		void litm_get_watchdog_stats(litm_watchdog_stats *stats);
+
+
+		/**
+		 * Sets the sampling rate of the traffic matrix
+		 *
+		 * Each sending thread counts, in a table of its own, one
+		 *  message out of ``rate`` per (sender, bus, type); the
+		 *  switch thread does likewise for the time it spends on
+		 *  the messages.  The tables aren't recycled: the threads
+		 *  past the first 64 to sample aren't counted.
+		 *
+		 * @param rate 1 for every message, 0 to stop sampling (default)
+		 */
+		void litm_traffic_set_sampling(int rate);
+
+
+		/**
+		 * Clears the traffic matrix
+		 *
+		 * Each thread clears its table on its next sample.
+		 */
+		void litm_traffic_reset(void);
+
+
+		/**
+		 * Retrieves a snapshot of the traffic matrix
+		 *
+		 * The tables of the threads are merged on the spot,
+		 *  without stopping them: the snapshot is indicative.
+		 *
+		 * @param *matrix the structure to fill
+		 */
+		void litm_get_traffic(litm_traffic_matrix *matrix);
+
+
+		/**
+		 * Retrieves a snapshot of the allocation counters
+		 *
+		 * @param *stats the structure to fill
+		 *
+		 * The counters are updated atomically but not
+		 *  together: the snapshot is indicative.  Comparing
+		 *  two snapshots taken around steady traffic tells
+		 *  which subsystem still allocates per message.
+		 */
+		void litm_get_alloc_stats(litm_alloc_stats *stats);
+
+
+		/**
+		 * Translates a litm_alloc_class to its name
+		 *
+		 * @return NULL for an invalid class
+		 */
+		char *litm_translate_alloc_class(litm_alloc_class cls);
+
+
+		/**
+		 * Retrieves a snapshot of the lock contention statistics
+		 *
+		 * @param *stats the structure to fill, NULL to only
+		 *               find out whether the build profiles
+		 *
+		 * @return LITM_CODE_ERROR_NOT_SUPPORTED unless the library
+		 *  was built with LITM_LOCK_PROFILE defined
+		 */
+		litm_code litm_get_lock_stats(litm_lock_stats *stats);
+
+
+		/**
+		 * Zeroes the lock contention statistics
+		 *
+		 * Useful to leave out a warm-up period.
+		 */
+		void litm_reset_lock_stats(void);
+
+
+		/**
+		 * Translates a litm_lock to its name
+		 *
+		 * @return NULL for an invalid lock
+		 */
+		char *litm_translate_lock(litm_lock lock);
+
+
+		/**
+		 * Enables / disables the flight recorder
+		 *
+		 * @param enable 1 to enable (default), 0 to disable
+		 *
+		 * Each thread touching an envelope records its events in
+		 *  a ring of its own: the most recent LITM_FLIGHT_RING_SIZE
+		 *  events per thread are kept.
+		 */
+		void litm_flight_enable(int enable);
+
+
+		/**
+		 * Dumps the flight recorder's rings to a file
+		 *
+		 * @param path the file, truncated if it exists
+		 *
+		 * The rings aren't frozen whilst dumped: the events being
+		 *  recorded at the time might be missing or torn.
+		 *
+		 * @return LITM_CODE_ERROR_IO if the file can't be written
+		 */
+		litm_code litm_flight_dump(const char *path);
+
+
+		/**
+		 * Dumps the flight recorder's rings on a fatal signal
+		 *
+		 * @param path the file, at most 255 characters
+		 *
+		 * Handles SIGSEGV, SIGBUS, SIGILL, SIGFPE and SIGABRT: the
+		 *  rings are dumped then the signal is raised again with
+		 *  its default action.
+		 *
+		 * @return LITM_CODE_ERROR_IO if the path is too long
+		 */
+		litm_code litm_flight_dump_on_signal(const char *path);
+
+
+		/**
+		 * Translates a litm_flight_code to its name
+		 *
+		 * @return NULL for an invalid code
+		 */
+		char *litm_translate_flight_code(litm_flight_code code);
+
+
+		/**
+		 * Enables / disables the envelope timestamps
+		 *
+		 * @param enable 1 to enable, 0 to disable (default)
+		 *
+		 * Each stamp costs a read of the monotonic clock on
+		 *  the path of the message: meant for latency analysis.
+		 */
+		void litm_set_timestamps(int enable);
+
+
+		/**
+		 * Retrieves the timestamps of a received envelope
+		 *
+		 * @param *envlp the envelope
+		 * @param *stamps the structure to fill
+		 *
+		 * @return LITM_CODE_NO_MESSAGE if the envelope wasn't stamped
+		 */
+		litm_code litm_get_timestamps(litm_envelope *envlp, litm_timestamps *stamps);
+
+
 		/**
 		 * Translates a code to a message pointer
 		 *
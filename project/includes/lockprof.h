@@ -0,0 +1,43 @@
+/**
+ * @file   lockprof.h
+ *
+ * @date   2026-10-19
+ * @author Jean-Lou Dupont
+ *
+ * Lock wrappers: plain pthread calls unless the
+ *  library is built with LITM_LOCK_PROFILE defined.
+ */
+
+#ifndef LOCKPROF_H_
+#define LOCKPROF_H_
+
+#include <pthread.h>
+#include <time.h>
+
+
+#ifdef LITM_LOCK_PROFILE
+#	define LITM_MUTEX_LOCK(M, ID)             lockprof_lock( (M), (ID) )
+#	define LITM_MUTEX_TRYLOCK(M, ID)          lockprof_trylock( (M), (ID) )
+#	define LITM_MUTEX_UNLOCK(M, ID)           lockprof_unlock( (M), (ID) )
+#	define LITM_COND_WAIT(C, M, ID)           lockprof_cond_wait( (C), (M), (ID), NULL )
+#	define LITM_COND_TIMEDWAIT(C, M, ID, T)   lockprof_cond_wait( (C), (M), (ID), (T) )
+#else
+#	define LITM_MUTEX_LOCK(M, ID)             pthread_mutex_lock( (M) )
+#	define LITM_MUTEX_TRYLOCK(M, ID)          pthread_mutex_trylock( (M) )
+#	define LITM_MUTEX_UNLOCK(M, ID)           pthread_mutex_unlock( (M) )
+#	define LITM_COND_WAIT(C, M, ID)           pthread_cond_wait( (C), (M) )
+#	define LITM_COND_TIMEDWAIT(C, M, ID, T)   pthread_cond_timedwait( (C), (M), (T) )
+#endif
+
+
+	// PROTOTYPES
+	int       lockprof_lock(pthread_mutex_t *mutex, litm_lock id);
+	int       lockprof_trylock(pthread_mutex_t *mutex, litm_lock id);
+	int       lockprof_unlock(pthread_mutex_t *mutex, litm_lock id);
+	int       lockprof_cond_wait(pthread_cond_t *cond, pthread_mutex_t *mutex, litm_lock id, const struct timespec *abstime);
+	litm_code lockprof_get_stats(litm_lock_stats *stats);
+	void      lockprof_reset(void);
+	char     *lockprof_name(litm_lock id);
+
+
+#endif /* LOCKPROF_H_ */
@@ -42,4 +42,38 @@
 	void			__litm_pool_clean( litm_envelope *envlp );
 
 
+	/**
+	 * Creates a shared ``payload`` with ``refs`` references
+	 *
+	 * @return NULL on malloc error
+	 */
+	litm_payload *	__litm_payload_create( void *msg, void (*cleaner)(void *msg), int refs );
+
+	/**
+	 * Adds a reference to a ``payload``
+	 */
+	void			__litm_payload_ref( litm_payload *payload );
+
+	/**
+	 * Drops a reference to a ``payload``: the last one
+	 *  runs the message's cleaner and frees the payload
+	 */
+	void			__litm_payload_release( litm_payload *payload );
+
+
+	/**
+	 * Gets an unresolved completion ``token`` with 2 references
+	 *  (the sender's and the envelope's) from the pool
+	 *
+	 * @return NULL on malloc error
+	 */
+	litm_token *	__litm_token_get(void);
+
+	/**
+	 * Drops a reference to a ``token``: the last one
+	 *  returns it to the pool
+	 */
+	void			__litm_token_put( litm_token *token );
+
+
 #endif /* POOL_H_ */
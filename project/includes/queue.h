@@ -18,9 +18,60 @@
 #include "litm.h"
 
 
+#	define LITM_QUEUE_RING_SIZE 256  // slots per priority lane, bounded backends
+
+	// put / get modes
+#	define LITM_QUEUE_BLOCK   0  // wait for the lock / for room
+#	define LITM_QUEUE_NB      1  // return -1 / NULL if busy
+#	define LITM_QUEUE_WAIT    2  // legacy ``put_wait`` behavior
+
+	// the switch's queue has id -1 (@see LITM_LOCK_PROFILE)
+#	define QUEUE_LOCK_ID(q) ((-1==(q)->id) ? LITM_LOCK_SWITCH_QUEUE : LITM_LOCK_CONNECTION_QUEUE)
+
+
+	/**
+	 * Queue backend operations
+	 *
+	 * All the backends support the priority lanes.  A ``put_head``
+	 *  is a ``put`` in the LITM_PRIORITY_URGENT lane and a ``wait``
+	 *  without timer uses a negative ``usec_timer``.
+	 *
+	 * @param init       allocates the backend's state, ``capacity`` per lane
+	 * @param destroy    frees the backend's state (the queue must be drained)
+	 * @param put        @return 1 SUCCESS, 0 ERROR, -1 BUSY/FULL
+	 * @param get        @return NULL if empty (or busy)
+	 * @param get_batch  @return the number of nodes retrieved
+	 * @param wait       @return 0 SUCCESS, 1 FAILURE
+	 * @param signal     wakes up a waiting consumer
+	 * @param count      number of nodes in the queue (indicative)
+	 * @param lane_empty consumer side check used by __queue_pick_lane
+	 */
+	typedef struct _queue_ops {
+		const char *name;
+		int   (*init)(queue *q, int capacity);
+		void  (*destroy)(queue *q);
+		int   (*put)(queue *q, void *node, int priority, int mode);
+		void *(*get)(queue *q, int mode);
+		int   (*get_batch)(queue *q, void **nodes, int max);
+		int   (*wait)(queue *q, int usec_timer);
+		void  (*signal)(queue *q);
+		int   (*count)(queue *q);
+		int   (*lane_empty)(queue *q, int lane);
+	} queue_ops;
+
+	extern const queue_ops _queue_ops_list;
+	extern const queue_ops _queue_ops_mpsc;
+	extern const queue_ops _queue_ops_spsc;
+	extern const queue_ops _queue_ops_mpmc;
+
+
 	// Prototypes
 	// ==========
 	queue *queue_create(int id);
+	queue *queue_create_ex(int id, litm_queue_backend backend, int capacity);
+
+	int                queue_backend_set(litm_queue_role role, litm_queue_backend backend);
+	litm_queue_backend queue_backend_get(litm_queue_role role);
 
 	void   queue_destroy(queue *queue);
 
@@ -28,17 +79,32 @@
 	int   queue_put(queue *q, void *msg);
 	int	  queue_put_wait(queue *q, void *node);
 
+	int   queue_put_prio_nb(queue *q, void *node, int priority);
+	int   queue_put_prio(queue *q, void *node, int priority);
+
 	int   queue_put_head_nb(queue *q, void *node);
 	int   queue_put_head(queue *q, void *msg);
 	int   queue_put_head_wait(queue *q, void *node);
 
+	int   queue_get_batch(queue *q, void **nodes, int max);
 
 	void *queue_get(queue *q);
 	void *queue_get_nb(queue *q);
 	int   queue_wait(queue *q);
+	int   queue_wait_timer(queue *q, int usec_timer);
 
 	int   queue_peek(queue *q);
+	int   queue_count(queue *q);
 	void  queue_signal(queue *q);
 
+	// backend helpers
+	int   __queue_clamp(int priority);
+	int   __queue_pick_lane(queue *q);
+	void  __queue_notify(queue *q);
+	int   __queue_lf_wait(queue *q, int usec_timer);
+	void  __queue_cond_signal(queue *q);
+	int   __queue_lf_count(queue *q);
+	int   __queue_lf_get_batch(queue *q, void **nodes, int max);
+
 
 #endif /* QUEUE_H_ */
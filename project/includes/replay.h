@@ -0,0 +1,20 @@
+/**
+ * @file   replay.h
+ *
+ * @date   2026-10-19
+ * @author Jean-Lou Dupont
+ */
+
+#ifndef REPLAY_H_
+#define REPLAY_H_
+
+
+	// PROTOTYPES
+	litm_code replay_set(litm_bus bus_id, litm_replay_mode mode, int depth);
+	int       replay_enabled(litm_bus bus_id);
+	void      replay_record(litm_envelope *e);
+	void      replay_relink(litm_envelope *e, litm_envelope *live);
+	void      replay_prime(litm_connection *conn, litm_bus bus_id);
+
+
+#endif /* REPLAY_H_ */
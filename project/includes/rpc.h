@@ -0,0 +1,21 @@
+/**
+ * @file   rpc.h
+ *
+ * @date   2026-10-19
+ * @author Jean-Lou Dupont
+ */
+
+#ifndef RPC_H_
+#define RPC_H_
+
+#	define LITM_RPC_SLOTS 256 // pending requests, power of 2
+
+
+	// PROTOTYPES
+	unsigned int rpc_open(void);
+	void         rpc_cancel(unsigned int correlation);
+	int          rpc_deliver(unsigned int correlation, litm_envelope *reply);
+	litm_code    rpc_wait(unsigned int correlation, int usec_timer, litm_envelope **reply);
+
+
+#endif /* RPC_H_ */
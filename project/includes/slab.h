@@ -0,0 +1,25 @@
+/**
+ * @file   slab.h
+ *
+ * @date   2026-10-19
+ * @author Jean-Lou Dupont
+ */
+
+#ifndef SLAB_H_
+#define SLAB_H_
+
+#include <stddef.h>
+
+#	define LITM_SLAB_CLASSES     8            // 32, 64, ... LITM_MSG_SIZE_MAX bytes
+#	define LITM_SLAB_MIN_SHIFT   5
+#	define LITM_SLAB_CHUNK_SIZE  (256*1024)
+
+
+	// PROTOTYPES
+	void *slab_alloc(litm_connection *conn, size_t size);
+	int   slab_owns(litm_connection *conn, void *msg);
+	void  slab_free(void *msg);
+	size_t slab_size(void *msg);
+
+
+#endif /* SLAB_H_ */
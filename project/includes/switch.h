@@ -10,15 +10,41 @@
 
 #include <pthread.h>
 
+	// The switch's subscription tables: the busses [1, LITM_BUSSES_MAX]
+	//  followed by the topics [0, LITM_TOPICS_MAX)
+#	define LITM_SWITCH_TABLES                (LITM_BUSSES_MAX + 1 + LITM_TOPICS_MAX)
+#	define LITM_SWITCH_TOPIC_TABLE(topic)    (LITM_BUSSES_MAX + 1 + (topic))
+
+	// envelopes dequeued at once by the switch thread
+#	define LITM_SWITCH_BATCH                 16
+
 
 	// PROTOTYPES
 	int   switch_init(void);
 	void *switch_thread_function(void *params);
 
 	litm_code switch_add_subscriber(litm_connection *conn, litm_bus bus_id);
+	litm_code switch_add_subscriber_filtered(litm_connection *conn, litm_bus bus_id, const litm_type_set *type_set);
 	litm_code switch_remove_subscriber(litm_connection *conn, litm_bus bus_id);
+	litm_code switch_set_bus_mode(litm_bus bus_id, litm_bus_mode mode);
+	litm_code switch_add_topic_subscriber(litm_connection *conn, litm_topic topic);
+	litm_code switch_remove_topic_subscriber(litm_connection *conn, litm_topic topic);
+	litm_code switch_send_topic(litm_connection *conn, litm_topic topic, void *msg, void (*cleaner)(void *msg), int type);
 	litm_code switch_send(litm_connection *conn, litm_bus bus_id, void *msg, void (*cleaner)(void *msg), int type);
+	litm_code switch_send_priority(litm_connection *conn, litm_bus bus_id, void *msg, void (*cleaner)(void *msg), int type, int priority);
+	litm_code switch_send_keyed(litm_connection *conn, litm_bus bus_id, unsigned int key, void *msg, void (*cleaner)(void *msg), int type);
+	litm_code switch_send_ttl(litm_connection *conn, litm_bus bus_id, void *msg, void (*cleaner)(void *msg), int type, int ttl_usec);
+	litm_code switch_send_tracked(litm_connection *conn, litm_bus bus_id, void *msg, void (*cleaner)(void *msg), int type, litm_token **token);
+	litm_code switch_send_multi(litm_connection *conn, litm_bus_set bus_set, void *msg, void (*cleaner)(void *msg), int type);
+	litm_code switch_send_to(litm_connection *conn, int target_id, void *msg, void (*cleaner)(void *msg), int type);
+	litm_code switch_send_request(litm_connection *conn, litm_bus bus_id, void *msg, void (*cleaner)(void *msg), int type, unsigned int correlation);
+	litm_code switch_reply(litm_connection *conn, litm_envelope *request, void *msg, void (*cleaner)(void *msg), int type);
+	litm_code switch_deliver_targeted(litm_connection *conn, litm_bus bus_id, litm_payload *payload, int type, int priority);
+	int       switch_will_reach(litm_envelope *e, litm_bus bus_id, litm_connection *conn);
 	litm_code switch_release(litm_connection *conn, litm_envelope *envlp);
+	int       switch_reclaim(litm_envelope *e, int holder);
+	void      switch_get_stats(litm_switch_stats *stats);
+	void      switch_set_timestamps(int enable);
 
 	void __switch_wait_shutdown(void);
 
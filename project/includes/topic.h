@@ -0,0 +1,18 @@
+/**
+ * @file   topic.h
+ *
+ * @date   2026-10-19
+ * @author Jean-Lou Dupont
+ */
+
+#ifndef TOPIC_H_
+#define TOPIC_H_
+
+
+	// PROTOTYPES
+	litm_code topic_register(const char *name, litm_topic *topic);
+	litm_code topic_subscribe(litm_connection *conn, const char *pattern);
+	litm_code topic_unsubscribe(litm_connection *conn, const char *pattern);
+
+
+#endif /* TOPIC_H_ */
@@ -0,0 +1,26 @@
+/**
+ * @file   traffic.h
+ *
+ * @date   2026-10-19
+ * @author Jean-Lou Dupont
+ */
+
+#ifndef TRAFFIC_H_
+#define TRAFFIC_H_
+
+#include <stddef.h>
+
+#	define LITM_TRAFFIC_TABLES_MAX   64		// threads sampling
+#	define LITM_TRAFFIC_SLOTS        256	// per thread, a power of 2
+
+
+	// PROTOTYPES
+	void traffic_set_sampling(int rate);
+	void traffic_reset(void);
+	int  traffic_due(void);
+	void traffic_record_send(int sender, litm_bus bus_id, int type, size_t size, int weight);
+	void traffic_record_dispatch(int sender, litm_bus bus_id, int type, unsigned long long ns, int weight);
+	void traffic_get(litm_traffic_matrix *matrix);
+
+
+#endif /* TRAFFIC_H_ */
@@ -37,4 +37,31 @@
 	int random_sleep_period(struct timeval *start, struct timeval *current, int max_usecs_interval, int max_usecs_total);
 
 
+	/**
+	 * Monotonic clock
+	 *
+	 * @return the current time in nanoseconds
+	 */
+	unsigned long long monotonic_ns(void);
+
+
+	/**
+	 * Waits whilst ``*addr`` equals ``val``
+	 *
+	 * Uses a futex where available, short sleeps otherwise.
+	 *  Spurious wake-ups are possible: the caller re-checks.
+	 *
+	 * @param addr  the word to watch
+	 * @param val   the value to wait on
+	 * @param usecs maximum wait in microseconds, negative for no limit
+	 */
+	void futex_wait(volatile int *addr, int val, int usecs);
+
+
+	/**
+	 * Wakes all the threads waiting on ``addr``
+	 */
+	void futex_wake(volatile int *addr);
+
+
 #endif /* UTILS */
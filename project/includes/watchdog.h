@@ -0,0 +1,22 @@
+/**
+ * @file   watchdog.h
+ *
+ * @date   2026-10-19
+ * @author Jean-Lou Dupont
+ */
+
+#ifndef WATCHDOG_H_
+#define WATCHDOG_H_
+
+
+	// PROTOTYPES
+	void      watchdog_set_threshold(int usecs);
+	litm_code watchdog_set_timeout(int table, int usecs);
+	int       watchdog_active(void);
+	void      watchdog_track(litm_envelope *e, litm_connection *holder, int table);
+	void      watchdog_untrack(litm_envelope *e);
+	void      watchdog_check(unsigned long long now);
+	void      watchdog_get_stats(litm_watchdog_stats *stats);
+
+
+#endif /* WATCHDOG_H_ */
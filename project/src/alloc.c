@@ -0,0 +1,165 @@
+/**
+ * @file   alloc.c
+ *
+ * @date   2026-10-19
+ * @author Jean-Lou Dupont
+ *
+ * \section Overview
+ *
+ *			This module wraps the heap allocations of the library
+ *			in order to count them per subsystem (@see litm_alloc_class).
+ *
+ *			The callers pass the size of the block they release: no
+ *			header is added to the blocks.  A NULL pointer is ignored,
+ *			as with free().
+ *
+ *			The counters are updated with atomic additions, a small
+ *			cost next to the allocation itself.
+ *
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "litm.h"
+#include "alloc.h"
+
+
+char *LITM_ALLOC_CLASS_NAMES[] = {
+		"queue",
+		"queue_node",
+		"envelope",
+		"payload",
+		"token",
+		"connection",
+		"slab",
+		"switch",
+		"debug",
+		"flight",
+		"traffic"
+};
+
+litm_alloc_counters _alloc_counters[LITM_ALLOC_CLASSES];
+
+
+// PRIVATE
+// -------
+void __alloc_count(litm_alloc_class cls, size_t size);
+void __alloc_uncount(litm_alloc_class cls, size_t size);
+
+
+
+	void *
+alloc_malloc(litm_alloc_class cls, size_t size) {
+
+	void *ptr = malloc( size );
+	if (NULL!=ptr)
+		__alloc_count( cls, size );
+
+	return ptr;
+}//
+
+	void *
+alloc_calloc(litm_alloc_class cls, size_t count, size_t size) {
+
+	void *ptr = calloc( count, size );
+	if (NULL!=ptr)
+		__alloc_count( cls, count * size );
+
+	return ptr;
+}//
+
+/**
+ * Aligned allocation, zeroed
+ */
+	void *
+alloc_memalign(litm_alloc_class cls, size_t alignment, size_t size) {
+
+	void *ptr = NULL;
+
+	if (0!=posix_memalign( &ptr, alignment, size ))
+		return NULL;
+
+	memset( ptr, 0, size );
+	__alloc_count( cls, size );
+
+	return ptr;
+}//
+
+/**
+ * Counts as the release of the old block and the
+ *  allocation of the new one
+ */
+	void *
+alloc_realloc(litm_alloc_class cls, void *ptr, size_t old_size, size_t size) {
+
+	void *resized = realloc( ptr, size );
+	if (NULL==resized)
+		return NULL;
+
+	if (NULL!=ptr)
+		__alloc_uncount( cls, old_size );
+	__alloc_count( cls, size );
+
+	return resized;
+}//
+
+	void
+alloc_free(litm_alloc_class cls, void *ptr, size_t size) {
+
+	if (NULL==ptr)
+		return;
+
+	free( ptr );
+	__alloc_uncount( cls, size );
+}//
+
+	void
+alloc_get_stats(litm_alloc_stats *stats) {
+
+	int cls;
+
+	for (cls=0; cls<LITM_ALLOC_CLASSES; cls++) {
+		stats->classes[cls].allocs     = __sync_fetch_and_add( &_alloc_counters[cls].allocs, 0 );
+		stats->classes[cls].frees      = __sync_fetch_and_add( &_alloc_counters[cls].frees, 0 );
+		stats->classes[cls].live_bytes = __sync_fetch_and_add( &_alloc_counters[cls].live_bytes, 0 );
+		stats->classes[cls].peak_bytes = __sync_fetch_and_add( &_alloc_counters[cls].peak_bytes, 0 );
+	}
+}//
+
+	char *
+alloc_class_name(litm_alloc_class cls) {
+
+	if ((0 > (int) cls) || (LITM_ALLOC_CLASSES <= cls))
+		return NULL;
+
+	return LITM_ALLOC_CLASS_NAMES[cls];
+}//
+
+
+	void
+__alloc_count(litm_alloc_class cls, size_t size) {
+
+	litm_alloc_counters *c = &_alloc_counters[cls];
+	long live, peak, seen;
+
+	__sync_fetch_and_add( &c->allocs, 1 );
+	live = __sync_add_and_fetch( &c->live_bytes, (long) size );
+
+	// a concurrent lower value mustn't overwrite a higher one
+	peak = c->peak_bytes;
+	while (live > peak) {
+		seen = __sync_val_compare_and_swap( &c->peak_bytes, peak, live );
+		if (seen == peak)
+			break;
+		peak = seen;
+	}
+}//
+
+	void
+__alloc_uncount(litm_alloc_class cls, size_t size) {
+
+	litm_alloc_counters *c = &_alloc_counters[cls];
+
+	__sync_fetch_and_add( &c->frees, 1 );
+	__sync_fetch_and_sub( &c->live_bytes, (long) size );
+}//
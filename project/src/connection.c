@@ -41,6 +41,13 @@
  * 			- the connection identifier is placed in a stack (pending deletion)
  * 			- the ``switch`` inspects the said stack at regular interval
  *
+ * \section Identifiers
+ *
+ * 			Active connections are indexed by ``id`` (open addressing)
+ * 			for direct sends (litm_send_to).  Identifiers are meant to be
+ * 			unique: with duplicates, only the first connection opened with
+ * 			an ``id`` is reachable until it is closed.
+ *
  *
  */
 #include <pthread.h>
@@ -50,12 +57,17 @@
 #include "connection.h"
 #include "queue.h"
 #include "logger.h"
+#include "alloc.h"
+#include "lockprof.h"
+#include "flight.h"
 
 // PRIVATE
 int __litm_connection_get_index(litm_connection *(table)[], litm_connection *conn);
 int __litm_connection_get_free_index(litm_connection *(table)[]);
 litm_connection *__litm_connection_get_ptr(int connection_index);
 void _litm_connections_init(void);
+void __litm_connection_index_add(litm_connection *conn);
+void __litm_connection_index_remove(litm_connection *conn);
 
 // PRIVATE VARIABLES
 // -----------------
@@ -70,6 +82,11 @@ litm_connection *_connections[LITM_CONNECTION_MAX];
 pthread_mutex_t  _connections_pending_deletion_mutex = PTHREAD_MUTEX_INITIALIZER;
 litm_connection *_connections_pending_deletion[LITM_CONNECTION_MAX];
 
+	// CONNECTIONS BY ID
+	// -----------------
+	// protected by _connections_mutex
+litm_connection *_connections_by_id[LITM_CONNECTION_INDEX_SIZE];
+
 
 int __connections_initialized = 0;
 
@@ -110,7 +127,7 @@ litm_connection_open_ex(litm_connection **conn, int id) {
 
 	int target_index, code;
 
-	code = pthread_mutex_trylock( &_connections_mutex );
+	code = LITM_MUTEX_TRYLOCK( &_connections_mutex, LITM_LOCK_CONNECTIONS );
 	if (EBUSY==code) {
 		return LITM_CODE_BUSY;
 	}
@@ -122,20 +139,22 @@ litm_connection_open_ex(litm_connection **conn, int id) {
 
 	target_index = __litm_connection_get_free_index(_connections);
 	if (-1 == target_index) {
-		pthread_mutex_unlock( &_connections_mutex );
+		LITM_MUTEX_UNLOCK( &_connections_mutex, LITM_LOCK_CONNECTIONS );
 		return LITM_CODE_ERROR_NO_MORE_CONNECTIONS;
 	}
 
-	*conn= (litm_connection *) malloc(sizeof(litm_connection));
+	*conn= (litm_connection *) alloc_malloc(LITM_ALLOC_CONNECTION, sizeof(litm_connection));
 	if (NULL==*conn) {
-		pthread_mutex_unlock( &_connections_mutex );
+		LITM_MUTEX_UNLOCK( &_connections_mutex, LITM_LOCK_CONNECTIONS );
 		return LITM_CODE_ERROR_MALLOC;
 	}
 
-	queue *q = queue_create(id);
+	// only the switch thread feeds a connection's
+	//  input queue and only the client drains it
+	queue *q = queue_create_ex(id, queue_backend_get(LITM_QUEUE_ROLE_CONNECTION), LITM_QUEUE_RING_SIZE);
 	if (NULL==q) {
-		free(*conn);
-		pthread_mutex_unlock( &_connections_mutex );
+		alloc_free(LITM_ALLOC_CONNECTION, *conn, sizeof(litm_connection));
+		LITM_MUTEX_UNLOCK( &_connections_mutex, LITM_LOCK_CONNECTIONS );
 		return LITM_CODE_ERROR_MALLOC;
 	}
 
@@ -144,14 +163,20 @@ litm_connection_open_ex(litm_connection **conn, int id) {
 	(*conn)->received = 0;
 	(*conn)->released = 0;
 	(*conn)->sent     = 0;
+	(*conn)->in_flight = 0;
 	(*conn)->id       = id;
+	(*conn)->index    = target_index;
 	(*conn)->input_queue = q;
+	(*conn)->slab = NULL;
 	(*conn)->status = LITM_CONNECTION_STATUS_ACTIVE;
 
+	__litm_connection_index_add( *conn );
+	flight_connection( target_index, id );
+
 	//DEBUG_LOG(LOG_INFO, "litm_connection_open: OPENED, index[%u] ref[%x], q[%x]", target_index, *conn, q);
 
 
-	pthread_mutex_unlock( &_connections_mutex );
+	LITM_MUTEX_UNLOCK( &_connections_mutex, LITM_LOCK_CONNECTIONS );
 
 	//DEBUG_LOG(LOG_INFO, "litm_connection_open: END");
 	return LITM_CODE_OK;
@@ -167,17 +192,18 @@ litm_connection_close(litm_connection *conn) {
 
 	// FLAG the connection has been about to be deleted
 	//  Hopefully, this doesn't cause too much blockage...
-	pthread_mutex_lock( &_connections_mutex );
+	LITM_MUTEX_LOCK( &_connections_mutex, LITM_LOCK_CONNECTIONS );
 		conn->status = LITM_CONNECTION_STATUS_PENDING_DELETION;
-	pthread_mutex_unlock( &_connections_mutex );
+		__litm_connection_index_remove( conn );
+	LITM_MUTEX_UNLOCK( &_connections_mutex, LITM_LOCK_CONNECTIONS );
 
 
-	pthread_mutex_lock( &_connections_pending_deletion_mutex );
+	LITM_MUTEX_LOCK( &_connections_pending_deletion_mutex, LITM_LOCK_PENDING_DELETION );
 
 		int target_index = __litm_connection_get_free_index(_connections_pending_deletion);
 
 		if (-1 == target_index) {
-			pthread_mutex_unlock( &_connections_pending_deletion_mutex );
+			LITM_MUTEX_UNLOCK( &_connections_pending_deletion_mutex, LITM_LOCK_PENDING_DELETION );
 			return LITM_CODE_ERROR_NO_MORE_CONNECTIONS;
 		}
 
@@ -185,7 +211,7 @@ litm_connection_close(litm_connection *conn) {
 
 		DEBUG_LOG(LOG_INFO, "litm_connection_close: PENDING conn[%x]", conn);
 
-	pthread_mutex_unlock( &_connections_pending_deletion_mutex );
+	LITM_MUTEX_UNLOCK( &_connections_pending_deletion_mutex, LITM_LOCK_PENDING_DELETION );
 
 	return LITM_CODE_OK;
 }//
@@ -232,27 +258,27 @@ __litm_connection_get_free_index(litm_connection *(table)[]) {
 		}
 	}
 
-	return index;
+	return result;
 }//
 
 
 	void
 _litm_connections_lock(void) {
 
-	pthread_mutex_lock( &_connections_mutex );
+	LITM_MUTEX_LOCK( &_connections_mutex, LITM_LOCK_CONNECTIONS );
 }//
 
 	int
 _litm_connections_trylock(void) {
 
-	return pthread_mutex_trylock( &_connections_mutex );
+	return LITM_MUTEX_TRYLOCK( &_connections_mutex, LITM_LOCK_CONNECTIONS );
 }//
 
 
 	void
 _litm_connections_unlock(void) {
 
-	pthread_mutex_unlock( &_connections_mutex );
+	LITM_MUTEX_UNLOCK( &_connections_mutex, LITM_LOCK_CONNECTIONS );
 }//
 
 /**
@@ -296,14 +322,14 @@ _litm_connection_validate_safe(litm_connection *conn) {
 	void
 _litm_connection_lock(litm_connection *conn) {
 
-	pthread_mutex_lock( conn->input_queue->mutex );
+	LITM_MUTEX_LOCK( conn->input_queue->mutex, LITM_LOCK_CONNECTION_QUEUE );
 
 }//
 
 	void
 _litm_connection_unlock(litm_connection *conn) {
 
-	pthread_mutex_unlock( conn->input_queue->mutex );
+	LITM_MUTEX_UNLOCK( conn->input_queue->mutex, LITM_LOCK_CONNECTION_QUEUE );
 }
 
 	litm_connection_status
@@ -329,6 +355,97 @@ _litm_connection_signal_all(void) {
 
 }//
 
+/**
+ * Finds the active connection with identifier ``id``
+ *
+ * @return NULL if none
+ */
+	litm_connection *
+_litm_connection_find(int id) {
+
+	litm_connection *conn, *result = NULL;
+	unsigned int mask = LITM_CONNECTION_INDEX_SIZE - 1;
+	unsigned int i = ((unsigned int) id * 2654435761U) & mask;
+
+	LITM_MUTEX_LOCK( &_connections_mutex, LITM_LOCK_CONNECTIONS );
+
+		while (NULL!=(conn = _connections_by_id[i])) {
+			if (id == conn->id) {
+				result = conn;
+				break;
+			}
+			i = (i + 1) & mask;
+		}
+
+	LITM_MUTEX_UNLOCK( &_connections_mutex, LITM_LOCK_CONNECTIONS );
+
+	return result;
+}//
+
+/**
+ * Indexes a connection by ``id`` unless the
+ *  ``id`` is already taken
+ *
+ * Must be called whilst holding _connections_mutex
+ */
+	void
+__litm_connection_index_add(litm_connection *conn) {
+
+	unsigned int mask = LITM_CONNECTION_INDEX_SIZE - 1;
+	unsigned int i = ((unsigned int) conn->id * 2654435761U) & mask;
+
+	while (NULL!=_connections_by_id[i]) {
+		if (conn->id == _connections_by_id[i]->id)
+			return;
+		i = (i + 1) & mask;
+	}
+
+	_connections_by_id[i] = conn;
+}//
+
+/**
+ * Removes a connection from the index (backward shift) and
+ *  indexes, if any, another active connection with the same ``id``
+ *
+ * Must be called whilst holding _connections_mutex
+ */
+	void
+__litm_connection_index_remove(litm_connection *conn) {
+
+	unsigned int mask = LITM_CONNECTION_INDEX_SIZE - 1;
+	unsigned int i = ((unsigned int) conn->id * 2654435761U) & mask;
+	unsigned int j, home;
+	int index;
+
+	while (conn != _connections_by_id[i]) {
+		if (NULL==_connections_by_id[i])
+			return;
+		i = (i + 1) & mask;
+	}
+
+	_connections_by_id[i] = NULL;
+
+	// pull back the entries which would be unreachable
+	for (j = (i + 1) & mask; NULL!=_connections_by_id[j]; j = (j + 1) & mask) {
+
+		home = ((unsigned int) _connections_by_id[j]->id * 2654435761U) & mask;
+		if (((j - home) & mask) >= ((j - i) & mask)) {
+			_connections_by_id[i] = _connections_by_id[j];
+			_connections_by_id[j] = NULL;
+			i = j;
+		}
+	}
+
+	for (index=1; index<LITM_CONNECTION_MAX; index++) {
+		if ((NULL!=_connections[index]) && (conn != _connections[index])
+				&& (conn->id == _connections[index]->id)
+				&& (LITM_CONNECTION_STATUS_ACTIVE == _connections[index]->status)) {
+			__litm_connection_index_add( _connections[index] );
+			break;
+		}
+	}
+}//
+
 	void
 _litm_connections_init(void) {
 
@@ -337,4 +454,8 @@ _litm_connections_init(void) {
 		_connections[i]=NULL;
 	}
 
+	for (i=0;i<LITM_CONNECTION_INDEX_SIZE;i++) {
+		_connections_by_id[i]=NULL;
+	}
+
 }//
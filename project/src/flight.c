@@ -0,0 +1,312 @@
+/**
+ * @file   flight.c
+ *
+ * @date   2026-10-19
+ * @author Jean-Lou Dupont
+ *
+ * \section Overview
+ *
+ *			This module implements the *flight recorder*: the threads
+ *			handling envelopes (senders, switch, receivers) record
+ *			what they do to them in rings of compact events, one ring
+ *			per thread thus without any lock nor atomic on the way.
+ *
+ *			A thread gets its ring on its first event: the rings are
+ *			never freed, those of the threads gone remaining for the
+ *			post-mortem.  Past LITM_FLIGHT_RINGS_MAX threads, the
+ *			new ones don't record.
+ *
+ *			The dump only uses open/write/close: it can be called
+ *			from a signal handler.  The events are decoded offline
+ *			(@see test/src/flight_decode.c).
+ *
+ */
+#include <fcntl.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "litm.h"
+#include "flight.h"
+#include "alloc.h"
+#include "utils.h"
+
+
+char *LITM_FLIGHT_CODE_NAMES[] = {
+		"none",
+		"send",
+		"send_failed",
+		"dispatch",
+		"deliver",
+		"busy",
+		"inactive",
+		"receive",
+		"release",
+		"expire",
+		"finalize",
+		"reclaim"
+};
+
+/**
+ * Ring of a thread
+ *
+ * @param head count of events recorded, the next one
+ *             goes to ``head % LITM_FLIGHT_RING_SIZE``
+ */
+typedef struct {
+	volatile unsigned long head;
+	int index;
+	litm_flight_event events[LITM_FLIGHT_RING_SIZE];
+} __flight_ring;
+
+
+int _flight_enabled = 1;
+
+__flight_ring *_flight_rings[LITM_FLIGHT_RINGS_MAX];
+int _flight_ring_count = 0;
+
+// the last connection in each slot
+int _flight_conn_ids[LITM_CONNECTION_MAX+1];
+int _flight_conn_used[LITM_CONNECTION_MAX+1];
+
+char _flight_signal_path[256];
+
+static __thread __flight_ring *__flight_ring_self = NULL;
+static __thread int __flight_ring_none = 0;
+
+
+// PRIVATE
+// -------
+__flight_ring *__flight_ring_get(void);
+int  __flight_write(int fd, const void *buf, size_t size);
+void __flight_signal_handler(int sig);
+
+
+
+	void
+flight_enable(int enable) {
+
+	_flight_enabled = (0!=enable);
+}//
+
+/**
+ * Records an event in the calling thread's ring
+ */
+	void
+flight_record(litm_flight_code code, unsigned int envelope, int conn) {
+
+	__flight_ring *ring;
+	litm_flight_event *ev;
+
+	if (!_flight_enabled)
+		return;
+
+	ring = __flight_ring_get();
+	if (NULL==ring)
+		return;
+
+	ev = &ring->events[ring->head % LITM_FLIGHT_RING_SIZE];
+	ev->ts       = monotonic_ns();
+	ev->envelope = envelope;
+	ev->conn     = (short) conn;
+	ev->code     = (unsigned char) code;
+	ev->ring     = (unsigned char) ring->index;
+
+	// the event is complete before it becomes visible
+	__sync_synchronize();
+	ring->head++;
+}//
+
+/**
+ * Keeps the id of the connection opened in a slot
+ *  for the dump's connection table
+ */
+	void
+flight_connection(int index, int id) {
+
+	if ((0 > index) || (LITM_CONNECTION_MAX < index))
+		return;
+
+	_flight_conn_ids[index]  = id;
+	_flight_conn_used[index] = 1;
+}//
+
+/**
+ * Writes the rings to ``path``
+ *
+ * Async-signal-safe.
+ */
+	litm_code
+flight_dump(const char *path) {
+
+	litm_flight_header header;
+	__flight_ring *ring;
+	unsigned long head, first, start;
+	int fd, index, rings, count, ok=1;
+	int pair[2];
+
+	fd = open( path, O_WRONLY|O_CREAT|O_TRUNC, 0644 );
+	if (0 > fd) {
+		return LITM_CODE_ERROR_IO;
+	}
+
+	rings = _flight_ring_count;
+	if (LITM_FLIGHT_RINGS_MAX < rings)
+		rings = LITM_FLIGHT_RINGS_MAX;
+
+	memset( &header, 0, sizeof(header) );
+	memcpy( header.magic, LITM_FLIGHT_MAGIC, sizeof(header.magic) );
+	header.rings       = 0;
+	header.connections = 0;
+
+	for (index=0; index<rings; index++)
+		if (NULL!=_flight_rings[index])
+			header.rings++;
+
+	for (index=0; index<=LITM_CONNECTION_MAX; index++)
+		if (_flight_conn_used[index])
+			header.connections++;
+
+	ok = __flight_write( fd, &header, sizeof(header) );
+
+	for (index=0; ok && (index<=LITM_CONNECTION_MAX); index++) {
+		if (!_flight_conn_used[index])
+			continue;
+		pair[0] = index;
+		pair[1] = _flight_conn_ids[index];
+		ok = __flight_write( fd, pair, sizeof(pair) );
+	}
+
+	for (index=0; ok && (index<rings); index++) {
+
+		ring = _flight_rings[index];
+		if (NULL==ring)
+			continue;
+
+		head  = ring->head;
+		first = (LITM_FLIGHT_RING_SIZE < head) ? head - LITM_FLIGHT_RING_SIZE : 0;
+		count = (int) (head - first);
+		start = first % LITM_FLIGHT_RING_SIZE;
+
+		pair[0] = index;
+		pair[1] = count;
+		ok = __flight_write( fd, pair, sizeof(pair) );
+
+		// oldest first: the ring might wrap
+		if (ok && (0 < count)) {
+			if (start + count <= LITM_FLIGHT_RING_SIZE) {
+				ok = __flight_write( fd, &ring->events[start], count * sizeof(litm_flight_event) );
+			} else {
+				ok = __flight_write( fd, &ring->events[start], (LITM_FLIGHT_RING_SIZE - start) * sizeof(litm_flight_event) );
+				if (ok)
+					ok = __flight_write( fd, &ring->events[0], (start + count - LITM_FLIGHT_RING_SIZE) * sizeof(litm_flight_event) );
+			}
+		}
+	}
+
+	close( fd );
+
+	return ok ? LITM_CODE_OK : LITM_CODE_ERROR_IO;
+}//
+
+/**
+ * Installs the fatal signals handler
+ */
+	litm_code
+flight_dump_on_signal(const char *path) {
+
+	struct sigaction sa;
+	int signals[] = { SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT };
+	int index;
+
+	if (sizeof(_flight_signal_path) <= strlen(path)) {
+		return LITM_CODE_ERROR_IO;
+	}
+
+	strcpy( _flight_signal_path, path );
+
+	memset( &sa, 0, sizeof(sa) );
+	sa.sa_handler = &__flight_signal_handler;
+	sa.sa_flags   = SA_RESETHAND;
+	sigemptyset( &sa.sa_mask );
+
+	for (index=0; index<(int) (sizeof(signals)/sizeof(int)); index++)
+		sigaction( signals[index], &sa, NULL );
+
+	return LITM_CODE_OK;
+}//
+
+	char *
+flight_code_name(litm_flight_code code) {
+
+	if ((0 > (int) code) || (LITM_FLIGHT_CODES <= code))
+		return NULL;
+
+	return LITM_FLIGHT_CODE_NAMES[code];
+}//
+
+
+/**
+ * Gets the calling thread's ring, allocating it
+ *  on the first call
+ *
+ * @return NULL if the rings are all taken
+ */
+	__flight_ring *
+__flight_ring_get(void) {
+
+	__flight_ring *ring;
+	int index;
+
+	if (NULL!=__flight_ring_self)
+		return __flight_ring_self;
+
+	if (__flight_ring_none)
+		return NULL;
+
+	index = __sync_fetch_and_add( &_flight_ring_count, 1 );
+	if (LITM_FLIGHT_RINGS_MAX <= index) {
+		__flight_ring_none = 1;
+		return NULL;
+	}
+
+	ring = (__flight_ring *) alloc_calloc( LITM_ALLOC_FLIGHT, 1, sizeof(__flight_ring) );
+	if (NULL==ring) {
+		__flight_ring_none = 1;
+		return NULL;
+	}
+
+	ring->index = index;
+	_flight_rings[index] = ring;
+	__flight_ring_self = ring;
+
+	return ring;
+}//
+
+	int
+__flight_write(int fd, const void *buf, size_t size) {
+
+	const char *p = (const char *) buf;
+	ssize_t written;
+
+	while (0 < size) {
+		written = write( fd, p, size );
+		if (0 >= written)
+			return 0;
+		p    += written;
+		size -= written;
+	}
+
+	return 1;
+}//
+
+/**
+ * Dumps then lets the signal take its
+ *  default course (SA_RESETHAND)
+ */
+	void
+__flight_signal_handler(int sig) {
+
+	flight_dump( _flight_signal_path );
+	raise( sig );
+}//
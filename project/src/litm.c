@@ -11,12 +11,24 @@
  */
 #include <errno.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "litm.h"
 #include "connection.h"
+#include "switch.h"
+#include "topic.h"
 #include "queue.h"
 #include "pool.h"
+#include "replay.h"
+#include "rpc.h"
+#include "slab.h"
 #include "logger.h"
+#include "utils.h"
+#include "alloc.h"
+#include "lockprof.h"
+#include "flight.h"
+#include "watchdog.h"
+#include "traffic.h"
 
 char *LITM_CODE_MESSAGES[] = {
 		"LITM_CODE_OK",
@@ -42,7 +54,18 @@ char *LITM_CODE_MESSAGES[] = {
 		"LITM_CODE_ERROR_CONNECTION_ERROR",
 		"LITM_CODE_ERROR_SUBSCRIPTION_ERROR",
 		"LITM_CODE_ERROR_SEND_ERROR",
-		"LITM_CODE_ERROR_RECEIVE_WAIT"
+		"LITM_CODE_ERROR_RECEIVE_WAIT",
+		"LITM_CODE_ERROR_INVALID_MODE",
+		"LITM_CODE_ERROR_INVALID_TYPE",
+		"LITM_CODE_ERROR_INVALID_TOPIC",
+		"LITM_CODE_ERROR_NO_MORE_TOPICS",
+		"LITM_CODE_ERROR_INVALID_PRIORITY",
+		"LITM_CODE_ERROR_INVALID_BACKEND",
+		"LITM_CODE_ERROR_INVALID_TTL",
+		"LITM_CODE_ERROR_REQUEST_EXPIRED",
+		"LITM_CODE_ERROR_INVALID_TARGET",
+		"LITM_CODE_ERROR_NOT_SUPPORTED",
+		"LITM_CODE_ERROR_IO"
 };
 
 // PRIVATE
@@ -85,12 +108,100 @@ litm_subscribe(litm_connection *conn, litm_bus bus_id) {
 }//
 
 
+	litm_code
+litm_subscribe_filtered(litm_connection *conn, litm_bus bus_id, const litm_type_set *type_set) {
+
+	return switch_add_subscriber_filtered( conn, bus_id, type_set );
+}//
+
+
+	void
+litm_type_set_clear(litm_type_set *set) {
+
+	if (NULL==set)
+		return;
+
+	memset( set, 0, sizeof(litm_type_set) );
+}//
+
+	litm_code
+litm_type_set_add(litm_type_set *set, int type) {
+
+	if ((NULL==set) || (0>type) || (LITM_TYPE_SET_MAX<=type))
+		return LITM_CODE_ERROR_INVALID_TYPE;
+
+	set->bits[type / 32] |= (1U << (type % 32));
+
+	return LITM_CODE_OK;
+}//
+
+	litm_code
+litm_type_set_remove(litm_type_set *set, int type) {
+
+	if ((NULL==set) || (0>type) || (LITM_TYPE_SET_MAX<=type))
+		return LITM_CODE_ERROR_INVALID_TYPE;
+
+	set->bits[type / 32] &= ~(1U << (type % 32));
+
+	return LITM_CODE_OK;
+}//
+
+	int
+litm_type_set_has(const litm_type_set *set, int type) {
+
+	if ((NULL==set) || (0>type) || (LITM_TYPE_SET_MAX<=type))
+		return 0;
+
+	return (set->bits[type / 32] >> (type % 32)) & 1;
+}//
+
+
+	litm_code
+litm_topic_register(const char *name, litm_topic *topic) {
+
+	return topic_register( name, topic );
+}//
+
+	litm_code
+litm_subscribe_topic(litm_connection *conn, const char *pattern) {
+
+	return topic_subscribe( conn, pattern );
+}//
+
+	litm_code
+litm_unsubscribe_topic(litm_connection *conn, const char *pattern) {
+
+	return topic_unsubscribe( conn, pattern );
+}//
+
+
 	litm_code
 litm_unsubscribe(litm_connection *conn, litm_bus bus_id) {
 
 	return switch_remove_subscriber( conn, bus_id );
 }//
 
+	litm_code
+litm_bus_set_mode(litm_bus bus_id, litm_bus_mode mode) {
+
+	return switch_set_bus_mode( bus_id, mode );
+}//
+
+	litm_code
+litm_bus_set_replay(litm_bus bus_id, litm_replay_mode mode, int depth) {
+
+	return replay_set( bus_id, mode, depth );
+}//
+
+	litm_code
+litm_set_queue_backend(litm_queue_role role, litm_queue_backend backend) {
+
+	if (0!=queue_backend_set( role, backend ))
+		return LITM_CODE_ERROR_INVALID_BACKEND;
+
+	return LITM_CODE_OK;
+}//
+
 	litm_code
 litm_send(	litm_connection *conn,
 			litm_bus bus_id,
@@ -101,6 +212,212 @@ litm_send(	litm_connection *conn,
 	return switch_send(conn, bus_id, msg, cleaner, type);
 }//
 
+	litm_code
+litm_send_priority(	litm_connection *conn,
+					litm_bus bus_id,
+					void *msg,
+					void (*cleaner)(void *msg),
+					int type,
+					int priority) {
+
+	return switch_send_priority(conn, bus_id, msg, cleaner, type, priority);
+}//
+
+	litm_code
+litm_send_keyed(	litm_connection *conn,
+					litm_bus bus_id,
+					unsigned int key,
+					void *msg,
+					void (*cleaner)(void *msg),
+					int type) {
+
+	return switch_send_keyed(conn, bus_id, key, msg, cleaner, type);
+}//
+
+	litm_code
+litm_send_ttl(	litm_connection *conn,
+				litm_bus bus_id,
+				void *msg,
+				void (*cleaner)(void *msg),
+				int type,
+				int ttl_usec) {
+
+	return switch_send_ttl(conn, bus_id, msg, cleaner, type, ttl_usec);
+}//
+
+	litm_code
+litm_send_tracked(	litm_connection *conn,
+					litm_bus bus_id,
+					void *msg,
+					void (*cleaner)(void *msg),
+					int type,
+					litm_token **token) {
+
+	if (NULL==token) {
+		return LITM_CODE_ERROR_SEND_ERROR;
+	}
+
+	*token = NULL;
+
+	return switch_send_tracked(conn, bus_id, msg, cleaner, type, token);
+}//
+
+	void *
+litm_msg_alloc(litm_connection *conn, size_t size) {
+
+	if (NULL==conn) {
+		return NULL;
+	}
+
+	return slab_alloc( conn, size );
+}//
+
+	void
+litm_msg_free(void *msg) {
+
+	if (NULL!=msg)
+		slab_free( msg );
+}//
+
+	litm_code
+litm_send_multi(	litm_connection *conn,
+					litm_bus_set bus_set,
+					void *msg,
+					void (*cleaner)(void *msg),
+					int type) {
+
+	return switch_send_multi(conn, bus_set, msg, cleaner, type);
+}//
+
+	litm_code
+litm_send_to(	litm_connection *conn,
+				int target_id,
+				void *msg,
+				void (*cleaner)(void *msg),
+				int type) {
+
+	return switch_send_to(conn, target_id, msg, cleaner, type);
+}//
+
+	litm_code
+litm_request(	litm_connection *conn,
+				litm_bus bus_id,
+				void *msg,
+				void (*cleaner)(void *msg),
+				int type,
+				int usec_timer,
+				litm_envelope **reply) {
+
+	if (NULL==reply) {
+		return LITM_CODE_ERROR_SEND_ERROR;
+	}
+
+	*reply = NULL;
+
+	unsigned int correlation = rpc_open();
+	if (0==correlation) {
+		return LITM_CODE_BUSY;
+	}
+
+	litm_code code = switch_send_request(conn, bus_id, msg, cleaner, type, correlation);
+	if (LITM_CODE_OK!=code) {
+		rpc_cancel( correlation );
+		return code;
+	}
+
+	code = rpc_wait( correlation, usec_timer, reply );
+	if (LITM_CODE_OK==code)
+		conn->received++;
+
+	return code;
+}//
+
+	litm_code
+litm_reply(	litm_connection *conn,
+			litm_envelope *request,
+			void *msg,
+			void (*cleaner)(void *msg),
+			int type) {
+
+	return switch_reply(conn, request, msg, cleaner, type);
+}//
+
+	litm_code
+litm_token_poll(litm_token *token) {
+
+	if (1==__atomic_load_n( &token->state, __ATOMIC_ACQUIRE ))
+		return LITM_CODE_OK;
+
+	return LITM_CODE_BUSY;
+}//
+
+/**
+ * Blocks on the token's futex word: the switch only
+ *  issues the wake-up call when ``waiters`` is set.
+ */
+	litm_code
+litm_token_wait(litm_token *token, int usec_timer) {
+
+	unsigned long long deadline = 0, now;
+	int left = usec_timer;
+
+	if (LITM_CODE_OK==litm_token_poll( token ))
+		return LITM_CODE_OK;
+
+	if (0<=usec_timer)
+		deadline = monotonic_ns() + (unsigned long long) usec_timer * 1000ULL;
+
+	__atomic_add_fetch( &token->waiters, 1, __ATOMIC_SEQ_CST );
+
+	while (0==__atomic_load_n( &token->state, __ATOMIC_SEQ_CST )) {
+
+		if (0!=deadline) {
+			now = monotonic_ns();
+			if (now >= deadline)
+				break;
+			left = (int) ((deadline - now) / 1000ULL);
+		}
+
+		futex_wait( &token->state, 0, left );
+	}
+
+	__atomic_sub_fetch( &token->waiters, 1, __ATOMIC_SEQ_CST );
+
+	return litm_token_poll( token );
+}//
+
+	litm_code
+litm_token_get_counts(litm_token *token, int *delivered, int *released) {
+
+	if (LITM_CODE_OK!=litm_token_poll( token ))
+		return LITM_CODE_BUSY;
+
+	if (NULL!=delivered)
+		*delivered = token->delivered;
+
+	if (NULL!=released)
+		*released = token->released;
+
+	return LITM_CODE_OK;
+}//
+
+	void
+litm_token_release(litm_token *token) {
+
+	if (NULL!=token)
+		__litm_token_put( token );
+}//
+
+	litm_code
+litm_send_topic(	litm_connection *conn,
+					litm_topic topic,
+					void *msg,
+					void (*cleaner)(void *msg),
+					int type) {
+
+	return switch_send_topic(conn, topic, msg, cleaner, type);
+}//
+
 
 
 
@@ -126,6 +443,43 @@ litm_send(	litm_connection *conn,
 	}//
 #endif
 
+/**
+ * Retrieves the next envelope from the connection's
+ *  input queue, skipping those past their deadline:
+ *  they are handed back to the switch right away.
+ *
+ * A skipped envelope counts as received and released by
+ *  the connection; back in the switch, still past its
+ *  deadline, it counts as expired (@see litm_switch_stats).
+ *
+ * @return NULL if none
+ */
+	litm_envelope *
+__litm_receive_next(litm_connection *conn) {
+
+	litm_envelope *e;
+
+	while (1) {
+		e = (litm_envelope *) queue_get_nb( conn->input_queue );
+		if (NULL==e)
+			break;
+
+		if ((0==e->deadline) || (monotonic_ns() < e->deadline))
+			break;
+
+		conn->received++;
+		switch_release( conn, e );
+	}
+
+	if ((NULL!=e) && (0!=(e->stamps).sent))
+		(e->stamps).received = monotonic_ns();
+
+	if (NULL!=e)
+		flight_record( LITM_FLIGHT_RECEIVE, e->id, conn->index );
+
+	return e;
+}//
+
 /**
  * Receive (non-blocking) function for clients
  *
@@ -142,7 +496,7 @@ litm_receive_nb(litm_connection *conn, litm_envelope **envlp) {
 	}
 	int returnCode = LITM_CODE_OK; //optimistic
 
-	*envlp = queue_get_nb( conn->input_queue );
+	*envlp = __litm_receive_next( conn );
 	if (NULL==*envlp) {
 		returnCode=LITM_CODE_NO_MESSAGE;
 	} else {
@@ -170,7 +524,7 @@ litm_receive_wait(litm_connection *conn, litm_envelope **envlp) {
 		// conditional waiting on the queue.
 		// This also takes care of the probability of
 		//  missing a signal for whatever reason
-		*envlp = queue_get_nb( conn->input_queue );
+		*envlp = __litm_receive_next( conn );
 		if (NULL!=*envlp) {
 			DEBUG_FUNC(_litm_log_timediff(*envlp));
 			conn->received++;
@@ -210,7 +564,7 @@ litm_receive_wait_timer(litm_connection *conn, litm_envelope **envlp, int usec_t
 	// conditional waiting on the queue.
 	// This also takes care of the probability of
 	//  missing a signal for whatever reason
-	*envlp = queue_get_nb( conn->input_queue );
+	*envlp = __litm_receive_next( conn );
 	if (NULL!=*envlp) {
 		DEBUG_FUNC(_litm_log_timediff(*envlp));
 		conn->received++;
@@ -230,7 +584,7 @@ litm_receive_wait_timer(litm_connection *conn, litm_envelope **envlp, int usec_t
 
 	} else {
 
-		*envlp = queue_get_nb( conn->input_queue );
+		*envlp = __litm_receive_next( conn );
 		if (NULL!=*envlp) {
 			DEBUG_FUNC(_litm_log_timediff(*envlp));
 			conn->received++;
@@ -272,6 +626,153 @@ litm_get_message(litm_envelope *envlp, int *type) {
 	return envlp->msg;
 }//
 
+	void
+litm_get_switch_stats(litm_switch_stats *stats) {
+
+	if (NULL==stats) {
+		return;
+	}
+
+	switch_get_stats( stats );
+}//
+
+	void
+litm_get_alloc_stats(litm_alloc_stats *stats) {
+
+	if (NULL==stats) {
+		return;
+	}
+
+	alloc_get_stats( stats );
+}//
+
+	char *
+litm_translate_alloc_class(litm_alloc_class cls) {
+
+	return alloc_class_name( cls );
+}//
+
+	litm_code
+litm_get_lock_stats(litm_lock_stats *stats) {
+
+	return lockprof_get_stats( stats );
+}//
+
+	void
+litm_reset_lock_stats(void) {
+
+	lockprof_reset();
+}//
+
+	char *
+litm_translate_lock(litm_lock lock) {
+
+	return lockprof_name( lock );
+}//
+
+	litm_code
+litm_bus_set_release_timeout(litm_bus bus_id, int usecs) {
+
+	if (( LITM_BUSSES_MAX < bus_id ) || (0>=bus_id)) {
+		return LITM_CODE_ERROR_INVALID_BUS;
+	}
+
+	return watchdog_set_timeout( bus_id, usecs );
+}//
+
+	litm_code
+litm_topic_set_release_timeout(litm_topic topic, int usecs) {
+
+	if ((LITM_TOPICS_MAX <= topic) || (0>topic)) {
+		return LITM_CODE_ERROR_INVALID_TOPIC;
+	}
+
+	return watchdog_set_timeout( LITM_SWITCH_TOPIC_TABLE(topic), usecs );
+}//
+
+	void
+litm_watchdog_set(int usecs) {
+
+	watchdog_set_threshold( usecs );
+}//
+
+	void
+litm_get_watchdog_stats(litm_watchdog_stats *stats) {
+
+	watchdog_get_stats( stats );
+}//
+
+	void
+litm_traffic_set_sampling(int rate) {
+
+	traffic_set_sampling( rate );
+}//
+
+	void
+litm_traffic_reset(void) {
+
+	traffic_reset();
+}//
+
+	void
+litm_get_traffic(litm_traffic_matrix *matrix) {
+
+	traffic_get( matrix );
+}//
+
+	void
+litm_flight_enable(int enable) {
+
+	flight_enable( enable );
+}//
+
+	litm_code
+litm_flight_dump(const char *path) {
+
+	if (NULL==path) {
+		return LITM_CODE_ERROR_IO;
+	}
+
+	return flight_dump( path );
+}//
+
+	litm_code
+litm_flight_dump_on_signal(const char *path) {
+
+	if (NULL==path) {
+		return LITM_CODE_ERROR_IO;
+	}
+
+	return flight_dump_on_signal( path );
+}//
+
+	char *
+litm_translate_flight_code(litm_flight_code code) {
+
+	return flight_code_name( code );
+}//
+
+	void
+litm_set_timestamps(int enable) {
+
+	switch_set_timestamps( enable );
+}//
+
+	litm_code
+litm_get_timestamps(litm_envelope *envlp, litm_timestamps *stamps) {
+
+	if (NULL==envlp) {
+		return LITM_CODE_ERROR_INVALID_ENVELOPE;
+	}
+
+	if (0==(envlp->stamps).sent) {
+		return LITM_CODE_NO_MESSAGE;
+	}
+
+	*stamps = envlp->stamps;
+	return LITM_CODE_OK;
+}//
+
 
 	char *
 litm_translate_code(litm_code code) {
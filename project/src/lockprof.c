@@ -0,0 +1,213 @@
+/**
+ * @file   lockprof.c
+ *
+ * @date   2026-10-19
+ * @author Jean-Lou Dupont
+ *
+ * \section Overview
+ *
+ *			This module implements the lock contention profiler
+ *			behind the LITM_LOCK_* macros of lockprof.h: built with
+ *			LITM_LOCK_PROFILE defined, the library's mutexes are
+ *			taken through these functions which record, per lock,
+ *			the acquisitions, trylock failures, wait & hold times.
+ *
+ *			A lock call first tries the mutex: only when that
+ *			fails is it counted as ``contended`` and its wait timed.
+ *
+ *			The acquisition time is kept per thread and per lock:
+ *			with nested locks sharing a litm_lock (e.g. two connection
+ *			queues), the hold time is the innermost one's.
+ *
+ *			Without LITM_LOCK_PROFILE, only the statistics API remains
+ *			and it answers LITM_CODE_ERROR_NOT_SUPPORTED.
+ *
+ */
+#include <errno.h>
+#include <string.h>
+
+#include "litm.h"
+#include "lockprof.h"
+#include "utils.h"
+
+
+char *LITM_LOCK_NAMES[] = {
+		"switch_queue",
+		"connection_queue",
+		"pool",
+		"tokens",
+		"connections",
+		"pending_deletion",
+		"subscribers",
+		"replay",
+		"topics",
+		"watchdog"
+};
+
+
+	char *
+lockprof_name(litm_lock id) {
+
+	if ((0 > (int) id) || (LITM_LOCKS <= id))
+		return NULL;
+
+	return LITM_LOCK_NAMES[id];
+}//
+
+
+#ifdef LITM_LOCK_PROFILE
+
+litm_lock_stats _lockprof_stats;
+
+// acquisition time of the locks held by the thread
+static __thread unsigned long long __lockprof_acquired[LITM_LOCKS];
+
+
+// PRIVATE
+// -------
+void __lockprof_acquired_now(litm_lock id, unsigned long long now);
+void __lockprof_record(long *hist, unsigned long long *total, unsigned long long *max, unsigned long long ns);
+
+
+
+/**
+ * Locks a mutex, timing the wait if the mutex is taken
+ */
+	int
+lockprof_lock(pthread_mutex_t *mutex, litm_lock id) {
+
+	litm_lock_counters *c = &_lockprof_stats.locks[id];
+	unsigned long long start, now;
+	int rc;
+
+	if (0 == pthread_mutex_trylock( mutex )) {
+		__lockprof_acquired_now( id, monotonic_ns() );
+		return 0;
+	}
+
+	start = monotonic_ns();
+	rc = pthread_mutex_lock( mutex );
+	if (0!=rc)
+		return rc;
+	now = monotonic_ns();
+
+	__sync_fetch_and_add( &c->contended, 1 );
+	__lockprof_record( c->wait_hist, &c->wait_ns, &c->max_wait_ns, now - start );
+	__lockprof_acquired_now( id, now );
+
+	return 0;
+}//
+
+	int
+lockprof_trylock(pthread_mutex_t *mutex, litm_lock id) {
+
+	int rc = pthread_mutex_trylock( mutex );
+
+	if (EBUSY==rc)
+		__sync_fetch_and_add( &_lockprof_stats.locks[id].trylock_failures, 1 );
+	else if (0==rc)
+		__lockprof_acquired_now( id, monotonic_ns() );
+
+	return rc;
+}//
+
+	int
+lockprof_unlock(pthread_mutex_t *mutex, litm_lock id) {
+
+	litm_lock_counters *c = &_lockprof_stats.locks[id];
+
+	__lockprof_record( c->hold_hist, &c->hold_ns, &c->max_hold_ns, monotonic_ns() - __lockprof_acquired[id] );
+
+	return pthread_mutex_unlock( mutex );
+}//
+
+/**
+ * Waits on a condition: the mutex is released in
+ *  the meantime thus the hold ends & restarts
+ */
+	int
+lockprof_cond_wait(pthread_cond_t *cond, pthread_mutex_t *mutex, litm_lock id, const struct timespec *abstime) {
+
+	litm_lock_counters *c = &_lockprof_stats.locks[id];
+	int rc;
+
+	__lockprof_record( c->hold_hist, &c->hold_ns, &c->max_hold_ns, monotonic_ns() - __lockprof_acquired[id] );
+
+	if (NULL==abstime)
+		rc = pthread_cond_wait( cond, mutex );
+	else
+		rc = pthread_cond_timedwait( cond, mutex, abstime );
+
+	__lockprof_acquired[id] = monotonic_ns();
+
+	return rc;
+}//
+
+	litm_code
+lockprof_get_stats(litm_lock_stats *stats) {
+
+	if (NULL!=stats)
+		*stats = _lockprof_stats;
+
+	return LITM_CODE_OK;
+}//
+
+/**
+ * Not synchronized with the lock calls in progress:
+ *  a few of their updates might survive the reset
+ */
+	void
+lockprof_reset(void) {
+
+	memset( &_lockprof_stats, 0, sizeof(litm_lock_stats) );
+}//
+
+
+	void
+__lockprof_acquired_now(litm_lock id, unsigned long long now) {
+
+	__sync_fetch_and_add( &_lockprof_stats.locks[id].acquisitions, 1 );
+	__lockprof_acquired[id] = now;
+}//
+
+	void
+__lockprof_record(long *hist, unsigned long long *total, unsigned long long *max, unsigned long long ns) {
+
+	int bucket = (0==ns) ? 0 : 63 - __builtin_clzll( ns );
+	unsigned long long seen, prev;
+
+	if (LITM_LOCK_HIST_BUCKETS <= bucket)
+		bucket = LITM_LOCK_HIST_BUCKETS - 1;
+
+	__sync_fetch_and_add( &hist[bucket], 1 );
+	__sync_fetch_and_add( total, ns );
+
+	// a concurrent lower value mustn't overwrite a higher one
+	seen = *max;
+	while (ns > seen) {
+		prev = __sync_val_compare_and_swap( max, seen, ns );
+		if (prev == seen)
+			break;
+		seen = prev;
+	}
+}//
+
+
+#else
+
+
+	litm_code
+lockprof_get_stats(litm_lock_stats *stats) {
+
+	if (NULL!=stats)
+		memset( stats, 0, sizeof(litm_lock_stats) );
+
+	return LITM_CODE_ERROR_NOT_SUPPORTED;
+}//
+
+	void
+lockprof_reset(void) {
+}//
+
+
+#endif
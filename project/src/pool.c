@@ -19,6 +19,8 @@
 #include "litm.h"
 #include "pool.h"
 #include "logger.h"
+#include "alloc.h"
+#include "lockprof.h"
 
 	// PRIVATE //
 	// ======= //
@@ -32,6 +34,11 @@
 
 	pthread_mutex_t  _pool_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+	litm_token * _token_stack[LITM_POOL_SIZE];
+	int _token_top = 0;  // number of tokens on the stack
+
+	pthread_mutex_t  _token_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 /**
  * Recyles an ``envelope`` by either:
  * - putting it on a stack for later recall
@@ -46,7 +53,12 @@
 	void
 __litm_pool_recycle( litm_envelope *envlp ) {
 
-	pthread_mutex_lock( &_pool_mutex );
+	#ifdef _DEBUG
+		alloc_free( LITM_ALLOC_DEBUG, envlp->sent_time, sizeof(struct timeval) );
+		envlp->sent_time = NULL;
+	#endif
+
+	LITM_MUTEX_LOCK( &_pool_mutex, LITM_LOCK_POOL );
 
 	//can we recycle this one?
 	if ( _top_stack + 1 == LITM_POOL_SIZE ) {
@@ -62,7 +74,7 @@ __litm_pool_recycle( litm_envelope *envlp ) {
 		_recycled ++;
 	}
 
-	pthread_mutex_unlock( &_pool_mutex );
+	LITM_MUTEX_UNLOCK( &_pool_mutex, LITM_LOCK_POOL );
 
 }//
 
@@ -80,7 +92,7 @@ __litm_pool_recycle( litm_envelope *envlp ) {
 	litm_envelope *
 __litm_pool_get(void) {
 
-	pthread_mutex_lock( &_pool_mutex );
+	LITM_MUTEX_LOCK( &_pool_mutex, LITM_LOCK_POOL );
 
 
 	// first time around?
@@ -113,7 +125,7 @@ __litm_pool_get(void) {
 	} else {
 
 		// prepare a new one
-		e = malloc(sizeof(litm_envelope));
+		e = alloc_malloc(LITM_ALLOC_ENVELOPE, sizeof(litm_envelope));
 		if (NULL!=e) {
 
 			// prepare the envelope
@@ -127,7 +139,7 @@ __litm_pool_get(void) {
 
 	}
 
-	pthread_mutex_unlock( &_pool_mutex );
+	LITM_MUTEX_UNLOCK( &_pool_mutex, LITM_LOCK_POOL );
 	return e;
 }//
 
@@ -149,7 +161,7 @@ __litm_pool_destroy( litm_envelope *envlp ) {
 	}
 	//DEBUG_LOG(LOG_DEBUG, "__litm_pool_destroy: envelope [%x]", envlp );
 
-	free( envlp );
+	alloc_free( LITM_ALLOC_ENVELOPE, envlp, sizeof(litm_envelope) );
 
 }//
 
@@ -171,12 +183,121 @@ __litm_pool_clean( litm_envelope *envlp ) {
 	(envlp->routes).current_conn = NULL;
 	(envlp->routes).sender  = NULL;
 	(envlp->routes).pending = 0;
+	(envlp->routes).key     = 0;
+	(envlp->routes).slot    = -1;
+	(envlp->routes).target  = NULL;
+	(envlp->routes).bus_set = 0;
 
 	envlp->cleaner = NULL;
+	envlp->payload = NULL;
+	envlp->token   = NULL;
+	envlp->correlation = 0;
 	envlp->msg     = NULL;
 
 	envlp->type    = LITM_MESSAGE_TYPE_INVALID;
+	envlp->priority = LITM_PRIORITY_NORMAL;
+	envlp->deadline = 0;
 
 	envlp->delivery_count = 0;
 	envlp->released_count = 0;
+
+	// a fresh envelope might go straight back to the pool
+	#ifdef _DEBUG
+		envlp->sent_time = NULL;
+	#endif
+}//
+
+
+/**
+ * Creates a shared payload
+ */
+	litm_payload *
+__litm_payload_create( void *msg, void (*cleaner)(void *msg), int refs ) {
+
+	litm_payload *payload = (litm_payload *) alloc_malloc( LITM_ALLOC_PAYLOAD, sizeof(litm_payload) );
+	if (NULL==payload) {
+		DEBUG_LOG(LOG_DEBUG, "__litm_payload_create: MALLOC ERROR");
+		return NULL;
+	}
+
+	payload->refs    = refs;
+	payload->msg     = msg;
+	payload->cleaner = cleaner;
+
+	return payload;
+}//
+
+	void
+__litm_payload_ref( litm_payload *payload ) {
+
+	__sync_fetch_and_add( &payload->refs, 1 );
+}//
+
+/**
+ * Drops a reference: the thread dropping the last
+ *  one disposes of the message
+ */
+	void
+__litm_payload_release( litm_payload *payload ) {
+
+	if (1 != __sync_fetch_and_sub( &payload->refs, 1 ))
+		return;
+
+	if (NULL==payload->cleaner)
+		free( payload->msg );
+	else
+		(*payload->cleaner)( payload->msg );
+
+	alloc_free( LITM_ALLOC_PAYLOAD, payload, sizeof(litm_payload) );
+}//
+
+
+/**
+ * Retrieves a ``token`` from the stack or the heap
+ */
+	litm_token *
+__litm_token_get(void) {
+
+	litm_token *token = NULL;
+
+	LITM_MUTEX_LOCK( &_token_mutex, LITM_LOCK_TOKENS );
+
+		if (0 < _token_top)
+			token = _token_stack[ --_token_top ];
+
+	LITM_MUTEX_UNLOCK( &_token_mutex, LITM_LOCK_TOKENS );
+
+	if (NULL==token) {
+		token = (litm_token *) alloc_malloc( LITM_ALLOC_TOKEN, sizeof(litm_token) );
+		if (NULL==token) {
+			DEBUG_LOG(LOG_DEBUG, "__litm_token_get: MALLOC ERROR");
+			return NULL;
+		}
+	}
+
+	token->state     = 0;
+	token->waiters   = 0;
+	token->refs      = 2;
+	token->delivered = 0;
+	token->released  = 0;
+
+	return token;
+}//
+
+	void
+__litm_token_put( litm_token *token ) {
+
+	if (1 != __sync_fetch_and_sub( &token->refs, 1 ))
+		return;
+
+	LITM_MUTEX_LOCK( &_token_mutex, LITM_LOCK_TOKENS );
+
+		if (LITM_POOL_SIZE > _token_top) {
+			_token_stack[ _token_top++ ] = token;
+			token = NULL;
+		}
+
+	LITM_MUTEX_UNLOCK( &_token_mutex, LITM_LOCK_TOKENS );
+
+	alloc_free( LITM_ALLOC_TOKEN, token, sizeof(litm_token) );
 }//
@@ -12,20 +12,69 @@
  * The term ``node`` is used generically to refer
  * to a node element inside a queue.
  *
+ * \section Priorities
+ *
+ * A queue is made of LITM_PRIORITY_LEVELS sub-queues (``lanes``):
+ * nodes are dequeued in priority order and in FIFO order inside
+ * a lane.  To prevent starvation, a lane which is passed over
+ * LITM_PRIORITY_QUOTA times in favor of higher priority lanes
+ * gets served next.
+ *
+ * \section Backends
+ *
+ * The operations of a queue go through the ``queue_ops`` table
+ * selected at creation time (@see queue_create_ex):
+ *
+ * - LIST: mutex protected linked list (this file)
+ * - MPSC: lock-free list, any number of producers & one consumer
+ * - SPSC: bounded rings, one producer & one consumer
+ * - MPMC: bounded arrays, any number of producers & consumers
+ *
+ * The lock-free backends live in queue_lf.c: their mutex &
+ * condition variable are only used whenever a consumer needs
+ * to sleep.
+ *
  */
 
 #include <pthread.h>
 #include <errno.h>
+#include <string.h>
+#include <sys/time.h>
 
 #include "logger.h"
 #include "litm.h"
 #include "queue.h"
+#include "alloc.h"
+#include "lockprof.h"
 
 // PRIVATE
 // =======
+
 void *__queue_get_safe(queue *q);
 int   queue_put_head_safe( queue *q, void *node );
-int queue_put_safe( queue *q, void *node );
+int   queue_put_safe( queue *q, void *node, int priority );
+
+const queue_ops *__queue_ops_for(litm_queue_backend backend);
+litm_queue_backend __queue_backend_parse(const char *name);
+
+/**
+ * Backend selected per role, LITM_QUEUE_BACKEND_DEFAULT
+ *  meaning ``from the environment or built-in``
+ */
+static litm_queue_backend _queue_backends[LITM_QUEUE_ROLE_MAX] = {
+	LITM_QUEUE_BACKEND_DEFAULT,
+	LITM_QUEUE_BACKEND_DEFAULT
+};
+
+static const char *_queue_backend_env[LITM_QUEUE_ROLE_MAX] = {
+	"LITM_SWITCH_QUEUE",
+	"LITM_CONNECTION_QUEUE"
+};
+
+static const litm_queue_backend _queue_backend_builtin[LITM_QUEUE_ROLE_MAX] = {
+	LITM_QUEUE_BACKEND_LIST,
+	LITM_QUEUE_BACKEND_SPSC
+};
 
 
 
@@ -34,20 +83,48 @@ int queue_put_safe( queue *q, void *node );
  */
 queue *queue_create(int id) {
 
-	pthread_cond_t *cond = malloc( sizeof (pthread_cond_t) );
+	return queue_create_ex( id, LITM_QUEUE_BACKEND_LIST, 0 );
+}// init
+
+/**
+ * Creates a queue with a specific backend
+ *
+ * @param id       queue identifier
+ * @param backend  one of LITM_QUEUE_BACKEND_*
+ * @param capacity number of slots per priority lane for the
+ *                 bounded backends, rounded up to a power of 2
+ *
+ * @return NULL on malloc error or invalid backend
+ */
+queue *queue_create_ex(int id, litm_queue_backend backend, int capacity) {
+
+	const queue_ops *ops = __queue_ops_for( backend );
+	if (NULL == ops) {
+		DEBUG_LOG(LOG_DEBUG, "queue_create_ex: INVALID BACKEND [%i]", backend);
+		return NULL;
+	}
+
+	pthread_cond_t *cond = alloc_malloc( LITM_ALLOC_QUEUE, sizeof (pthread_cond_t) );
 	if (NULL == cond) {
 		return NULL;
 	}
 
 	// if this malloc fails,
 	//  there are much bigger problems that loom
-	pthread_mutex_t *mutex = malloc( sizeof(pthread_mutex_t) );
-	queue *q = malloc( sizeof(queue) );
+	pthread_mutex_t *mutex = alloc_malloc( LITM_ALLOC_QUEUE, sizeof(pthread_mutex_t) );
+	queue *q = alloc_malloc( LITM_ALLOC_QUEUE, sizeof(queue) );
 
 	if ((NULL != q) && (NULL != mutex)){
 
-		q->head  = NULL;
-		q->tail  = NULL;
+		int lane;
+		for (lane=0; lane<LITM_PRIORITY_LEVELS; lane++) {
+			q->head[lane]    = NULL;
+			q->tail[lane]    = NULL;
+			q->skipped[lane] = 0;
+		}
+		q->ops     = ops;
+		q->impl    = NULL;
+		q->waiting = 0;
 		q->num   = 0;
 		q->id    = id;
 		q->total_in  = 0;
@@ -59,20 +136,128 @@ queue *queue_create(int id) {
 		q->mutex      = mutex;
 		q->cond       = cond;
 
+		if (0 == ops->init( q, capacity )) {
+			DEBUG_LOG(LOG_DEBUG, "queue_create_ex: BACKEND [%s] INIT ERROR", ops->name);
+			queue_destroy( q );
+			q = NULL;
+		}
+
 	} else {
 
 		DEBUG_LOG(LOG_DEBUG, "queue_create: MALLOC ERROR");
 
-		if (NULL!=q)
-			free(q);
-
-		if (NULL!=mutex)
-			pthread_mutex_destroy(mutex);
+		alloc_free( LITM_ALLOC_QUEUE, q, sizeof(queue) );
+		alloc_free( LITM_ALLOC_QUEUE, mutex, sizeof(pthread_mutex_t) );
+		alloc_free( LITM_ALLOC_QUEUE, cond, sizeof(pthread_cond_t) );
 
+		q = NULL;
 	}
 
 	return q;
-}// init
+}//
+
+	const queue_ops *
+__queue_ops_for(litm_queue_backend backend) {
+
+	switch(backend) {
+	case LITM_QUEUE_BACKEND_LIST: return &_queue_ops_list;
+	case LITM_QUEUE_BACKEND_MPSC: return &_queue_ops_mpsc;
+	case LITM_QUEUE_BACKEND_SPSC: return &_queue_ops_spsc;
+	case LITM_QUEUE_BACKEND_MPMC: return &_queue_ops_mpmc;
+	default:
+		break;
+	}
+
+	return NULL;
+}//
+
+	litm_queue_backend
+__queue_backend_parse(const char *name) {
+
+	if (NULL==name)
+		return LITM_QUEUE_BACKEND_DEFAULT;
+
+	if (0==strcmp(name, "list")) return LITM_QUEUE_BACKEND_LIST;
+	if (0==strcmp(name, "mpsc")) return LITM_QUEUE_BACKEND_MPSC;
+	if (0==strcmp(name, "spsc")) return LITM_QUEUE_BACKEND_SPSC;
+	if (0==strcmp(name, "mpmc")) return LITM_QUEUE_BACKEND_MPMC;
+
+	return LITM_QUEUE_BACKEND_DEFAULT;
+}//
+
+/**
+ * Selects the backend of the queues created for a role
+ *
+ * The switch's queue is fed by many threads, including the
+ *  switch itself when it requeues: a bounded backend could
+ *  deadlock the switch and thus only LIST & MPSC are accepted.
+ *
+ * @return 0 SUCCESS
+ * @return 1 INVALID role / backend
+ */
+	int
+queue_backend_set(litm_queue_role role, litm_queue_backend backend) {
+
+	if ((LITM_QUEUE_ROLE_SWITCH > role) || (LITM_QUEUE_ROLE_MAX <= role))
+		return 1;
+
+	if ((LITM_QUEUE_BACKEND_DEFAULT > backend) || (LITM_QUEUE_BACKEND_MAX <= backend))
+		return 1;
+
+	if (LITM_QUEUE_ROLE_SWITCH == role)
+		if ((LITM_QUEUE_BACKEND_SPSC == backend) || (LITM_QUEUE_BACKEND_MPMC == backend))
+			return 1;
+
+	_queue_backends[role] = backend;
+
+	return 0;
+}//
+
+/**
+ * Returns the backend to use for a role
+ *
+ * An explicit selection wins over the environment
+ *  which wins over the built-in default.
+ */
+	litm_queue_backend
+queue_backend_get(litm_queue_role role) {
+
+	litm_queue_backend backend;
+
+	if ((LITM_QUEUE_ROLE_SWITCH > role) || (LITM_QUEUE_ROLE_MAX <= role))
+		return LITM_QUEUE_BACKEND_LIST;
+
+	backend = _queue_backends[role];
+	if (LITM_QUEUE_BACKEND_DEFAULT != backend)
+		return backend;
+
+	backend = __queue_backend_parse( getenv( _queue_backend_env[role] ) );
+
+	if (LITM_QUEUE_ROLE_SWITCH == role)
+		if ((LITM_QUEUE_BACKEND_SPSC == backend) || (LITM_QUEUE_BACKEND_MPMC == backend)) {
+			DEBUG_LOG(LOG_ERR, "queue_backend_get: bounded backend refused for the switch");
+			backend = LITM_QUEUE_BACKEND_DEFAULT;
+		}
+
+	if (LITM_QUEUE_BACKEND_DEFAULT == backend)
+		backend = _queue_backend_builtin[role];
+
+	return backend;
+}//
+
+/**
+ * Returns the number of nodes in the queue
+ *
+ * For the lock-free backends, the result is only
+ *  indicative.
+ */
+int queue_count(queue *q) {
+
+	if (NULL==q)
+		return 0;
+
+	return q->ops->count( q );
+}//
 
 /**
  * Destroys a queue
@@ -96,15 +281,23 @@ void queue_destroy(queue *q) {
 	}
 	pthread_mutex_t *mutex = q->mutex;
 	pthread_cond_t  *cond  = q->cond;
-
-	pthread_mutex_lock( mutex );
-		free(q);
+	#ifdef LITM_LOCK_PROFILE
+		// the queue is gone by the time of the unlock
+		litm_lock lock_id = QUEUE_LOCK_ID(q);
+	#endif
+
+	LITM_MUTEX_LOCK( mutex, lock_id );
+		q->ops->destroy( q );
+		alloc_free( LITM_ALLOC_QUEUE, q, sizeof(queue) );
 		q=NULL;
-	pthread_mutex_unlock( mutex );
+	LITM_MUTEX_UNLOCK( mutex, lock_id );
 
 	pthread_mutex_destroy(mutex);
 	pthread_cond_destroy(cond);
 
+	alloc_free( LITM_ALLOC_QUEUE, mutex, sizeof(pthread_mutex_t) );
+	alloc_free( LITM_ALLOC_QUEUE, cond, sizeof(pthread_cond_t) );
+
 }//
 
 
@@ -112,35 +305,41 @@ void queue_destroy(queue *q) {
 /**
  * Queues a node (blocking)
  *
+ * The node goes in the LITM_PRIORITY_NORMAL lane.
+ *
  * @return 1 => success
  * @return 0 => error
  *
   */
 int queue_put(queue *q, void *node) {
 
+	return queue_put_prio( q, node, LITM_PRIORITY_NORMAL );
+}//[/queue_put]
+
+/**
+ * Queues a node in the lane ``priority`` (blocking)
+ *
+ * @return 1 => success
+ * @return 0 => error
+ *
+ */
+int queue_put_prio(queue *q, void *node, int priority) {
+
 	if ((NULL==q) || (NULL==node)) {
-		DEBUG_LOG(LOG_DEBUG, "queue_put: NULL queue/node ptr");
+		DEBUG_LOG(LOG_DEBUG, "queue_put_prio: NULL queue/node ptr");
 		return 0;
 	}
 
-	pthread_mutex_lock( q->mutex );
-
-		int code = queue_put_safe( q, node );
-		if (code)
-			pthread_cond_signal( q->cond );
-
-	pthread_mutex_unlock( q->mutex );
-
-	//DEBUG_LOG(LOG_DEBUG,"queue_put: q[%x] node[%x] END",q,node);
-
-	return code;
-}//[/queue_put]
+	return q->ops->put( q, node, priority, LITM_QUEUE_BLOCK );
+}//
 
 
 
 /**
  * Queues a node (non-blocking)
  *
+ * The node goes in the LITM_PRIORITY_NORMAL lane.
+ *
  * @return 1  => success
  * @return 0  => error
  * @return -1 => busy
@@ -148,21 +347,25 @@ int queue_put(queue *q, void *node) {
  */
 int queue_put_nb(queue *q, void *node) {
 
+	return queue_put_prio_nb( q, node, LITM_PRIORITY_NORMAL );
+}//
+
+/**
+ * Queues a node in the lane ``priority`` (non-blocking)
+ *
+ * @return 1  => success
+ * @return 0  => error
+ * @return -1 => busy
+ *
+ */
+int queue_put_prio_nb(queue *q, void *node, int priority) {
+
 	if ((NULL==q) || (NULL==node)) {
-		DEBUG_LOG(LOG_DEBUG, "queue_put_nb: NULL queue/node ptr");
+		DEBUG_LOG(LOG_DEBUG, "queue_put_prio_nb: NULL queue/node ptr");
 		return 0;
 	}
 
-	if (EBUSY == pthread_mutex_trylock( q->mutex ))
-		return -1;
-
-		int code = queue_put_safe( q, node );
-		if (code)
-			pthread_cond_signal( q->cond );
-
-	pthread_mutex_unlock( q->mutex );
-
-	return code;
+	return q->ops->put( q, node, priority, LITM_QUEUE_NB );
 }//
 
 
@@ -181,89 +384,7 @@ queue_put_wait(queue *q, void *node) {
 		return 0;
 	}
 
-	int code;
-
-	while(1) {
-
-		// quick try... hopefully we get lucky
-		if (EBUSY != pthread_mutex_trylock( q->mutex )) {
-			code = queue_put_safe( q, node );
-			if (code)
-				pthread_cond_signal( q->cond );
-
-			pthread_mutex_unlock( q->mutex );
-
-			break;
-
-		} else {
-			//DEBUG_LOG(LOG_DEBUG,"queue_put_wait: BEFORE LOCK q[%x][%i]", q, q->id);
-			pthread_mutex_lock( q->mutex );
-
-				//DEBUG_LOG(LOG_DEBUG,"queue_put_wait: BEFORE COND_WAIT q[%x][%i]", q, q->id);
-				int rc = pthread_cond_wait( q->cond, q->mutex );
-				if (ETIMEDOUT==rc) {
-					code = 1;//not an error to have timed-out really
-					break;
-				} else {
-					code = 0;
-					DEBUG_LOG(LOG_ERR,"queue_put_wait: CONDITION WAIT ERROR");
-				}
-
-			pthread_mutex_unlock( q->mutex );
-			//DEBUG_LOG(LOG_DEBUG,"queue_put_wait: AFTER LOCK q[%x][%i]", q, q->id);
-		}
-
-	}
-
-	return code;
-}//
-
-/**
- * Queue_put_safe
- *
- * Lock is not handled here - the caller must take
- * care of this.
- *
- * @return 0 => error
- * @return 1 => success
- *
- */
-	int
-queue_put_safe( queue *q, void *node ) {
-
-	int code = 1;
-	queue_node *new_node=NULL;
-
-	// if this malloc fails,
-	//  there are much bigger problems that loom
-	new_node = (queue_node *) malloc(sizeof(queue_node));
-	if (NULL!=new_node) {
-
-		// new node...
-		new_node->node = node;
-		new_node->next = NULL;
-
-		// there is a tail... put at the end
-		if (NULL!=q->tail)
-			(q->tail)->next=new_node;
-
-		// point tail to the new element
-		q->tail = new_node;
-
-		// adjust head
-		if (NULL==q->head)
-			q->head=new_node;
-
-		q->total_in++;
-		q->num++;
-		//DEBUG_LOG(LOG_DEBUG,"queue_put_safe: q[%x] id[%i] num[%i] in[%i] out[%i]", q, q->id, q->num, q->total_in, q->total_out);
-
-	} else {
-
-		code = 0;
-	}
-
-	return code;
+	return q->ops->put( q, node, LITM_PRIORITY_NORMAL, LITM_QUEUE_WAIT );
 }//
 
 
@@ -280,14 +401,7 @@ void *queue_get(queue *q) {
 		return NULL;
 	}
 
-	pthread_mutex_lock( q->mutex );
-
-		void *node=NULL;
-		node = __queue_get_safe(q);
-
-	pthread_mutex_unlock( q->mutex );
-
-	return node;
+	return q->ops->get( q, LITM_QUEUE_BLOCK );
 }//[/queue_get]
 
 /**
@@ -303,17 +417,29 @@ void *queue_get_nb(queue *q) {
 		return NULL;
 	}
 
-	if (EBUSY==pthread_mutex_trylock( q->mutex )) {
-		return NULL;
-	}
+	return q->ops->get( q, LITM_QUEUE_NB );
+}//[/queue_get]
 
-		void *node=NULL;
-		node = __queue_get_safe(q);
+/**
+ * Retrieves up to ``max`` nodes from a queue
+ *
+ * The nodes are retrieved in the same order as
+ *  through successive queue_get calls.
+ *
+ * @return the number of nodes retrieved
+ */
+int queue_get_batch(queue *q, void **nodes, int max) {
+
+	if ((NULL==q) || (NULL==nodes)) {
+		DEBUG_LOG(LOG_DEBUG, "queue_get_batch: NULL queue/nodes ptr");
+		return 0;
+	}
 
-	pthread_mutex_unlock( q->mutex );
+	if (0>=max)
+		return 0;
 
-	return node;
-}//[/queue_get]
+	return q->ops->get_batch( q, nodes, max );
+}//
 
 
 /**
@@ -330,27 +456,7 @@ int queue_wait(queue *q) {
 		return 1;
 	}
 
-	//DEBUG_LOG(LOG_DEBUG,"queue_wait: BEFORE LOCK on q[%x][%i]",q,q->id);
-	pthread_mutex_lock( q->mutex );
-
-		// it seems we need to wait...
-		//DEBUG_LOG(LOG_DEBUG,"queue_wait: BEFORE COND_WAIT on q[%x][%i]",q,q->id);
-		int rc = pthread_cond_wait( q->cond, q->mutex );
-
-		//int result2 = pthread_mutex_trylock( q->mutex );
-		//DEBUG_LOG(LOG_DEBUG,"queue_get_wait: TRYLOCK q[%x][%i] result[%i] ",q,q->id,result2==EBUSY);
-
-		if ((ETIMEDOUT==rc) || (0==rc)){
-			rc=0;
-		} else {
-			DEBUG_LOG(LOG_ERR,"queue_get_wait: CONDITION WAIT ERROR, code[%i]", rc);
-			rc=1;
-		}
-
-	pthread_mutex_unlock( q->mutex );
-	//DEBUG_LOG(LOG_DEBUG,"queue_wait: AFTER LOCK on q[%x][%i]",q,q->id);
-
-	return rc;
+	return q->ops->wait( q, -1 );
 }//
 
 /**
@@ -366,80 +472,10 @@ int queue_wait_timer(queue *q, int usec_timer) {
 		return 1;
 	}
 
-	struct timeval now;
-	struct timespec timeout;
-
-	//DEBUG_LOG(LOG_DEBUG,"queue_wait: BEFORE LOCK on q[%x][%i]",q,q->id);
-	pthread_mutex_lock( q->mutex );
-
-		gettimeofday(&now, NULL);
-		timeout.tv_sec  = now.tv_sec;
-		timeout.tv_nsec = now.tv_usec * 1000 + usec_timer*1000;
-		if (timeout.tv_nsec > 1000000000) {
-			timeout.tv_nsec -= 1000000000;
-			timeout.tv_sec ++;
-		}
-
-		// it seems we need to wait...
-		//DEBUG_LOG(LOG_DEBUG,"queue_wait: BEFORE COND_WAIT on q[%x][%i]",q,q->id);
-		int rc = pthread_cond_timedwait( q->cond, q->mutex, &timeout );
-		if ((ETIMEDOUT==rc) || (0==rc)){
-			rc=0;
-		} else {
-			DEBUG_LOG(LOG_DEBUG,"queue_wait_timer: COND ERROR q[%x][%i] result[%i] ",q,q->id,rc);
-			rc=1;
-		}
-
-	pthread_mutex_unlock( q->mutex );
-	//DEBUG_LOG(LOG_DEBUG,"queue_wait: AFTER LOCK on q[%x][%i]",q,q->id);
-
-	return rc;
-}//
-
-void *__queue_get_safe(queue *q) {
-
-	queue_node *tmp = NULL;
-	void *node=NULL;
-
-	tmp = q->head;
-	if (tmp!=NULL) {
-
-		// the queue contained at least one node
-		node = tmp->node;
-
-		// adjust tail: case if tail==head
-		//  ie. only one element present
-		if (q->head == q->tail) {
-			q->tail = NULL;
-			q->head = NULL;
-		} else {
-			// adjust head : next pointer is already set
-			//  to NULL in queue_put
-			q->head = (q->head)->next;
-		}
-
-		//DEBUG_LOG(LOG_DEBUG,"queue_get: MESSAGE PRESENT, freeing queue_node[%x]", tmp);
-		free(tmp);
-
-		q->total_out++;
-		q->num--;
-
-		//{
-		int count=0, in=q->total_in, out=q->total_out;
-		tmp = q->head;
-		while(tmp) {
-			count++;
-			tmp = tmp->next;
-		}
-		//DEBUG_LOG(LOG_DEBUG,"QQQ: q[%x] id[%3i] num[%3i] in[%4i] out[%4i] COUNT[%4i]", q, q->id, q->num, q->total_in, q->total_out, count);
-		if ((in-out) != count) {
-			DEBUG_LOG(LOG_ERR, "__queue_get_safe: >>> ERROR <<<  q[%x][%i]", q, q->id);
-		}
-		//}
-
-	}
+	if (0>usec_timer)
+		usec_timer = 0;
 
-	return node;
+	return q->ops->wait( q, usec_timer );
 }//
 
 /**
@@ -457,17 +493,7 @@ int queue_peek(queue *q) {
 		return -1;
 	}
 
-	queue_node *tmp = NULL;
-	int result = 0;
-
-	pthread_mutex_lock( q->mutex );
-
-		tmp = q->head;
-		result = (tmp!=NULL);
-
-	pthread_mutex_unlock( q->mutex );
-
-	return result;
+	return (0 < q->ops->count( q ));
 } // queue_peek
 
 
@@ -476,13 +502,7 @@ int queue_peek(queue *q) {
 
 void queue_signal(queue *q) {
 
-	pthread_mutex_lock( q->mutex );
-
-		int rc = pthread_cond_signal( q->cond );
-		if (rc)
-			DEBUG_LOG(LOG_DEBUG,"queue_signal: SIGNAL ERROR");
-
-	pthread_mutex_unlock( q->mutex );
+	q->ops->signal( q );
 }
 
 
@@ -491,6 +511,8 @@ void queue_signal(queue *q) {
 /**
  * Queues a node at the HEAD (non-blocking)
  *
+ * @see queue_put_head_safe
+ *
  * @return 1  => success
  * @return 0  => error
  * @return -1 => busy
@@ -504,17 +526,8 @@ queue_put_head_nb(queue *q, void *node) {
 		return 0;
 	}
 
-	if (EBUSY == pthread_mutex_trylock( q->mutex ))
-		return -1;
-
-		int code = queue_put_head_safe( q, node );
-		if (code)
-			pthread_cond_signal( q->cond );
-
-	pthread_mutex_unlock( q->mutex );
-
-	return code;
-}//[/queue_put]
+	return q->ops->put( q, node, LITM_PRIORITY_URGENT, LITM_QUEUE_NB );
+}//[/queue_put]
 
 /**
  * Puts a node at the HEAD of the queue
@@ -535,18 +548,7 @@ int   queue_put_head(queue *q, void *node) {
 		return 0;
 	}
 
-	pthread_mutex_lock( q->mutex );
-
-		int code = queue_put_head_safe( q, node );
-		if (code)
-			pthread_cond_signal( q->cond );
-
-	pthread_mutex_unlock( q->mutex );
-
-	//DEBUG_LOG(LOG_DEBUG,"queue_put: END");
-
-	return code;
-
+	return q->ops->put( q, node, LITM_PRIORITY_URGENT, LITM_QUEUE_BLOCK );
 }//
 
 /**
@@ -564,82 +566,328 @@ queue_put_head_wait(queue *q, void *node) {
 		return 0;
 	}
 
-	int code;
+	return q->ops->put( q, node, LITM_PRIORITY_URGENT, LITM_QUEUE_WAIT );
+}//
 
-	while(1) {
 
-		// quick try... hopefully we get lucky
-		if (EBUSY != pthread_mutex_trylock( q->mutex )) {
 
-			code = queue_put_head_safe( q, node );
-			if (code)
-				pthread_cond_signal( q->cond );
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// BACKEND HELPERS
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
-			pthread_mutex_unlock( q->mutex );
 
+/**
+ * Clamps a priority to a valid lane
+ */
+	int
+__queue_clamp(int priority) {
+
+	if (LITM_PRIORITY_URGENT > priority)
+		return LITM_PRIORITY_URGENT;
+	if (LITM_PRIORITY_LEVELS <= priority)
+		return LITM_PRIORITY_LEVELS - 1;
+
+	return priority;
+}//
+
+/**
+ * Picks the lane to dequeue from
+ *
+ * The highest priority non-empty lane is served unless
+ *  a lower priority lane has been passed over LITM_PRIORITY_QUOTA
+ *  times already.
+ *
+ * Lock is not handled here - the caller must take
+ * care of this (the lock-free backends' consumers need none).
+ *
+ * @return -1 if the queue is empty
+ */
+	int
+__queue_pick_lane(queue *q) {
+
+	int lane, pick = -1;
+
+	// anti-starvation first: lowest priority lane first
+	for (lane=LITM_PRIORITY_LEVELS-1; lane>LITM_PRIORITY_URGENT; lane--) {
+		if ((LITM_PRIORITY_QUOTA <= q->skipped[lane]) && !q->ops->lane_empty(q, lane)) {
+			pick = lane;
 			break;
+		}
+	}
 
-		} else {
+	if (-1==pick) {
+		for (lane=LITM_PRIORITY_URGENT; lane<LITM_PRIORITY_LEVELS; lane++) {
+			if (!q->ops->lane_empty(q, lane)) {
+				pick = lane;
+				break;
+			}
+		}
+	}
+
+	if (-1==pick)
+		return -1;
+
+	q->skipped[pick] = 0;
+	for (lane=pick+1; lane<LITM_PRIORITY_LEVELS; lane++) {
+		if (!q->ops->lane_empty(q, lane))
+			q->skipped[lane]++;
+	}
+
+	return pick;
+}//
+
+/**
+ * Wakes up a sleeping consumer (lock-free backends)
+ *
+ * To be called by a producer once its node is
+ *  published and ``total_in`` is updated.  The fence
+ *  pairs with the one in __queue_lf_wait: either the
+ *  consumer sees the node or the producer sees it waiting.
+ */
+	void
+__queue_notify(queue *q) {
+
+	__atomic_thread_fence( __ATOMIC_SEQ_CST );
+
+	if (0 < __atomic_load_n( &q->waiting, __ATOMIC_RELAXED )) {
+		LITM_MUTEX_LOCK( q->mutex, QUEUE_LOCK_ID(q) );
+			pthread_cond_signal( q->cond );
+		LITM_MUTEX_UNLOCK( q->mutex, QUEUE_LOCK_ID(q) );
+	}
+}//
+
+/**
+ * Waits for a node (lock-free backends)
+ *
+ * Unlike the list backend, the consumer does not go to
+ *  sleep if a node is already present: the producers
+ *  only signal consumers flagged as waiting.
+ *
+ * @param usec_timer maximum wait in microseconds, -1 for none
+ *
+ * @return 0 SUCCESS
+ * @return 1 FAILURE
+ */
+	int
+__queue_lf_wait(queue *q, int usec_timer) {
+
+	struct timeval now;
+	struct timespec timeout;
+	int rc = 0;
+
+	LITM_MUTEX_LOCK( q->mutex, QUEUE_LOCK_ID(q) );
+
+		__atomic_fetch_add( &q->waiting, 1, __ATOMIC_RELAXED );
+		__atomic_thread_fence( __ATOMIC_SEQ_CST );
 
-			//DEBUG_LOG(LOG_DEBUG,"queue_put_head_wait: BEFORE LOCK q[%x][%i]", q, q->id);
-			pthread_mutex_lock( q->mutex );
+		if (0 >= q->ops->count( q )) {
 
-				//DEBUG_LOG(LOG_DEBUG,"queue_put_head_wait: BEFORE COND_WAIT q[%x][%i]", q, q->id);
-				int rc = pthread_cond_wait( q->cond, q->mutex );
-				if (ETIMEDOUT==rc) {
-					rc=1;
-				} else {
-					DEBUG_LOG(LOG_ERR,"queue_put_wait: CONDITION WAIT ERROR, code[%i]",rc);
-					rc=0;
+			if (0>usec_timer) {
+				rc = LITM_COND_WAIT( q->cond, q->mutex, QUEUE_LOCK_ID(q) );
+			} else {
+				gettimeofday(&now, NULL);
+				timeout.tv_sec  = now.tv_sec + usec_timer / 1000000;
+				timeout.tv_nsec = (now.tv_usec + usec_timer % 1000000) * 1000;
+				if (timeout.tv_nsec >= 1000000000) {
+					timeout.tv_nsec -= 1000000000;
+					timeout.tv_sec ++;
 				}
+				rc = LITM_COND_TIMEDWAIT( q->cond, q->mutex, QUEUE_LOCK_ID(q), &timeout );
+			}
+		}
+
+		__atomic_fetch_sub( &q->waiting, 1, __ATOMIC_RELAXED );
 
-			pthread_mutex_unlock( q->mutex );
-			//DEBUG_LOG(LOG_DEBUG,"queue_put_head_wait: AFTER LOCK q[%x][%i]", q, q->id);
+		if ((ETIMEDOUT==rc) || (0==rc)){
+			rc=0;
+		} else {
+			DEBUG_LOG(LOG_DEBUG,"__queue_lf_wait: COND ERROR q[%x][%i] result[%i] ",q,q->id,rc);
+			rc=1;
 		}
 
+	LITM_MUTEX_UNLOCK( q->mutex, QUEUE_LOCK_ID(q) );
+
+	return rc;
+}//
+
+	void
+__queue_cond_signal(queue *q) {
+
+	LITM_MUTEX_LOCK( q->mutex, QUEUE_LOCK_ID(q) );
+
+		int rc = pthread_cond_signal( q->cond );
+		if (rc)
+			DEBUG_LOG(LOG_DEBUG,"queue_signal: SIGNAL ERROR");
+
+	LITM_MUTEX_UNLOCK( q->mutex, QUEUE_LOCK_ID(q) );
+}//
+
+	int
+__queue_lf_count(queue *q) {
+
+	return __atomic_load_n( &q->total_in, __ATOMIC_RELAXED ) - __atomic_load_n( &q->total_out, __ATOMIC_RELAXED );
+}//
+
+	int
+__queue_lf_get_batch(queue *q, void **nodes, int max) {
+
+	int count = 0;
+	void *node;
+
+	while (count < max) {
+		node = q->ops->get( q, LITM_QUEUE_NB );
+		if (NULL==node)
+			break;
+		nodes[count++] = node;
 	}
 
-	return code;
+	return count;
+}//
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LIST BACKEND
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+
+	int
+__queue_list_init(queue *q, int capacity) {
+
+	(void) q;
+	(void) capacity;
 
+	return 1;
 }//
 
+	void
+__queue_list_destroy(queue *q) {
+
+	(void) q;
+}//
 
 /**
- * Puts a node a the HEAD of the queue
- * without regards to thread-safety
+ * Queues a node in the lane ``priority``
  *
- * @return 1  SUCCESS
- * @return 0  ERROR
+ * LITM_QUEUE_BLOCK: waits for the lock
+ * LITM_QUEUE_NB:    @return -1 if the lock is busy
+ * LITM_QUEUE_WAIT:  tries the lock, waits on the condition otherwise
  *
+ * @return 1  => success
+ * @return 0  => error
+ * @return -1 => busy
  */
 	int
-queue_put_head_safe( queue *q, void *msg ) {
+__queue_list_put(queue *q, void *node, int priority, int mode) {
+
+	int code;
+
+	switch(mode) {
+
+	case LITM_QUEUE_NB:
+		if (EBUSY == LITM_MUTEX_TRYLOCK( q->mutex, QUEUE_LOCK_ID(q) ))
+			return -1;
+
+			code = queue_put_safe( q, node, priority );
+			if (code)
+				pthread_cond_signal( q->cond );
+
+		LITM_MUTEX_UNLOCK( q->mutex, QUEUE_LOCK_ID(q) );
+		break;
+
+	case LITM_QUEUE_WAIT:
+		while(1) {
+
+			// quick try... hopefully we get lucky
+			if (EBUSY != LITM_MUTEX_TRYLOCK( q->mutex, QUEUE_LOCK_ID(q) )) {
+				code = queue_put_safe( q, node, priority );
+				if (code)
+					pthread_cond_signal( q->cond );
+
+				LITM_MUTEX_UNLOCK( q->mutex, QUEUE_LOCK_ID(q) );
+
+				break;
+
+			} else {
+				//DEBUG_LOG(LOG_DEBUG,"queue_put_wait: BEFORE LOCK q[%x][%i]", q, q->id);
+				LITM_MUTEX_LOCK( q->mutex, QUEUE_LOCK_ID(q) );
+
+					//DEBUG_LOG(LOG_DEBUG,"queue_put_wait: BEFORE COND_WAIT q[%x][%i]", q, q->id);
+					int rc = LITM_COND_WAIT( q->cond, q->mutex, QUEUE_LOCK_ID(q) );
+					if (ETIMEDOUT==rc) {
+						code = 1;//not an error to have timed-out really
+						break;
+					} else {
+						code = 0;
+						DEBUG_LOG(LOG_ERR,"queue_put_wait: CONDITION WAIT ERROR");
+					}
+
+				LITM_MUTEX_UNLOCK( q->mutex, QUEUE_LOCK_ID(q) );
+				//DEBUG_LOG(LOG_DEBUG,"queue_put_wait: AFTER LOCK q[%x][%i]", q, q->id);
+			}
+
+		}
+		break;
+
+	default:
+		LITM_MUTEX_LOCK( q->mutex, QUEUE_LOCK_ID(q) );
+
+			code = queue_put_safe( q, node, priority );
+			if (code)
+				pthread_cond_signal( q->cond );
+
+		LITM_MUTEX_UNLOCK( q->mutex, QUEUE_LOCK_ID(q) );
+
+		//DEBUG_LOG(LOG_DEBUG,"queue_put: q[%x] node[%x] END",q,node);
+		break;
+	}
+
+	return code;
+}//
+
+/**
+ * Queue_put_safe
+ *
+ * Lock is not handled here - the caller must take
+ * care of this.
+ *
+ * An out-of-range ``priority`` is clamped.
+ *
+ * @return 0 => error
+ * @return 1 => success
+ *
+ */
+	int
+queue_put_safe( queue *q, void *node, int priority ) {
 
 	int code = 1;
-	queue_node *tmp=NULL;
+	queue_node *new_node=NULL;
+
+	priority = __queue_clamp( priority );
 
 	// if this malloc fails,
 	//  there are much bigger problems that loom
-	tmp = (queue_node *) malloc(sizeof(queue_node));
-	if (NULL!=tmp) {
+	new_node = (queue_node *) alloc_malloc(LITM_ALLOC_QUEUE_NODE, sizeof(queue_node));
+	if (NULL!=new_node) {
 
-		tmp->node = msg;
-		tmp->next = NULL;
+		// new node...
+		new_node->node = node;
+		new_node->next = NULL;
 
-		// there is a head... put at the front
-		if (NULL!=q->head) {
-			tmp->next = q->head;
-		}
+		// there is a tail... put at the end
+		if (NULL!=q->tail[priority])
+			(q->tail[priority])->next=new_node;
 
-		// adjust head
-		q->head = tmp;
+		// point tail to the new element
+		q->tail[priority] = new_node;
 
-		// adjust tail
-		if (NULL==q->tail)
-			q->tail=tmp;
+		// adjust head
+		if (NULL==q->head[priority])
+			q->head[priority]=new_node;
 
 		q->total_in++;
 		q->num++;
+		//DEBUG_LOG(LOG_DEBUG,"queue_put_safe: q[%x] id[%i] num[%i] in[%i] out[%i]", q, q->id, q->num, q->total_in, q->total_out);
 
 	} else {
 
@@ -648,3 +896,189 @@ queue_put_head_safe( queue *q, void *msg ) {
 
 	return code;
 }//
+
+/**
+ * Puts a node a the HEAD of the queue
+ * without regards to thread-safety
+ *
+ * The node goes at the end of the LITM_PRIORITY_URGENT lane:
+ *  it overtakes all the other lanes whilst the order amongst
+ *  urgent nodes is preserved.
+ *
+ * @return 1  SUCCESS
+ * @return 0  ERROR
+ *
+ */
+	int
+queue_put_head_safe( queue *q, void *msg ) {
+
+	return queue_put_safe( q, msg, LITM_PRIORITY_URGENT );
+}//
+
+	void *
+__queue_list_get(queue *q, int mode) {
+
+	if (LITM_QUEUE_NB==mode) {
+		if (EBUSY==LITM_MUTEX_TRYLOCK( q->mutex, QUEUE_LOCK_ID(q) )) {
+			return NULL;
+		}
+	} else {
+		LITM_MUTEX_LOCK( q->mutex, QUEUE_LOCK_ID(q) );
+	}
+
+		void *node=NULL;
+		node = __queue_get_safe(q);
+
+	LITM_MUTEX_UNLOCK( q->mutex, QUEUE_LOCK_ID(q) );
+
+	return node;
+}//
+
+/**
+ * Retrieves up to ``max`` nodes under a single lock
+ */
+	int
+__queue_list_get_batch(queue *q, void **nodes, int max) {
+
+	int count = 0;
+	void *node;
+
+	LITM_MUTEX_LOCK( q->mutex, QUEUE_LOCK_ID(q) );
+
+		while (count < max) {
+			node = __queue_get_safe(q);
+			if (NULL==node)
+				break;
+			nodes[count++] = node;
+		}
+
+	LITM_MUTEX_UNLOCK( q->mutex, QUEUE_LOCK_ID(q) );
+
+	return count;
+}//
+
+/**
+ * Waits on the condition
+ *
+ * @param usec_timer maximum wait in microseconds, -1 for none
+ *
+ * @return 0 SUCCESS
+ * @return 1 FAILURE
+ */
+	int
+__queue_list_wait(queue *q, int usec_timer) {
+
+	struct timeval now;
+	struct timespec timeout;
+	int rc;
+
+	//DEBUG_LOG(LOG_DEBUG,"queue_wait: BEFORE LOCK on q[%x][%i]",q,q->id);
+	LITM_MUTEX_LOCK( q->mutex, QUEUE_LOCK_ID(q) );
+
+		if (0>usec_timer) {
+
+			// it seems we need to wait...
+			//DEBUG_LOG(LOG_DEBUG,"queue_wait: BEFORE COND_WAIT on q[%x][%i]",q,q->id);
+			rc = LITM_COND_WAIT( q->cond, q->mutex, QUEUE_LOCK_ID(q) );
+
+		} else {
+
+			gettimeofday(&now, NULL);
+			timeout.tv_sec  = now.tv_sec;
+			timeout.tv_nsec = now.tv_usec * 1000 + usec_timer*1000;
+			if (timeout.tv_nsec > 1000000000) {
+				timeout.tv_nsec -= 1000000000;
+				timeout.tv_sec ++;
+			}
+
+			rc = LITM_COND_TIMEDWAIT( q->cond, q->mutex, QUEUE_LOCK_ID(q), &timeout );
+		}
+
+		if ((ETIMEDOUT==rc) || (0==rc)){
+			rc=0;
+		} else {
+			DEBUG_LOG(LOG_DEBUG,"queue_wait: COND ERROR q[%x][%i] result[%i] ",q,q->id,rc);
+			rc=1;
+		}
+
+	LITM_MUTEX_UNLOCK( q->mutex, QUEUE_LOCK_ID(q) );
+	//DEBUG_LOG(LOG_DEBUG,"queue_wait: AFTER LOCK on q[%x][%i]",q,q->id);
+
+	return rc;
+}//
+
+	int
+__queue_list_count(queue *q) {
+
+	return q->num;
+}//
+
+	int
+__queue_list_lane_empty(queue *q, int lane) {
+
+	return (NULL==q->head[lane]);
+}//
+
+void *__queue_get_safe(queue *q) {
+
+	queue_node *tmp = NULL;
+	void *node=NULL;
+
+	int lane = __queue_pick_lane(q);
+	if (-1==lane)
+		return NULL;
+
+	tmp = q->head[lane];
+
+	// the queue contained at least one node
+	node = tmp->node;
+
+	// adjust tail: case if tail==head
+	//  ie. only one element present
+	if (q->head[lane] == q->tail[lane]) {
+		q->tail[lane] = NULL;
+		q->head[lane] = NULL;
+	} else {
+		// adjust head : next pointer is already set
+		//  to NULL in queue_put
+		q->head[lane] = (q->head[lane])->next;
+	}
+
+	//DEBUG_LOG(LOG_DEBUG,"queue_get: MESSAGE PRESENT, freeing queue_node[%x]", tmp);
+	alloc_free(LITM_ALLOC_QUEUE_NODE, tmp, sizeof(queue_node));
+
+	q->total_out++;
+	q->num--;
+
+	#ifdef _DEBUG
+	{
+	int count=0, in=q->total_in, out=q->total_out;
+	for (lane=0; lane<LITM_PRIORITY_LEVELS; lane++) {
+		tmp = q->head[lane];
+		while(tmp) {
+			count++;
+			tmp = tmp->next;
+		}
+	}
+	//DEBUG_LOG(LOG_DEBUG,"QQQ: q[%x] id[%3i] num[%3i] in[%4i] out[%4i] COUNT[%4i]", q, q->id, q->num, q->total_in, q->total_out, count);
+	if ((in-out) != count) {
+		DEBUG_LOG(LOG_ERR, "__queue_get_safe: >>> ERROR <<<  q[%x][%i]", q, q->id);
+	}
+	}
+	#endif
+
+	return node;
+}//
+
+const queue_ops _queue_ops_list = {
+	"list",
+	&__queue_list_init,
+	&__queue_list_destroy,
+	&__queue_list_put,
+	&__queue_list_get,
+	&__queue_list_get_batch,
+	&__queue_list_wait,
+	&__queue_cond_signal,
+	&__queue_list_count,
+	&__queue_list_lane_empty
+};
@@ -0,0 +1,559 @@
+/**
+ * @file queue_lf.c
+ *
+ * @date 2026-10-19
+ * @author: Jean-Lou Dupont
+ *
+ *
+ * Lock-free queue backends
+ *
+ * - MPSC: unbounded list, any number of producers & a single consumer.
+ *         Producers swap the tail, the consumer follows the ``next``
+ *         pointers; the last dequeued node serves as the ``stub``.
+ *
+ * - SPSC: bounded rings, a single producer & a single consumer.
+ *         The producer's and the consumer's indices live on separate
+ *         cache lines; each side keeps a cached copy of the other
+ *         side's index so that the shared line is only read when the
+ *         ring looks full / empty.
+ *
+ * - MPMC: bounded arrays, any number of producers & consumers.
+ *         Each cell carries a sequence number telling whether it is
+ *         ready for the next producer or the next consumer.
+ *
+ * All of them have one structure per priority lane and share the
+ * lane selection of __queue_pick_lane: with many consumers (MPMC),
+ * the anti-starvation counters are only indicative.
+ *
+ * For the bounded backends, a ``put`` in LITM_QUEUE_NB mode returns
+ * -1 when the lane is full whereas the other modes yield until room
+ * is made.
+ *
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+
+#include "logger.h"
+#include "litm.h"
+#include "queue.h"
+#include "alloc.h"
+
+// PRIVATE
+// =======
+
+#define LITM_CACHE_LINE 64
+
+	static unsigned int
+__queue_lf_size(int capacity) {
+
+	unsigned int size = 2;
+
+	if (0 >= capacity)
+		capacity = LITM_QUEUE_RING_SIZE;
+
+	while (size < (unsigned int) capacity)
+		size <<= 1;
+
+	return size;
+}//
+
+	static void *
+__queue_lf_alloc(size_t size) {
+
+	return alloc_memalign( LITM_ALLOC_QUEUE, LITM_CACHE_LINE, size );
+}//
+
+	static void
+__queue_lf_published(queue *q) {
+
+	__atomic_fetch_add( &q->total_in, 1, __ATOMIC_RELAXED );
+	__queue_notify( q );
+}//
+
+	static int
+__queue_lf_full(int mode) {
+
+	if (LITM_QUEUE_NB==mode)
+		return 1;
+
+	sched_yield();
+
+	return 0;
+}//
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// MPSC
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+struct _queue_mpsc_node {
+	struct _queue_mpsc_node *next;
+	void *node;
+};
+
+struct _queue_mpsc {
+
+	// producers side
+	struct _queue_mpsc_node *tail[LITM_PRIORITY_LEVELS];
+
+	// consumer side
+	struct _queue_mpsc_node *head[LITM_PRIORITY_LEVELS]  __attribute__((aligned(LITM_CACHE_LINE)));
+
+} __attribute__((aligned(LITM_CACHE_LINE)));
+
+
+	static int
+__queue_mpsc_init(queue *q, int capacity) {
+
+	struct _queue_mpsc *m;
+	int lane;
+
+	(void) capacity;
+
+	m = (struct _queue_mpsc *) __queue_lf_alloc( sizeof(struct _queue_mpsc) );
+	if (NULL==m)
+		return 0;
+
+	q->impl = m;
+
+	for (lane=0; lane<LITM_PRIORITY_LEVELS; lane++) {
+		m->head[lane] = (struct _queue_mpsc_node *) alloc_malloc( LITM_ALLOC_QUEUE_NODE, sizeof(struct _queue_mpsc_node) );
+		if (NULL==m->head[lane])
+			return 0;
+		m->head[lane]->next = NULL;
+		m->head[lane]->node = NULL;
+		m->tail[lane] = m->head[lane];
+	}
+
+	return 1;
+}//
+
+	static void
+__queue_mpsc_destroy(queue *q) {
+
+	struct _queue_mpsc *m = (struct _queue_mpsc *) q->impl;
+	struct _queue_mpsc_node *n, *next;
+	int lane;
+
+	if (NULL==m)
+		return;
+
+	for (lane=0; lane<LITM_PRIORITY_LEVELS; lane++) {
+		n = m->head[lane];
+		while (NULL!=n) {
+			next = n->next;
+			alloc_free( LITM_ALLOC_QUEUE_NODE, n, sizeof(struct _queue_mpsc_node) );
+			n = next;
+		}
+	}
+
+	alloc_free( LITM_ALLOC_QUEUE, m, sizeof(struct _queue_mpsc) );
+	q->impl = NULL;
+}//
+
+/**
+ * Never full: only a malloc failure stops a put
+ */
+	static int
+__queue_mpsc_put(queue *q, void *node, int priority, int mode) {
+
+	struct _queue_mpsc *m = (struct _queue_mpsc *) q->impl;
+	struct _queue_mpsc_node *n, *prev;
+
+	(void) mode;
+
+	priority = __queue_clamp( priority );
+
+	n = (struct _queue_mpsc_node *) alloc_malloc( LITM_ALLOC_QUEUE_NODE, sizeof(struct _queue_mpsc_node) );
+	if (NULL==n)
+		return 0;
+
+	n->node = node;
+	n->next = NULL;
+
+	prev = __atomic_exchange_n( &m->tail[priority], n, __ATOMIC_ACQ_REL );
+	__atomic_store_n( &prev->next, n, __ATOMIC_RELEASE );
+
+	__queue_lf_published( q );
+
+	return 1;
+}//
+
+/**
+ * A producer in between swapping the tail and linking
+ *  its node makes the lane look empty for a moment
+ */
+	static int
+__queue_mpsc_lane_empty(queue *q, int lane) {
+
+	struct _queue_mpsc *m = (struct _queue_mpsc *) q->impl;
+
+	return (NULL==__atomic_load_n( &m->head[lane]->next, __ATOMIC_ACQUIRE ));
+}//
+
+	static void *
+__queue_mpsc_get(queue *q, int mode) {
+
+	struct _queue_mpsc *m = (struct _queue_mpsc *) q->impl;
+	struct _queue_mpsc_node *head, *next;
+	void *node;
+
+	(void) mode;
+
+	int lane = __queue_pick_lane(q);
+	if (-1==lane)
+		return NULL;
+
+	head = m->head[lane];
+	next = __atomic_load_n( &head->next, __ATOMIC_ACQUIRE );
+
+	// ``next`` becomes the new stub
+	node = next->node;
+	m->head[lane] = next;
+	alloc_free( LITM_ALLOC_QUEUE_NODE, head, sizeof(struct _queue_mpsc_node) );
+
+	__atomic_fetch_add( &q->total_out, 1, __ATOMIC_RELAXED );
+
+	return node;
+}//
+
+const queue_ops _queue_ops_mpsc = {
+	"mpsc",
+	&__queue_mpsc_init,
+	&__queue_mpsc_destroy,
+	&__queue_mpsc_put,
+	&__queue_mpsc_get,
+	&__queue_lf_get_batch,
+	&__queue_lf_wait,
+	&__queue_cond_signal,
+	&__queue_lf_count,
+	&__queue_mpsc_lane_empty
+};
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// SPSC
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+struct _queue_ring {
+
+	// producer side
+	unsigned int tail[LITM_PRIORITY_LEVELS];
+	unsigned int cached_head[LITM_PRIORITY_LEVELS];
+
+	// consumer side
+	unsigned int head[LITM_PRIORITY_LEVELS]        __attribute__((aligned(LITM_CACHE_LINE)));
+	unsigned int cached_tail[LITM_PRIORITY_LEVELS];
+
+	// read-only
+	unsigned int mask                              __attribute__((aligned(LITM_CACHE_LINE)));
+	void **slots[LITM_PRIORITY_LEVELS];
+
+} __attribute__((aligned(LITM_CACHE_LINE)));
+
+
+	static int
+__queue_spsc_init(queue *q, int capacity) {
+
+	struct _queue_ring *r;
+	unsigned int size = __queue_lf_size( capacity );
+	int lane;
+
+	r = (struct _queue_ring *) __queue_lf_alloc( sizeof(struct _queue_ring) );
+	if (NULL==r)
+		return 0;
+
+	q->impl = r;
+	r->mask = size - 1;
+
+	for (lane=0; lane<LITM_PRIORITY_LEVELS; lane++) {
+		r->slots[lane] = (void **) alloc_malloc( LITM_ALLOC_QUEUE, size * sizeof(void *) );
+		if (NULL==r->slots[lane])
+			return 0;
+	}
+
+	return 1;
+}//
+
+	static void
+__queue_spsc_destroy(queue *q) {
+
+	struct _queue_ring *r = (struct _queue_ring *) q->impl;
+	int lane;
+
+	if (NULL==r)
+		return;
+
+	for (lane=0; lane<LITM_PRIORITY_LEVELS; lane++)
+		alloc_free( LITM_ALLOC_QUEUE, r->slots[lane], (r->mask + 1) * sizeof(void *) );
+
+	alloc_free( LITM_ALLOC_QUEUE, r, sizeof(struct _queue_ring) );
+	q->impl = NULL;
+}//
+
+/**
+ * Puts a node in a ring (producer side)
+ *
+ * @return 1  SUCCESS
+ * @return -1 FULL (LITM_QUEUE_NB only)
+ */
+	static int
+__queue_spsc_put(queue *q, void *node, int priority, int mode) {
+
+	struct _queue_ring *r = (struct _queue_ring *) q->impl;
+	unsigned int tail;
+
+	priority = __queue_clamp( priority );
+	tail = r->tail[priority];
+
+	while (r->mask < tail - r->cached_head[priority]) {
+		r->cached_head[priority] = __atomic_load_n( &r->head[priority], __ATOMIC_ACQUIRE );
+		if (r->mask < tail - r->cached_head[priority])
+			if (__queue_lf_full(mode))
+				return -1;
+	}
+
+	r->slots[priority][tail & r->mask] = node;
+	__atomic_store_n( &r->tail[priority], tail + 1, __ATOMIC_RELEASE );
+
+	__queue_lf_published( q );
+
+	return 1;
+}//
+
+/**
+ * Verifies if a lane is empty (consumer side)
+ */
+	static int
+__queue_spsc_lane_empty(queue *q, int lane) {
+
+	struct _queue_ring *r = (struct _queue_ring *) q->impl;
+
+	if (r->cached_tail[lane] != r->head[lane])
+		return 0;
+
+	r->cached_tail[lane] = __atomic_load_n( &r->tail[lane], __ATOMIC_ACQUIRE );
+
+	return (r->cached_tail[lane] == r->head[lane]);
+}//
+
+	static void *
+__queue_spsc_get(queue *q, int mode) {
+
+	struct _queue_ring *r = (struct _queue_ring *) q->impl;
+	void *node;
+
+	(void) mode;
+
+	int lane = __queue_pick_lane(q);
+	if (-1==lane)
+		return NULL;
+
+	unsigned int head = r->head[lane];
+
+	node = r->slots[lane][head & r->mask];
+	__atomic_store_n( &r->head[lane], head + 1, __ATOMIC_RELEASE );
+
+	__atomic_fetch_add( &q->total_out, 1, __ATOMIC_RELAXED );
+
+	return node;
+}//
+
+const queue_ops _queue_ops_spsc = {
+	"spsc",
+	&__queue_spsc_init,
+	&__queue_spsc_destroy,
+	&__queue_spsc_put,
+	&__queue_spsc_get,
+	&__queue_lf_get_batch,
+	&__queue_lf_wait,
+	&__queue_cond_signal,
+	&__queue_lf_count,
+	&__queue_spsc_lane_empty
+};
+
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// MPMC
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+struct _queue_mpmc_cell {
+	unsigned int seq;
+	void *node;
+};
+
+struct _queue_mpmc_lane {
+
+	unsigned int enqueue;
+	unsigned int dequeue                        __attribute__((aligned(LITM_CACHE_LINE)));
+	struct _queue_mpmc_cell *cells              __attribute__((aligned(LITM_CACHE_LINE)));
+
+} __attribute__((aligned(LITM_CACHE_LINE)));
+
+struct _queue_mpmc {
+	struct _queue_mpmc_lane lane[LITM_PRIORITY_LEVELS];
+	unsigned int mask;
+};
+
+
+	static int
+__queue_mpmc_init(queue *q, int capacity) {
+
+	struct _queue_mpmc *m;
+	unsigned int size = __queue_lf_size( capacity ), i;
+	int lane;
+
+	m = (struct _queue_mpmc *) __queue_lf_alloc( sizeof(struct _queue_mpmc) );
+	if (NULL==m)
+		return 0;
+
+	q->impl = m;
+	m->mask = size - 1;
+
+	for (lane=0; lane<LITM_PRIORITY_LEVELS; lane++) {
+		m->lane[lane].cells = (struct _queue_mpmc_cell *) alloc_malloc( LITM_ALLOC_QUEUE, size * sizeof(struct _queue_mpmc_cell) );
+		if (NULL==m->lane[lane].cells)
+			return 0;
+
+		for (i=0; i<size; i++)
+			m->lane[lane].cells[i].seq = i;
+	}
+
+	return 1;
+}//
+
+	static void
+__queue_mpmc_destroy(queue *q) {
+
+	struct _queue_mpmc *m = (struct _queue_mpmc *) q->impl;
+	int lane;
+
+	if (NULL==m)
+		return;
+
+	for (lane=0; lane<LITM_PRIORITY_LEVELS; lane++)
+		alloc_free( LITM_ALLOC_QUEUE, m->lane[lane].cells, (m->mask + 1) * sizeof(struct _queue_mpmc_cell) );
+
+	alloc_free( LITM_ALLOC_QUEUE, m, sizeof(struct _queue_mpmc) );
+	q->impl = NULL;
+}//
+
+	static int
+__queue_mpmc_put(queue *q, void *node, int priority, int mode) {
+
+	struct _queue_mpmc *m = (struct _queue_mpmc *) q->impl;
+	struct _queue_mpmc_lane *l;
+	struct _queue_mpmc_cell *cell;
+	unsigned int pos, seq;
+	int diff;
+
+	l = &m->lane[ __queue_clamp( priority ) ];
+	pos = __atomic_load_n( &l->enqueue, __ATOMIC_RELAXED );
+
+	while (1) {
+		cell = &l->cells[pos & m->mask];
+		seq  = __atomic_load_n( &cell->seq, __ATOMIC_ACQUIRE );
+		diff = (int) (seq - pos);
+
+		if (0==diff) {
+			if (__atomic_compare_exchange_n( &l->enqueue, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED ))
+				break;
+		} else if (0>diff) {
+			if (__queue_lf_full(mode))
+				return -1;
+			pos = __atomic_load_n( &l->enqueue, __ATOMIC_RELAXED );
+		} else {
+			pos = __atomic_load_n( &l->enqueue, __ATOMIC_RELAXED );
+		}
+	}
+
+	cell->node = node;
+	__atomic_store_n( &cell->seq, pos + 1, __ATOMIC_RELEASE );
+
+	__queue_lf_published( q );
+
+	return 1;
+}//
+
+	static int
+__queue_mpmc_lane_empty(queue *q, int lane) {
+
+	struct _queue_mpmc *m = (struct _queue_mpmc *) q->impl;
+	struct _queue_mpmc_lane *l = &m->lane[lane];
+	unsigned int pos, seq;
+
+	pos = __atomic_load_n( &l->dequeue, __ATOMIC_RELAXED );
+	seq = __atomic_load_n( &l->cells[pos & m->mask].seq, __ATOMIC_ACQUIRE );
+
+	return ((int) (seq - (pos + 1)) < 0);
+}//
+
+/**
+ * Another consumer can win the race for the
+ *  picked lane: the lanes are then picked again.
+ */
+	static void *
+__queue_mpmc_get(queue *q, int mode) {
+
+	struct _queue_mpmc *m = (struct _queue_mpmc *) q->impl;
+	struct _queue_mpmc_lane *l;
+	struct _queue_mpmc_cell *cell;
+	unsigned int pos, seq;
+	int lane, diff;
+	void *node;
+
+	(void) mode;
+
+	while (1) {
+
+		lane = __queue_pick_lane(q);
+		if (-1==lane)
+			return NULL;
+
+		l = &m->lane[lane];
+		pos = __atomic_load_n( &l->dequeue, __ATOMIC_RELAXED );
+
+		while (1) {
+			cell = &l->cells[pos & m->mask];
+			seq  = __atomic_load_n( &cell->seq, __ATOMIC_ACQUIRE );
+			diff = (int) (seq - (pos + 1));
+
+			if (0==diff) {
+				if (__atomic_compare_exchange_n( &l->dequeue, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED ))
+					break;
+			} else if (0>diff) {
+				break;
+			} else {
+				pos = __atomic_load_n( &l->dequeue, __ATOMIC_RELAXED );
+			}
+		}
+
+		if (0>diff)
+			continue; // lane drained by another consumer
+
+		node = cell->node;
+		__atomic_store_n( &cell->seq, pos + m->mask + 1, __ATOMIC_RELEASE );
+
+		__atomic_fetch_add( &q->total_out, 1, __ATOMIC_RELAXED );
+
+		return node;
+	}
+}//
+
+const queue_ops _queue_ops_mpmc = {
+	"mpmc",
+	&__queue_mpmc_init,
+	&__queue_mpmc_destroy,
+	&__queue_mpmc_put,
+	&__queue_mpmc_get,
+	&__queue_lf_get_batch,
+	&__queue_lf_wait,
+	&__queue_cond_signal,
+	&__queue_lf_count,
+	&__queue_mpmc_lane_empty
+};
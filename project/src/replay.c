@@ -0,0 +1,337 @@
+/**
+ * @file   replay.c
+ *
+ * @date   2026-10-19
+ * @author Jean-Lou Dupont
+ *
+ * \section Overview
+ *
+ *			This module implements the per-bus *replay caches*: the
+ *			switch records each new message of a bus with a cache,
+ *			taking a reference on its (shared) payload, and a connection
+ *			subscribing to the bus is *primed* with the cached messages
+ *			through envelopes targeted at it.
+ *
+ *			Priming happens on the switch thread, when it installs the
+ *			subscription (@see LITM_MESSAGE_TYPE_JOIN): the cached messages
+ *			thus reach the subscriber ahead of those sent afterwards.  A
+ *			cached message still on its way to the subscribers of the bus
+ *			isn't primed if the new subscriber lies ahead on its way.
+ *
+ *			The messages are thus kept alive by the cache and not copied:
+ *			the ``cleaner`` of a message runs once it has been evicted
+ *			from the cache *and* all its envelopes are finalized.
+ *
+ *			The caches are protected by _replay_mutex: the switch thread
+ *			only takes it for the busses with a cache.
+ *
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "litm.h"
+#include "switch.h"
+#include "replay.h"
+#include "pool.h"
+#include "alloc.h"
+#include "lockprof.h"
+#include "logger.h"
+
+
+/**
+ * Cached message
+ *
+ * @param payload  the message, one reference held by the cache
+ * @param live     the recorded envelope whilst on its way, NULL once finalized
+ * @param sender   the original sender: only compared, never dereferenced
+ * @param type     message type
+ * @param priority message priority
+ */
+typedef struct {
+	litm_payload *payload;
+	litm_envelope *live;
+	litm_connection *sender;
+	int type;
+	int priority;
+} __litm_replay_entry;
+
+/**
+ * Replay cache of a bus
+ *
+ * @param entries oldest first
+ */
+typedef struct {
+	litm_replay_mode mode;
+	int depth;
+	int count;
+	__litm_replay_entry entries[LITM_REPLAY_DEPTH_MAX];
+} __litm_replay_cache;
+
+
+pthread_mutex_t _replay_mutex = PTHREAD_MUTEX_INITIALIZER;
+__litm_replay_cache *_replays[LITM_BUSSES_MAX+1]; // index 0 is not used
+
+
+// PRIVATE
+// -------
+void __replay_remove(__litm_replay_cache *cache, int index);
+void __replay_record(litm_envelope *e, litm_bus bus_id);
+void __replay_relink(litm_envelope *e, litm_bus bus_id, litm_envelope *live);
+
+
+
+/**
+ * Configures the replay cache of a bus
+ *
+ * Changing the mode empties the cache whereas reducing
+ *  the depth evicts the oldest messages.
+ */
+	litm_code
+replay_set(litm_bus bus_id, litm_replay_mode mode, int depth) {
+
+	__litm_replay_cache *cache;
+
+	if (( LITM_BUSSES_MAX < bus_id ) || (0>=bus_id)) {
+		return LITM_CODE_ERROR_INVALID_BUS;
+	}
+
+	if ((LITM_REPLAY_NONE > mode) || (LITM_REPLAY_MAX <= mode)) {
+		return LITM_CODE_ERROR_INVALID_MODE;
+	}
+
+	if ((LITM_REPLAY_NONE != mode) && ((0 >= depth) || (LITM_REPLAY_DEPTH_MAX < depth))) {
+		return LITM_CODE_ERROR_INVALID_MODE;
+	}
+
+	LITM_MUTEX_LOCK( &_replay_mutex, LITM_LOCK_REPLAY );
+
+		cache = _replays[bus_id];
+
+		if ((NULL==cache) && (LITM_REPLAY_NONE != mode)) {
+			cache = (__litm_replay_cache *) alloc_malloc( LITM_ALLOC_SWITCH, sizeof(__litm_replay_cache) );
+			if (NULL==cache) {
+				LITM_MUTEX_UNLOCK( &_replay_mutex, LITM_LOCK_REPLAY );
+				return LITM_CODE_ERROR_MALLOC;
+			}
+			cache->mode  = mode;
+			cache->count = 0;
+		}
+
+		if (NULL!=cache) {
+
+			if (mode != cache->mode)
+				while (0 < cache->count)
+					__replay_remove( cache, 0 );
+
+			while (depth < cache->count)
+				__replay_remove( cache, 0 );
+
+			cache->mode  = mode;
+			cache->depth = depth;
+
+			if (LITM_REPLAY_NONE == mode) {
+				alloc_free( LITM_ALLOC_SWITCH, cache, sizeof(__litm_replay_cache) );
+				cache = NULL;
+			}
+		}
+
+		_replays[bus_id] = cache;
+
+	LITM_MUTEX_UNLOCK( &_replay_mutex, LITM_LOCK_REPLAY );
+
+	DEBUG_LOG(LOG_DEBUG,"replay_set: bus_id[%i] mode[%i] depth[%i]", bus_id, mode, depth);
+
+	return LITM_CODE_OK;
+}//
+
+/**
+ * Verifies if a bus has a replay cache
+ */
+	int
+replay_enabled(litm_bus bus_id) {
+
+	if (( LITM_BUSSES_MAX < bus_id ) || (0>=bus_id))
+		return 0;
+
+	return (NULL!=_replays[bus_id]);
+}//
+
+/**
+ * Records a new message in the replay cache of its bus(ses)
+ *
+ * Called by the switch thread on the first dispatch of
+ *  an envelope: the envelope's message becomes a shared
+ *  payload if it isn't already.
+ */
+	void
+replay_record(litm_envelope *e) {
+
+	litm_bus bus_id;
+
+	if (0==(e->routes).bus_set) {
+		__replay_record( e, (e->routes).bus_id );
+		return;
+	}
+
+	for (bus_id=1; bus_id<=LITM_BUSSES_MAX; bus_id++)
+		if (LITM_BUS_SET(bus_id) & (e->routes).bus_set)
+			__replay_record( e, bus_id );
+}//
+
+	void
+__replay_record(litm_envelope *e, litm_bus bus_id) {
+
+	__litm_replay_cache *cache;
+	__litm_replay_entry *entry;
+	int index;
+
+	if (( LITM_BUSSES_MAX < bus_id ) || (0>=bus_id))
+		return;
+
+	if ((NULL==_replays[bus_id]) || (LITM_MESSAGE_TYPE_USER_START > e->type))
+		return;
+
+	LITM_MUTEX_LOCK( &_replay_mutex, LITM_LOCK_REPLAY );
+
+		cache = _replays[bus_id];
+		if (NULL==cache) {
+			LITM_MUTEX_UNLOCK( &_replay_mutex, LITM_LOCK_REPLAY );
+			return;
+		}
+
+		if (NULL==e->payload) {
+			e->payload = __litm_payload_create( e->msg, e->cleaner, 1 );
+			if (NULL==e->payload) {
+				LITM_MUTEX_UNLOCK( &_replay_mutex, LITM_LOCK_REPLAY );
+				return;
+			}
+		}
+
+		if (LITM_REPLAY_LAST_PER_TYPE == cache->mode) {
+			for (index=0; index<cache->count; index++) {
+				if (e->type == cache->entries[index].type) {
+					__replay_remove( cache, index );
+					break;
+				}
+			}
+		}
+
+		if (cache->depth == cache->count)
+			__replay_remove( cache, 0 );
+
+		__litm_payload_ref( e->payload );
+
+		entry = &cache->entries[cache->count++];
+		entry->payload  = e->payload;
+		entry->live     = e;
+		entry->sender   = (e->routes).sender;
+		entry->type     = e->type;
+		entry->priority = e->priority;
+
+	LITM_MUTEX_UNLOCK( &_replay_mutex, LITM_LOCK_REPLAY );
+}//
+
+/**
+ * The recorded envelope ``e`` is superseded by ``live``
+ *  (@see switch_reclaim) or, with a NULL ``live``, finalized
+ *
+ * Switch thread only.
+ */
+	void
+replay_relink(litm_envelope *e, litm_envelope *live) {
+
+	litm_bus bus_id;
+
+	if (NULL!=(e->routes).target)
+		return;
+
+	if (0==(e->routes).bus_set) {
+		__replay_relink( e, (e->routes).bus_id, live );
+		return;
+	}
+
+	for (bus_id=1; bus_id<=LITM_BUSSES_MAX; bus_id++)
+		if (LITM_BUS_SET(bus_id) & (e->routes).bus_set)
+			__replay_relink( e, bus_id, live );
+}//
+
+	void
+__replay_relink(litm_envelope *e, litm_bus bus_id, litm_envelope *live) {
+
+	__litm_replay_cache *cache;
+	int index;
+
+	if (( LITM_BUSSES_MAX < bus_id ) || (0>=bus_id))
+		return;
+
+	if (NULL==_replays[bus_id])
+		return;
+
+	LITM_MUTEX_LOCK( &_replay_mutex, LITM_LOCK_REPLAY );
+
+		cache = _replays[bus_id];
+
+		for (index=0; (NULL!=cache) && (index<cache->count); index++) {
+			if (e == cache->entries[index].live) {
+				cache->entries[index].live = live;
+				break;
+			}
+		}
+
+	LITM_MUTEX_UNLOCK( &_replay_mutex, LITM_LOCK_REPLAY );
+}//
+
+/**
+ * Primes a new subscriber with the cached messages of a bus
+ *
+ * The messages are delivered oldest first, but for those still
+ *  on their way which are yet to reach the subscriber: the
+ *  subscriber gets each message once.
+ *
+ * Switch thread only, once the subscription is in place.
+ */
+	void
+replay_prime(litm_connection *conn, litm_bus bus_id) {
+
+	__litm_replay_cache *cache;
+	__litm_replay_entry *entry;
+	int index;
+
+	if (( LITM_BUSSES_MAX < bus_id ) || (0>=bus_id))
+		return;
+
+	if (NULL==_replays[bus_id])
+		return;
+
+	LITM_MUTEX_LOCK( &_replay_mutex, LITM_LOCK_REPLAY );
+
+		cache = _replays[bus_id];
+
+		for (index=0; (NULL!=cache) && (index<cache->count); index++) {
+
+			entry = &cache->entries[index];
+			if (conn == entry->sender)
+				continue;
+
+			if ((NULL!=entry->live) && switch_will_reach( entry->live, bus_id, conn ))
+				continue;
+
+			__litm_payload_ref( entry->payload );
+			switch_deliver_targeted( conn, bus_id, entry->payload, entry->type, entry->priority );
+		}
+
+	LITM_MUTEX_UNLOCK( &_replay_mutex, LITM_LOCK_REPLAY );
+}//
+
+/**
+ * Removes an entry, dropping the cache's reference
+ */
+	void
+__replay_remove(__litm_replay_cache *cache, int index) {
+
+	__litm_payload_release( cache->entries[index].payload );
+
+	cache->count--;
+	memmove( &cache->entries[index], &cache->entries[index+1], (cache->count - index) * sizeof(__litm_replay_entry) );
+}//
@@ -0,0 +1,170 @@
+/**
+ * @file   rpc.c
+ *
+ * @date   2026-10-19
+ * @author Jean-Lou Dupont
+ *
+ * \section Overview
+ *
+ *			This module implements the table of *pending requests*
+ *			behind litm_request / litm_reply.
+ *
+ *			A request claims a slot and is tagged with a *correlation id*
+ *			made of the slot's index and generation.  A reply is handed
+ *			over to the requester through its slot: no bus, no fan-out.
+ *
+ * \section Slots
+ *
+ *			The ``tag`` of a slot is the only synchronization point:
+ *
+ *			- 0: free
+ *			- id: pending, the requester waits on the tag (futex)
+ *			- id | BUSY: a replier is depositing its envelope
+ *			- id | DONE: the reply is available
+ *
+ *			The requester frees its slot on timeout (CAS id -> 0): a
+ *			reply arriving afterwards doesn't match and is dropped.
+ *
+ */
+#include <stdlib.h>
+
+#include "litm.h"
+#include "rpc.h"
+#include "utils.h"
+#include "logger.h"
+
+#define RPC_TAG_BUSY 0x40000000
+#define RPC_TAG_DONE 0x80000000
+#define RPC_TAG_ID   0x3fffffff
+
+typedef struct {
+	volatile int tag;
+	litm_envelope *reply;
+} __litm_rpc_slot;
+
+
+__litm_rpc_slot _rpc_slots[LITM_RPC_SLOTS];
+unsigned int    _rpc_hint = 0;
+unsigned int    _rpc_generation = 0;
+
+
+/**
+ * Claims a free slot
+ *
+ * @return the correlation id, 0 if all slots are taken
+ */
+	unsigned int
+rpc_open(void) {
+
+	__litm_rpc_slot *slot;
+	unsigned int i, index, id;
+	unsigned int start = __sync_fetch_and_add( &_rpc_hint, 1 );
+
+	for (i=0; i<LITM_RPC_SLOTS; i++) {
+
+		index = (start + i) & (LITM_RPC_SLOTS - 1);
+		slot  = &_rpc_slots[index];
+
+		if (0 != slot->tag)
+			continue;
+
+		// a global generation: a late reply never matches
+		//  a later request using the same slot
+		id = ((__sync_add_and_fetch( &_rpc_generation, 1 ) * LITM_RPC_SLOTS) | index) & RPC_TAG_ID;
+		if (index==id)
+			id |= LITM_RPC_SLOTS;
+
+		if (__sync_bool_compare_and_swap( &slot->tag, 0, (int) id )) {
+			slot->reply = NULL;
+			return id;
+		}
+	}
+
+	return 0;
+}//
+
+/**
+ * Frees the slot of a request that couldn't be sent
+ */
+	void
+rpc_cancel(unsigned int correlation) {
+
+	__litm_rpc_slot *slot = &_rpc_slots[correlation & (LITM_RPC_SLOTS - 1)];
+
+	__sync_bool_compare_and_swap( &slot->tag, (int) correlation, 0 );
+}//
+
+/**
+ * Hands a reply over to its requester
+ *
+ * @return 1 if delivered, 0 if the request is gone (timed out, already answered)
+ */
+	int
+rpc_deliver(unsigned int correlation, litm_envelope *reply) {
+
+	__litm_rpc_slot *slot = &_rpc_slots[correlation & (LITM_RPC_SLOTS - 1)];
+
+	if (!__sync_bool_compare_and_swap( &slot->tag, (int) correlation, (int) (correlation | RPC_TAG_BUSY) ))
+		return 0;
+
+	slot->reply = reply;
+
+	__atomic_store_n( &slot->tag, (int) (correlation | RPC_TAG_DONE), __ATOMIC_SEQ_CST );
+	futex_wake( &slot->tag );
+
+	return 1;
+}//
+
+/**
+ * Waits for the reply to a request and frees the slot
+ *
+ * @param usec_timer maximum wait in microseconds, negative for no limit
+ *
+ * @return LITM_CODE_NO_MESSAGE on timeout
+ */
+	litm_code
+rpc_wait(unsigned int correlation, int usec_timer, litm_envelope **reply) {
+
+	__litm_rpc_slot *slot = &_rpc_slots[correlation & (LITM_RPC_SLOTS - 1)];
+	unsigned long long deadline = 0, now;
+	int tag, left = usec_timer;
+
+	if (0<=usec_timer)
+		deadline = monotonic_ns() + (unsigned long long) usec_timer * 1000ULL;
+
+	while (1) {
+
+		tag = __atomic_load_n( &slot->tag, __ATOMIC_SEQ_CST );
+
+		if ((int) (correlation | RPC_TAG_DONE) == tag)
+			break;
+
+		// a replier is about to finish
+		if ((int) (correlation | RPC_TAG_BUSY) == tag) {
+			futex_wait( &slot->tag, tag, 100 );
+			continue;
+		}
+
+		if (0!=deadline) {
+			now = monotonic_ns();
+			if (now >= deadline) {
+				// expire the slot... unless a reply just made it
+				if (__sync_bool_compare_and_swap( &slot->tag, (int) correlation, 0 )) {
+					*reply = NULL;
+					return LITM_CODE_NO_MESSAGE;
+				}
+				continue;
+			}
+			left = (int) ((deadline - now) / 1000ULL);
+		}
+
+		futex_wait( &slot->tag, tag, left );
+	}
+
+	*reply = slot->reply;
+	slot->reply = NULL;
+
+	__atomic_store_n( &slot->tag, 0, __ATOMIC_SEQ_CST );
+
+	return LITM_CODE_OK;
+}//
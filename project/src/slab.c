@@ -0,0 +1,267 @@
+/**
+ * @file   slab.c
+ *
+ * @date   2026-10-19
+ * @author Jean-Lou Dupont
+ *
+ * \section Overview
+ *
+ *			This module implements the *message slabs* behind
+ *			litm_msg_alloc: each connection owns size-classed free
+ *			lists carved out of large chunks.
+ *
+ *			Only the connection's thread allocates; blocks are freed
+ *			by whichever thread finalizes the envelope (usually the
+ *			switch) onto the owner's *remote-free* list, a lock-free
+ *			stack which the owner takes over whole when its local free
+ *			list runs dry.  No block ever goes back to malloc.
+ *
+ *			Requests larger than the biggest class (LITM_MSG_SIZE_MAX)
+ *			are refused.
+ *
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "litm.h"
+#include "slab.h"
+#include "alloc.h"
+#include "logger.h"
+
+
+/**
+ * Block header, right before the message
+ *
+ * @param owner the slab to return the block to
+ * @param cls   the size class
+ * @param next  free list link
+ */
+typedef struct _litm_slab_block {
+	struct _litm_slab *owner;
+	struct _litm_slab_block *next;
+	int cls;
+	int pad;
+	void *reserved; // keeps messages 16-byte aligned
+} __litm_slab_block;
+
+/**
+ * Per-connection slab
+ *
+ * @param free   local free lists, owner thread only
+ * @param remote blocks freed by other threads
+ * @param bump   next free byte of the current chunk
+ * @param end    end of the current chunk
+ * @param chunks chunk addresses, sorted (for slab_owns)
+ */
+typedef struct _litm_slab {
+	__litm_slab_block *free[LITM_SLAB_CLASSES];
+	__litm_slab_block * volatile remote;
+	char *bump;
+	char *end;
+	char **chunks;
+	int chunks_count;
+	int chunks_size;
+} __litm_slab;
+
+
+// PRIVATE
+// -------
+int   __slab_class(size_t size);
+void  __slab_drain_remote(__litm_slab *slab);
+__litm_slab_block *__slab_carve(__litm_slab *slab, int cls);
+
+
+
+/**
+ * Allocates ``size`` bytes for a message
+ *  of connection ``conn``
+ *
+ * Must be called from the connection's thread.
+ *
+ * @return NULL on malloc error
+ */
+	void *
+slab_alloc(litm_connection *conn, size_t size) {
+
+	__litm_slab *slab = (__litm_slab *) conn->slab;
+	__litm_slab_block *block;
+	int cls = __slab_class( size );
+
+	if (-1==cls)
+		return NULL;
+
+	if (NULL==slab) {
+		slab = (__litm_slab *) alloc_calloc( LITM_ALLOC_SLAB, 1, sizeof(__litm_slab) );
+		if (NULL==slab)
+			return NULL;
+		conn->slab = slab;
+	}
+
+	block = slab->free[cls];
+	if (NULL==block) {
+		__slab_drain_remote( slab );
+		block = slab->free[cls];
+	}
+
+	if (NULL==block) {
+		block = __slab_carve( slab, cls );
+		if (NULL==block)
+			return NULL;
+	} else {
+		slab->free[cls] = block->next;
+	}
+
+	return (void *) (block + 1);
+}//
+
+/**
+ * Verifies if ``msg`` comes from the slab of ``conn``
+ *
+ * Must be called from the connection's thread: the
+ *  chunk table is only ever touched by the owner.
+ *
+ * @return 1 if it does
+ */
+	int
+slab_owns(litm_connection *conn, void *msg) {
+
+	__litm_slab *slab = (__litm_slab *) conn->slab;
+	char *p = (char *) msg;
+	int low = 0, high, mid;
+
+	if (NULL==slab)
+		return 0;
+
+	high = slab->chunks_count - 1;
+
+	// last chunk starting at or below ``p``
+	while (low <= high) {
+		mid = (low + high) / 2;
+		if (slab->chunks[mid] <= p)
+			low = mid + 1;
+		else
+			high = mid - 1;
+	}
+
+	if (0 > high)
+		return 0;
+
+	return (p < slab->chunks[high] + LITM_SLAB_CHUNK_SIZE);
+}//
+
+/**
+ * Size class of a block: the room of the message
+ *
+ * Safe from any thread.
+ */
+	size_t
+slab_size(void *msg) {
+
+	__litm_slab_block *block = ((__litm_slab_block *) msg) - 1;
+
+	return ((size_t) 1) << (LITM_SLAB_MIN_SHIFT + block->cls);
+}//
+
+/**
+ * Returns a block to its owner's remote-free list
+ *
+ * Used as the ``cleaner`` of the messages allocated
+ *  through litm_msg_alloc; safe from any thread.
+ */
+	void
+slab_free(void *msg) {
+
+	__litm_slab_block *block = ((__litm_slab_block *) msg) - 1;
+	__litm_slab *slab = block->owner;
+	__litm_slab_block *head;
+
+	do {
+		head = slab->remote;
+		block->next = head;
+	} while (!__sync_bool_compare_and_swap( &slab->remote, head, block ));
+}//
+
+/**
+ * Takes over the remote-free list
+ *
+ * The whole list is swapped out at once: there is a
+ *  single consumer thus no ABA to worry about.
+ */
+	void
+__slab_drain_remote(__litm_slab *slab) {
+
+	__litm_slab_block *block, *next;
+
+	block = __sync_lock_test_and_set( &slab->remote, NULL );
+
+	while (NULL!=block) {
+		next = block->next;
+		block->next = slab->free[block->cls];
+		slab->free[block->cls] = block;
+		block = next;
+	}
+}//
+
+/**
+ * Carves a new block out of the current chunk,
+ *  moving on to a new chunk if needed
+ */
+	__litm_slab_block *
+__slab_carve(__litm_slab *slab, int cls) {
+
+	size_t need = sizeof(__litm_slab_block) + ((size_t) 1 << (cls + LITM_SLAB_MIN_SHIFT));
+	__litm_slab_block *block;
+	char *chunk, **chunks;
+	int index;
+
+	if ((NULL==slab->bump) || (slab->end - slab->bump < (long) need)) {
+
+		if (slab->chunks_count == slab->chunks_size) {
+			chunks = (char **) alloc_realloc( LITM_ALLOC_SLAB, slab->chunks, slab->chunks_size * sizeof(char *), (slab->chunks_size + 16) * sizeof(char *) );
+			if (NULL==chunks)
+				return NULL;
+			slab->chunks = chunks;
+			slab->chunks_size += 16;
+		}
+
+		chunk = (char *) alloc_malloc( LITM_ALLOC_SLAB, LITM_SLAB_CHUNK_SIZE );
+		if (NULL==chunk) {
+			DEBUG_LOG(LOG_DEBUG, "__slab_carve: MALLOC ERROR");
+			return NULL;
+		}
+
+		// keep the chunk table sorted
+		for (index=slab->chunks_count; (0<index) && (slab->chunks[index-1] > chunk); index--)
+			slab->chunks[index] = slab->chunks[index-1];
+		slab->chunks[index] = chunk;
+		slab->chunks_count++;
+
+		slab->bump = chunk;
+		slab->end  = chunk + LITM_SLAB_CHUNK_SIZE;
+	}
+
+	block = (__litm_slab_block *) slab->bump;
+	slab->bump += need;
+
+	block->owner = slab;
+	block->cls   = cls;
+	block->next  = NULL;
+
+	return block;
+}//
+
+/**
+ * @return the size class for ``size``, -1 if too large
+ */
+	int
+__slab_class(size_t size) {
+
+	int cls = 0;
+
+	while (((size_t) 1 << (cls + LITM_SLAB_MIN_SHIFT)) < size) {
+		if (LITM_SLAB_CLASSES == ++cls)
+			return -1;
+	}
+
+	return cls;
+}//
@@ -10,6 +10,13 @@
  *			are presented, turn-wise, to each recipient(s) subscribing
  *			to a particular	*bus*.
  *
+ * \section Work_Queue Work-Queue busses
+ *
+ *			A *bus* configured in one of the *work-queue* modes presents
+ *			each *envelope* to a single recipient only: the recipient is
+ *			picked when the *envelope* is first dispatched and, once it
+ *			is released, the *envelope* is finalized.
+ *
  */
 #include <stdlib.h>
 #include <pthread.h>
@@ -23,6 +30,15 @@
 #include "pool.h"
 #include "connection.h"
 #include "logger.h"
+#include "utils.h"
+#include "replay.h"
+#include "rpc.h"
+#include "slab.h"
+#include "alloc.h"
+#include "lockprof.h"
+#include "flight.h"
+#include "watchdog.h"
+#include "traffic.h"
 
 
 #define LITM_SHUTDOWN_FLAG_TRUE  1
@@ -38,10 +54,88 @@ queue *_switch_queue;
 pthread_t _switchThread;
 int _switchThread_status=0; //not created
 
+// Statistics, only updated by the switch thread
+litm_switch_stats _switch_stats;
+
+// Envelope timestamps: @see litm_set_timestamps
+int _switch_timestamps = 0;
+
+// Envelope serial numbers, for the flight recorder
+unsigned int _switch_envelope_ids = 0;
+
 // Subscriptions to busses
 // -----------------------
+//  The tables following the busses' are used by the
+//  topics: @see LITM_SWITCH_TOPIC_TABLE
 pthread_mutex_t _subscribers_mutex = PTHREAD_MUTEX_INITIALIZER;
-litm_connection *_subscribers[LITM_BUSSES_MAX][LITM_CONNECTION_MAX+1]; // index 0 is not used
+litm_connection *_subscribers[LITM_SWITCH_TABLES][LITM_CONNECTION_MAX+1]; // index 0 is not used
+
+// Subscriptions to busses with a replay cache, until the
+//  switch installs them: @see LITM_MESSAGE_TYPE_JOIN
+litm_connection *_joining[LITM_BUSSES_MAX+1][LITM_CONNECTION_MAX+1];
+
+// Subscription filters on message ``type``
+//  only consulted when the _filtered flag is set
+int           _filtered[LITM_SWITCH_TABLES][LITM_CONNECTION_MAX+1];
+litm_type_set _filters[LITM_SWITCH_TABLES][LITM_CONNECTION_MAX+1];
+
+// Busses configuration
+// --------------------
+#define LITM_CONFLATION_SLOTS (2*LITM_CONFLATION_KEYS)  // at most half full
+
+#define LITM_PARTITION_VNODES 32  // points per subscriber on the hash ring
+
+typedef struct {
+	unsigned int point;
+	int index;		// subscriber index
+} __litm_ring_point;
+
+/**
+ * Consistent hashing ring (partitioned mode)
+ *
+ * Never modified once published: a subscription change
+ *  publishes a new ring and retires the previous one, which
+ *  the switch thread frees once it can't be reading it anymore.
+ *
+ * @param size    the number of points
+ * @param retired next on the list of retired rings
+ * @param points  sorted by ``point``
+ */
+typedef struct _litm_ring {
+	int size;
+	struct _litm_ring *retired;
+	__litm_ring_point points[];
+} __litm_ring;
+
+/**
+ * Conflation slot (conflating mode): the envelope making its
+ *  way through the subscribers and the newest one to follow it
+ */
+typedef struct {
+	int used;
+	unsigned int key;
+	litm_envelope *active;
+	litm_envelope *stash;
+} __litm_conflation_slot;
+
+typedef struct {
+	litm_bus_mode mode;
+	int last;		// index of the last recipient picked (work-queue modes)
+
+	// open addressing table of LITM_CONFLATION_SLOTS slots (conflating mode)
+	//  allocated on first use, only accessed by the switch thread
+	__litm_conflation_slot *slots;
+	int slots_used;
+
+	// consistent hashing ring (partitioned mode), NULL if no subscriber
+	//  published whilst holding _subscribers_mutex, read without locking
+	__litm_ring *ring;
+} __litm_bus_config;
+
+__litm_bus_config _busses[LITM_SWITCH_TABLES]; // index 0 is not used
+
+// the rings replaced since the switch thread last freed them
+__litm_ring *_switch_retired_rings = NULL;
 
 
 // PRIVATE
@@ -49,17 +143,30 @@ litm_connection *_subscribers[LITM_BUSSES_MAX][LITM_CONNECTION_MAX+1]; // index
 void *__switch_thread_function(void *params);
 litm_code __switch_get_next_subscriber(	litm_connection **result,
 										int *result_index,
-										litm_connection *sender,
-										int current,
-										litm_bus bus_id);
-
-int __switch_find_match(litm_connection *sender, int ref, litm_bus bus_id);
+										litm_envelope *e);
+
+int __switch_find_match(litm_connection *sender, int ref, litm_bus bus_id, int type);
+int __switch_find_worker(litm_connection *sender, litm_bus bus_id, int type);
+int __switch_find_partition(litm_connection *sender, litm_bus bus_id, unsigned int key, int type);
+int __switch_find_target(litm_connection *target, litm_bus bus_id, int type);
+int __switch_find_multi(litm_connection *sender, int ref, litm_bus_set bus_set, int type);
+void __switch_build_ring(litm_bus bus_id);
+void __switch_free_retired_rings(void);
+int  __switch_install(litm_connection *conn, litm_bus bus_id);
+void __switch_join(litm_envelope *e);
+unsigned int __switch_hash(unsigned int h);
+int  __switch_conflate(litm_envelope *e);
+void __switch_conflation_done(litm_envelope *e);
 litm_code __switch_try_sending_to_recipient(	litm_connection *recipient, litm_envelope *env);
 litm_code __switch_finalize(litm_envelope *envlp);
+void __switch_resolve(litm_envelope *envlp);
 litm_code __switch_try_sending_or_requeue(litm_connection *conn, litm_envelope *envlp);
 void __switch_init_tables(void);
 void __switch_handle_pending(litm_envelope *e);
-litm_code __switch_safe_send( litm_connection *conn, litm_bus bus_id, void *msg, void (*cleaner)(void *msg), int type );
+litm_envelope *__switch_envelope_create( litm_connection *sender, litm_bus bus_id, void *msg, void (*cleaner)(void *msg), int type );
+litm_envelope *__switch_envelope_prepare( litm_connection *sender, litm_bus bus_id, void *msg, void (*cleaner)(void *msg), int type );
+litm_code __switch_safe_send( litm_envelope *e );
+litm_code __switch_add_subscriber( litm_connection *conn, litm_bus bus_id, const litm_type_set *type_set, int update );
 
 litm_connection *__switch_index_to_connection( int bus_id, int index );
 
@@ -74,7 +181,7 @@ switch_init(void) {
 	if (0== _switchThread_status) {
 
 		// init queue *before* launching thread!
-		_switch_queue = queue_create(-1);
+		_switch_queue = queue_create_ex(-1, queue_backend_get(LITM_QUEUE_ROLE_SWITCH), 0);
 		__switch_init_tables();
 
 		DEBUG_LOG(LOG_INFO, "switch_init: queue[%x] ", _switch_queue);
@@ -88,9 +195,20 @@ switch_init(void) {
 __switch_init_tables(void) {
 	int b, c;
 
-	for (b=0; b<LITM_BUSSES_MAX; b++)
-		for (c=0;c<=LITM_CONNECTION_MAX;c++)
+	for (b=0; b<LITM_SWITCH_TABLES; b++) {
+		for (c=0;c<=LITM_CONNECTION_MAX;c++) {
 			_subscribers[b][c] = NULL;
+			_filtered[b][c] = 0;
+			if (LITM_BUSSES_MAX>=b)
+				_joining[b][c] = NULL;
+		}
+
+		_busses[b].mode = LITM_BUS_MODE_BROADCAST;
+		_busses[b].last = 0;
+		_busses[b].slots = NULL;
+		_busses[b].slots_used = 0;
+		_busses[b].ring = NULL;
+	}
 }
 
 /**
@@ -117,35 +235,102 @@ __switch_thread_function(void *params) {
 	litm_code code;
 	litm_envelope *e;
 	litm_connection *next, *sender, *current_conn;
-	litm_bus bus_id;
 
 	char *err_msg;
 	int type;
 	int shutdown_flag = 0;
-	int current;
 	static char *thisMsg = "__switch_thread_function: conn[%x] code[%s]";
 
 	DEBUG_LOG(LOG_INFO, "__switch_thread_function: STARTING with queue[%x], pid[%u]", _switch_queue, getpid());
 
-	// for stats
-	long delivered=0, dequeued=0, waited=0, pending=0, busy=0;
+	litm_envelope *batch[LITM_SWITCH_BATCH];
+	int batch_count=0, batch_index=0;
+
+	// read at most once per batch
+	unsigned long long now=0;
+
+	// traffic matrix: the turn being sampled, closed
+	//  when the switch gets back to the top of the loop
+	int traffic_weight=0, traffic_sender=0, traffic_type=0;
+	litm_bus traffic_bus=0;
+	unsigned long long traffic_start=0;
 
 	while(1) {
 
+		if (0!=traffic_weight) {
+			traffic_record_dispatch( traffic_sender, traffic_bus, traffic_type, monotonic_ns() - traffic_start, traffic_weight );
+			traffic_weight = 0;
+		}
+
+		// no ring can be in use at this point
+		if (NULL!=__atomic_load_n( &_switch_retired_rings, __ATOMIC_RELAXED ))
+			__switch_free_retired_rings();
+
 		//shutdown signaled?
 		if (LITM_SHUTDOWN_FLAG_TRUE==shutdown_flag) {
 			break;
 		}
 
-		e=(litm_envelope *) queue_get_nb( _switch_queue );
-		if (NULL==e) {
-			waited++;
-			// much better performance using the pthread cond wait
-			queue_wait( _switch_queue );
-			continue;
+		// envelopes are dequeued in batches: one
+		//  lock / round of atomics for many envelopes
+		if (batch_index==batch_count) {
+			batch_index = 0;
+			batch_count = queue_get_batch( _switch_queue, (void **) batch, LITM_SWITCH_BATCH );
+			now = 0;
+			if (watchdog_active())
+				watchdog_check( now = monotonic_ns() );
+			if (0==batch_count) {
+				_switch_stats.waited++;
+				// much better performance using the pthread cond wait
+				//  but the watchdog needs to be woken up to check
+				if (watchdog_active())
+					queue_wait_timer( _switch_queue, LITM_WATCHDOG_PERIOD_USECS );
+				else
+					queue_wait( _switch_queue );
+				continue;
+			}
+		}
+
+		e = batch[batch_index++];
+		_switch_stats.dequeued++;
+
+		// back from its holder
+		if (-1!=e->watch)
+			watchdog_untrack(e);
+
+		// reclaimed by the watchdog: a copy went on its way
+		if (LITM_HELD_RECLAIMED==e->held) {
+			__switch_finalize(e);
+			continue; // <===================================================
+		}
+
+		// a subscription to install, in order with the traffic
+		if (LITM_MESSAGE_TYPE_JOIN==e->type) {
+			__switch_join(e);
+			continue; // <===================================================
+		}
 
-		} else {
-			dequeued++;
+		// stale data is worse than none: an expired envelope
+		//  isn't presented to any further subscriber
+		if (0!=e->deadline) {
+			if (0==now)
+				now = monotonic_ns();
+			if (now >= e->deadline) {
+				_switch_stats.expired++;
+				flight_record( LITM_FLIGHT_EXPIRE, e->id, 0 );
+				__switch_finalize(e);
+				continue; // <===================================================
+			}
+		}
+
+		// a turn on the way to a recipient: the early-outs
+		//  above aren't counted against the sender
+		traffic_weight = traffic_due();
+		if (0!=traffic_weight) {
+			traffic_start  = monotonic_ns();
+			traffic_sender = ((e->routes).sender)->id;
+			traffic_bus    = (e->routes).bus_id;
+			traffic_type   = e->type;
 		}
 
 		//DEBUG_LOG(LOG_INFO, "__switch_thread_function: GOT ENVELOPE");
@@ -166,27 +351,43 @@ __switch_thread_function(void *params) {
 		// message was processed and just sits pending
 
 		if (1==(e->routes).pending) {
-			pending++;
+			_switch_stats.pending++;
 			__switch_handle_pending(e);
 			continue; // <===================================================
 
 		}
 
+		// conflating bus: a newly submitted envelope might
+		//  only be superseding one already on its way
+		if ((LITM_BUS_MODE_CONFLATING==_busses[(e->routes).bus_id].mode)
+				&& (-1==(e->routes).slot) && (-1==(e->routes).current) && (0==e->delivery_count)
+				&& (NULL==(e->routes).target)) {
+			if (__switch_conflate(e))
+				continue; // <===================================================
+		}
+
+		// first dispatch of a new message: keep a copy
+		//  for the late joiners of the bus
+		if ((-1==(e->routes).current) && (0==e->delivery_count) && (0==e->requeued)
+				&& (NULL==(e->routes).target)) {
+			replay_record(e);
+		}
+
 		sender       = (e->routes).sender;
-		current      = (e->routes).current;
 		current_conn = (e->routes).current_conn;
-		bus_id       = (e->routes).bus_id;
 		type         = e->type;
 
 		//int id = litm_connection_get_id( sender );
 		//DEBUG_LOG(LOG_INFO, "__switch_thread_function: bus[%u] sender[%x] current[%x] envelope[%x] sd[%i] conn_id[%i]", bus_id, sender, current, e, sd_flag, id);
 
+		if (0!=(e->stamps).sent)
+			(e->stamps).dispatched = monotonic_ns();
+		flight_record( LITM_FLIGHT_DISPATCH, e->id, 0 );
+
 		int next_index;
 		code = __switch_get_next_subscriber(	&next,
 												&next_index,
-												sender,
-												current,
-												bus_id);
+												e);
 
 		switch(code) {
 		case LITM_CODE_OK:
@@ -210,7 +411,7 @@ __switch_thread_function(void *params) {
 			err_msg = litm_translate_code(code);
 			int sender_id  = sender->id;
 
-			DEBUG_LOG(LOG_DEBUG, "__switch_thread_function: code[%s] sender[%x][%i] current[%x][%i] finalize", err_msg, sender, sender_id, current_conn, current);
+			DEBUG_LOG(LOG_DEBUG, "__switch_thread_function: code[%s] sender[%x][%i] current[%x][%i] finalize", err_msg, sender, sender_id, current_conn, (e->routes).current);
 			__switch_finalize(e);
 
 			continue; // <=======================================
@@ -230,7 +431,7 @@ __switch_thread_function(void *params) {
 
 		switch(code) {
 		case LITM_CODE_OK:
-			delivered++;
+			_switch_stats.delivered++;
 			break;
 
 		case LITM_CODE_ERROR_END_OF_SUBSCRIBERS_LIST:
@@ -239,7 +440,7 @@ __switch_thread_function(void *params) {
 
 		case LITM_CODE_BUSY_OUTPUT_QUEUE:
 		case LITM_CODE_BUSY_CONNECTIONS:
-			busy++;
+			_switch_stats.busy++;
 			//DEBUG_LOG(LOG_DEBUG, thisMsg, next, err_msg);
 			break;
 
@@ -259,7 +460,7 @@ __switch_thread_function(void *params) {
 			// a ``next`` recipient for the envelope.
 			(e->routes).pending = 0;
 			(e->routes).current = -1;
-			queue_put( _switch_queue, e );
+			queue_put_prio( _switch_queue, e, e->priority );
 			break;
 
 		default:
@@ -271,8 +472,9 @@ __switch_thread_function(void *params) {
 
 	}//while
 
-	DEBUG_LOG(LOG_INFO, "__switch_thread_function: ENDING delivered[%li] dequeued[%li] waited[%li] pending[%li] busy[%li] q->num[%i]",
-															delivered,  dequeued,    waited,    pending,    busy, _switch_queue->num );
+	DEBUG_LOG(LOG_INFO, "__switch_thread_function: ENDING delivered[%li] dequeued[%li] waited[%li] pending[%li] busy[%li] expired[%li] q->num[%i]",
+						_switch_stats.delivered, _switch_stats.dequeued, _switch_stats.waited, _switch_stats.pending,
+						_switch_stats.busy, _switch_stats.expired, queue_count(_switch_queue) );
 
 	return NULL;
 }//END THREAD
@@ -347,12 +549,19 @@ switch_release(litm_connection *conn, litm_envelope *envlp) {
 	(envlp->routes).pending = 0; //precaution
 	envlp->released_count ++;
 	conn->released++;
+	__sync_fetch_and_sub( &conn->in_flight, 1 );
+	flight_record( LITM_FLIGHT_RELEASE, envlp->id, conn->index );
+
+	// unless the watchdog reclaimed it meanwhile: the
+	//  switch then only finalizes it
+	if (LITM_HELD_NONE!=envlp->held)
+		__sync_val_compare_and_swap( &envlp->held, LITM_HELD_BY_CLIENT, LITM_HELD_NONE );
 
 	//{
 	DEBUG_LOG(LOG_DEBUG, "~~~ RELEASE conn[%x][%i] released[%i] envelope[%x] sender[%x][%i]", conn, conn->id, conn->released, envlp, (envlp->routes).sender, (envlp->routes).sender->id);
 	//}
 
-	int result = queue_put(_switch_queue, (void *) envlp);
+	int result = queue_put_prio(_switch_queue, (void *) envlp, envlp->priority);
 	if (1 != result) {
 		DEBUG_LOG(LOG_DEBUG, "switch_release: RE-QUEUE ERROR, conn[%x] envelope[%x]", conn, envlp );
 		__switch_finalize( envlp );
@@ -366,6 +575,67 @@ switch_release(litm_connection *conn, litm_envelope *envlp) {
 	return LITM_CODE_OK;
 }//
 
+/**
+ * Takes an envelope back from its holder past the
+ *  release timeout of its bus
+ *
+ * A copy goes on its way as if released whereas the holder
+ *  keeps the original: the message, shared between the two,
+ *  lives on until both are finalized.  The completion token
+ *  and the conflation slot follow the copy.
+ *
+ * Switch thread only.
+ *
+ * @return 1 if reclaimed, 0 if released meanwhile or out of memory
+ */
+	int
+switch_reclaim(litm_envelope *e, int holder) {
+
+	litm_envelope *copy;
+
+	if (NULL==e->payload) {
+		e->payload = __litm_payload_create( e->msg, e->cleaner, 1 );
+		if (NULL==e->payload)
+			return 0;
+	}
+
+	copy = __litm_pool_get();
+	if (NULL==copy)
+		return 0;
+
+	if (LITM_HELD_BY_CLIENT != __sync_val_compare_and_swap( &e->held, LITM_HELD_BY_CLIENT, LITM_HELD_RECLAIMED )) {
+		__litm_pool_recycle( copy );
+		return 0;
+	}
+
+	*copy = *e;
+	__litm_payload_ref( copy->payload );
+
+	#ifdef _DEBUG
+		copy->sent_time = (struct timeval *) alloc_malloc( LITM_ALLOC_DEBUG, sizeof(struct timeval) );
+		*(copy->sent_time) = *(e->sent_time);
+	#endif
+
+	copy->held  = LITM_HELD_NONE;
+	copy->watch = -1;
+	copy->released_count++;
+	(copy->routes).pending = 0;
+
+	e->token = NULL;
+	if (-1!=(e->routes).slot) {
+		_busses[(e->routes).bus_id].slots[(e->routes).slot].active = copy;
+		(e->routes).slot = -1;
+	}
+	replay_relink( e, copy );
+
+	flight_record( LITM_FLIGHT_RECLAIM, e->id, holder );
+
+	if (1!=queue_put_prio( _switch_queue, (void *) copy, copy->priority ))
+		__switch_finalize( copy );
+
+	return 1;
+}//
+
 /**
  * Tries sending the envelope along BUT requeue if this is
  *  not possible at this juncture.
@@ -379,19 +649,33 @@ __switch_try_sending_or_requeue(litm_connection *conn, litm_envelope *envlp) {
 	if (NULL==envlp)
 		return LITM_CODE_ERROR_INVALID_ENVELOPE;
 
+	// held as soon as the recipient can see it
+	int watched = watchdog_active();
+	if (watched)
+		envlp->held = LITM_HELD_BY_CLIENT;
+
 	litm_code result = __switch_try_sending_to_recipient(conn, envlp);
 
 	if (LITM_CODE_OK==result) {
 		(envlp->routes).pending = 0;
 		envlp->delivery_count++;
+		__sync_fetch_and_add( &conn->in_flight, 1 );
+
+		// multi-bus: ``current`` encodes the bus
+		if (watched)
+			watchdog_track( envlp, conn, (0!=(envlp->routes).bus_set) ?
+							(envlp->routes).current / (LITM_CONNECTION_MAX+1) : (envlp->routes).bus_id );
+	} else if (watched) {
+		envlp->held = LITM_HELD_NONE;
 	}
 
 	// requeue in switch
 	if (LITM_CODE_BUSY_OUTPUT_QUEUE==result) {
 
+		flight_record( LITM_FLIGHT_BUSY, envlp->id, conn->index );
 		envlp->requeued++;
 		(envlp->routes).pending = 1;
-		queue_put( _switch_queue, envlp );
+		queue_put_prio( _switch_queue, envlp, envlp->priority );
 
 	}
 
@@ -399,9 +683,10 @@ __switch_try_sending_or_requeue(litm_connection *conn, litm_envelope *envlp) {
 	// just requeue as it was the first go
 	if (LITM_CODE_ERROR_CONNECTION_NOT_ACTIVE==result) {
 
+		flight_record( LITM_FLIGHT_INACTIVE, envlp->id, conn->index );
 		envlp->requeued++;
 		(envlp->routes).pending = 0;
-		queue_put( _switch_queue, envlp );
+		queue_put_prio( _switch_queue, envlp, envlp->priority );
 
 	}
 
@@ -432,6 +717,11 @@ __switch_try_sending_to_recipient(	litm_connection *conn,
 	litm_code returnCode = LITM_CODE_OK;
 	int code;
 
+	// before the recipient can see it
+	if (0!=(env->stamps).sent)
+		(env->stamps).delivered = monotonic_ns();
+	flight_record( LITM_FLIGHT_DELIVER, env->id, conn->index );
+
 	switch(env->type==LITM_MESSAGE_TYPE_SHUTDOWN) {
 
 	// more pressing....
@@ -440,7 +730,7 @@ __switch_try_sending_to_recipient(	litm_connection *conn,
 		break;
 
 	case 0:
-		code = queue_put_nb(conn->input_queue, (void *) env);
+		code = queue_put_prio_nb(conn->input_queue, (void *) env, env->priority);
 		break;
 	}
 
@@ -472,6 +762,33 @@ __switch_try_sending_to_recipient(	litm_connection *conn,
 	litm_code
 switch_add_subscriber(litm_connection *conn, litm_bus bus_id) {
 
+	return __switch_add_subscriber( conn, bus_id, NULL, 0 );
+}//
+
+/**
+ * Adds a subscriber to a bus, optionally with a ``type`` filter
+ *
+ * If the connection is already subscribed to the bus, its
+ *  filter is replaced: a NULL ``type_set`` removes it.
+ *
+ * The filter is evaluated by the switch whilst looking for the next
+ *  recipient of an envelope: a subscriber isn't presented with the
+ *  message types it doesn't accept.  The reserved types
+ *  LITM_MESSAGE_TYPE_SHUTDOWN and LITM_MESSAGE_TYPE_TIMER always go through.
+ */
+	litm_code
+switch_add_subscriber_filtered(litm_connection *conn, litm_bus bus_id, const litm_type_set *type_set) {
+
+	return __switch_add_subscriber( conn, bus_id, type_set, 1 );
+}//
+
+/**
+ * With ``update``, an existing subscription of the
+ *  connection gets the filter ``type_set``
+ */
+	litm_code
+__switch_add_subscriber(litm_connection *conn, litm_bus bus_id, const litm_type_set *type_set, int update) {
+
 	if (NULL==conn) {
 		return LITM_CODE_ERROR_BAD_CONNECTION;
 	}
@@ -480,7 +797,18 @@ switch_add_subscriber(litm_connection *conn, litm_bus bus_id) {
 		return LITM_CODE_ERROR_INVALID_BUS;
 	}
 
-	pthread_mutex_lock( &_subscribers_mutex );
+	// the subscription is installed by the switch
+	//  if there is a replay cache to prime it with
+	litm_envelope *join = NULL;
+	if (replay_enabled( bus_id )) {
+		join = __switch_envelope_create( conn, bus_id, NULL, NULL, LITM_MESSAGE_TYPE_JOIN );
+		if (NULL==join)
+			return LITM_CODE_ERROR_MALLOC;
+		(join->routes).target = conn;
+		join->priority = LITM_PRIORITY_URGENT;
+	}
+
+	LITM_MUTEX_LOCK( &_subscribers_mutex, LITM_LOCK_SUBSCRIBERS );
 
 	/*
 	int code = pthread_mutex_trylock( &_subscribers_mutex );
@@ -490,24 +818,74 @@ switch_add_subscriber(litm_connection *conn, litm_bus bus_id) {
 
 		int code =_litm_connections_trylock();
 		if (EBUSY==code) {
-			pthread_mutex_unlock( &_subscribers_mutex );
+			LITM_MUTEX_UNLOCK( &_subscribers_mutex, LITM_LOCK_SUBSCRIBERS );
+			if (NULL!=join)
+				__switch_finalize( join );
 			return LITM_CODE_BUSY;
 		}
 
 			int result=LITM_CODE_ERROR_BUS_FULL;
-			int index;
-			for (index=1; index<=LITM_CONNECTION_MAX; index++) {
-				if (NULL==_subscribers[bus_id][index]) {
-					_subscribers[bus_id][index] = conn;
-					result = LITM_CODE_OK;
-					DEBUG_LOG(LOG_DEBUG,"switch_add_subscriber: conn[%x] bus_id[%i] index[%i]", conn, bus_id, index);
-					break;
+			int index, found=0, joining=0;
+
+			// updating the filter of an existing subscription?
+			if (update) {
+				for (index=1; index<=LITM_CONNECTION_MAX; index++) {
+					if ((conn==_subscribers[bus_id][index]) || (conn==_joining[bus_id][index])) {
+						found = index;
+						break;
+					}
+				}
+			}
+
+			if (0==found) {
+				for (index=1; index<=LITM_CONNECTION_MAX; index++) {
+					if ((NULL==_subscribers[bus_id][index]) && (NULL==_joining[bus_id][index])) {
+						found = index;
+						break;
+					}
+				}
+			}
+
+			if (0!=found) {
+				if (NULL!=type_set)
+					_filters[bus_id][found] = *type_set;
+				_filtered[bus_id][found] = (NULL!=type_set);
+
+				// a late joiner catches up on the bus: the
+				//  switch installs the subscription then primes it
+				if ((conn!=_subscribers[bus_id][found]) && (conn!=_joining[bus_id][found])) {
+					if (NULL!=join) {
+						_joining[bus_id][found] = conn;
+						joining = 1;
+					} else {
+						_subscribers[bus_id][found] = conn;
+						__switch_build_ring( bus_id );
+					}
 				}
+
+				result = LITM_CODE_OK;
+				DEBUG_LOG(LOG_DEBUG,"switch_add_subscriber: conn[%x] bus_id[%i] index[%i] filtered[%i]", conn, bus_id, found, (NULL!=type_set));
 			}
 
 		_litm_connections_unlock();
 
-	pthread_mutex_unlock( &_subscribers_mutex );
+	LITM_MUTEX_UNLOCK( &_subscribers_mutex, LITM_LOCK_SUBSCRIBERS );
+
+	if (NULL==join)
+		return result;
+
+	// not needed after all
+	if (!joining) {
+		__switch_finalize( join );
+		return result;
+	}
+
+	// ahead of the messages sent afterwards, whatever their priority
+	if (1!=queue_put_prio( _switch_queue, (void *) join, join->priority )) {
+		DEBUG_LOG(LOG_ERR, "switch_add_subscriber: JOIN QUEUE ERROR, conn[%x] bus_id[%i]", conn, bus_id);
+		__switch_finalize( join );
+		__switch_install( conn, bus_id );
+	}
 
 	return result;
 }//
@@ -523,7 +901,7 @@ switch_remove_subscriber(litm_connection *conn, litm_bus bus_id) {
 		return LITM_CODE_ERROR_INVALID_BUS;
 	}
 
-	pthread_mutex_lock( &_subscribers_mutex );
+	LITM_MUTEX_LOCK( &_subscribers_mutex, LITM_LOCK_SUBSCRIBERS );
 	/*
 	int code = pthread_mutex_trylock( &_subscribers_mutex );
 	if (EBUSY==code)
@@ -532,7 +910,7 @@ switch_remove_subscriber(litm_connection *conn, litm_bus bus_id) {
 
 		int code =_litm_connections_trylock();
 		if (EBUSY==code) {
-			pthread_mutex_unlock( &_subscribers_mutex );
+			LITM_MUTEX_UNLOCK( &_subscribers_mutex, LITM_LOCK_SUBSCRIBERS );
 			return LITM_CODE_BUSY;
 		}
 
@@ -541,6 +919,16 @@ switch_remove_subscriber(litm_connection *conn, litm_bus bus_id) {
 			for (index=1; index<=LITM_CONNECTION_MAX; index++) {
 				if (conn==_subscribers[bus_id][index]) {
 					_subscribers[bus_id][index] = NULL;
+					_filtered[bus_id][index] = 0;
+					result = LITM_CODE_OK;
+					__switch_build_ring( bus_id );
+					break;
+				}
+
+				// not installed yet: the switch will skip it
+				if (conn==_joining[bus_id][index]) {
+					_joining[bus_id][index] = NULL;
+					_filtered[bus_id][index] = 0;
 					result = LITM_CODE_OK;
 					break;
 				}
@@ -548,190 +936,906 @@ switch_remove_subscriber(litm_connection *conn, litm_bus bus_id) {
 
 		_litm_connections_unlock();
 
-	pthread_mutex_unlock( &_subscribers_mutex );
+	LITM_MUTEX_UNLOCK( &_subscribers_mutex, LITM_LOCK_SUBSCRIBERS );
 
 	return result;
 }//
 
 
 /**
- * This function just queues up the message in the
- *  switch's input_queue without actually sending it
- *  to recipients.
- *
- *  This function blocks whilst accessing the switch's
- *  ``input_queue`` but no deadlock scenario is possible
- *  since the switch's thread does not block whilst dequeuing.
+ * Adds a subscriber to the table of a ``topic``
  *
+ * Used by the topic router whilst resolving a subscription
+ *  pattern: a connection is only added once to a given topic
+ *  even if more than one of its patterns match.
  */
 	litm_code
-switch_send(litm_connection *conn, litm_bus bus_id, void *msg,
-			void (*cleaner)(void *msg), int type) {
+switch_add_topic_subscriber(litm_connection *conn, litm_topic topic) {
 
 	if (NULL==conn) {
 		return LITM_CODE_ERROR_BAD_CONNECTION;
 	}
 
-	if (( LITM_BUSSES_MAX < bus_id ) || (0>=bus_id)) {
-		return LITM_CODE_ERROR_INVALID_BUS;
+	if ((LITM_TOPICS_MAX <= topic) || (0>topic)) {
+		return LITM_CODE_ERROR_INVALID_TOPIC;
 	}
 
-	return __switch_safe_send( conn, bus_id, msg, cleaner, type );
-}//
-
+	int table = LITM_SWITCH_TOPIC_TABLE(topic);
+	int index, found = 0;
+	int result = LITM_CODE_ERROR_BUS_FULL;
 
-	litm_code
-__switch_safe_send( litm_connection *sender,
-					litm_bus bus_id,
-					void *msg,
-					void (*cleaner)(void *msg),
-					int type ) {
-
-
-	litm_envelope *e=__litm_pool_get();
-	e->cleaner = cleaner;
-	(e->routes).pending = 0; //FALSE
-	(e->routes).bus_id = bus_id;
-	(e->routes).sender = sender;
-	(e->routes).current = -1;  // First time sent
-	(e->routes).current_conn = NULL;  // First time sent
-
-	e->type = type;
-	e->msg = msg;
-	e->delivery_count = 0;
-	e->released_count = 0;
-	e->requeued = 0;
-
-	DEBUG_LOG(LOG_DEBUG, "__SWITCH_SAFE_SEND: sender[%x][%i] bus[%i] sent[%i] env[%x]", sender, sender->id, bus_id, sender->sent, e);
-
-	#ifdef _DEBUG
-		e->sent_time = (struct timeval *) malloc( sizeof(struct timeval) );
-		gettimeofday( e->sent_time, NULL );
-	#endif
+	LITM_MUTEX_LOCK( &_subscribers_mutex, LITM_LOCK_SUBSCRIBERS );
 
+		for (index=1; index<=LITM_CONNECTION_MAX; index++) {
+			if (conn==_subscribers[table][index]) {
+				result = LITM_CODE_OK;
+				break;
+			}
+			if ((0==found) && (NULL==_subscribers[table][index]))
+				found = index;
+		}
 
-	/*
-	 *  Initial message submission: if something goes
-	 *  wrong, we need to get rid of envelope.
-	 */
-	int result;
+		if ((LITM_CODE_OK!=result) && (0!=found)) {
+			_subscribers[table][found] = conn;
+			_filtered[table][found] = 0;
+			__switch_build_ring( table );
+			result = LITM_CODE_OK;
+			DEBUG_LOG(LOG_DEBUG,"switch_add_topic_subscriber: conn[%x] topic[%i] index[%i]", conn, topic, found);
+		}
 
-	switch(LITM_MESSAGE_TYPE_SHUTDOWN==type) {
+	LITM_MUTEX_UNLOCK( &_subscribers_mutex, LITM_LOCK_SUBSCRIBERS );
 
-	// more pressing....
-	// NOTE: don't use the '_wait' functions as it
-	//       might cause race conditions.
-	//		 It is better to throttle the senders
-	//		 then the receivers.
+	return result;
+}//
 
-	case 1:
-		//result = queue_put_head_nb(_switch_queue, (void *) e);
-		result = queue_put_head(_switch_queue, (void *) e);
-		break;
+/**
+ * Removes a subscriber from the table of a ``topic``
+ */
+	litm_code
+switch_remove_topic_subscriber(litm_connection *conn, litm_topic topic) {
 
-	case 0:
-		//result = queue_put_nb(_switch_queue, (void *) e);
-		result = queue_put(_switch_queue, (void *) e);
-		break;
+	if (NULL==conn) {
+		return LITM_CODE_ERROR_BAD_CONNECTION;
 	}
 
-	litm_code code;
-	switch(result) {
-
-	// BUSY
-	//  The client will have to re-submit
-	case -1:
-		code = LITM_CODE_BUSY;
-		__litm_pool_recycle( e );
-		break;
+	if ((LITM_TOPICS_MAX <= topic) || (0>topic)) {
+		return LITM_CODE_ERROR_INVALID_TOPIC;
+	}
 
-	// OK
-	case 1:
-		code = LITM_CODE_OK;
-		sender->sent++;
-		break;
+	int table = LITM_SWITCH_TOPIC_TABLE(topic);
+	int index;
+	int result = LITM_CODE_ERROR_SUBSCRIPTION_NOT_FOUND;
 
-	default:
-		code = LITM_CODE_ERROR_MALLOC;
-		__litm_pool_recycle( e );
-		break;
-	}
+	LITM_MUTEX_LOCK( &_subscribers_mutex, LITM_LOCK_SUBSCRIBERS );
 
-	// NOTE:  we need to leave more CPU cycles to the
-	//        receivers since there is a probable multiplication
-	//        factor involved due to the nature of the
-	//        communication patterns supported (1-to-many)
-	//		  This requirement is supported through the
-	//		  backoff procedure highlighted at the beginning of
-	//		  this function.
+		for (index=1; index<=LITM_CONNECTION_MAX; index++) {
+			if (conn==_subscribers[table][index]) {
+				_subscribers[table][index] = NULL;
+				__switch_build_ring( table );
+				result = LITM_CODE_OK;
+				break;
+			}
+		}
 
-	//usleep(10*1000);
+	LITM_MUTEX_UNLOCK( &_subscribers_mutex, LITM_LOCK_SUBSCRIBERS );
 
-	return code;
+	return result;
 }//
 
 /**
- * Finalizes a message contained
- * in an envelope & recycles the
- * envelope
+ * Sets the delivery mode of a ``bus``
  *
+ * The mode is picked up by the switch thread
+ *  on the next envelope dispatched on the ``bus``.
  */
 	litm_code
-__switch_finalize(litm_envelope *envlp) {
+switch_set_bus_mode(litm_bus bus_id, litm_bus_mode mode) {
 
-	if (NULL==envlp) {
-		return LITM_CODE_ERROR_INVALID_ENVELOPE;
+	if (( LITM_BUSSES_MAX < bus_id ) || (0>=bus_id)) {
+		return LITM_CODE_ERROR_INVALID_BUS;
 	}
 
-	//DEBUG_LOG(LOG_DEBUG, "__switch_finalize: envlp[%x] rel[%i] del[%i]", envlp, envlp->released_count, envlp->delivery_count );
+	if ((LITM_BUS_MODE_BROADCAST > mode) || (LITM_BUS_MODE_MAX <= mode)) {
+		return LITM_CODE_ERROR_INVALID_MODE;
+	}
 
-	void (*cleaner)(void *msg) = envlp->cleaner;
+	LITM_MUTEX_LOCK( &_subscribers_mutex, LITM_LOCK_SUBSCRIBERS );
 
-	if (NULL==cleaner) {
-		DEBUG_LOG(LOG_DEBUG, "__switch_finalize: envelope[%x] freeing", envlp );
-		free( envlp->msg );
-	} else {
-		(*cleaner)( (void *) envlp->msg );
-	}
+		// the table outlives the mode: envelopes might still hold a slot
+		if ((LITM_BUS_MODE_CONFLATING==mode) && (NULL==_busses[bus_id].slots)) {
+			_busses[bus_id].slots = alloc_calloc( LITM_ALLOC_SWITCH, LITM_CONFLATION_SLOTS, sizeof(__litm_conflation_slot) );
+			if (NULL==_busses[bus_id].slots) {
+				LITM_MUTEX_UNLOCK( &_subscribers_mutex, LITM_LOCK_SUBSCRIBERS );
+				return LITM_CODE_ERROR_MALLOC;
+			}
+		}
 
-	__litm_pool_recycle( envlp );
+		_busses[bus_id].mode = mode;
+		_busses[bus_id].last = 0;
+
+	LITM_MUTEX_UNLOCK( &_subscribers_mutex, LITM_LOCK_SUBSCRIBERS );
+
+	DEBUG_LOG(LOG_DEBUG,"switch_set_bus_mode: bus_id[%i] mode[%i]", bus_id, mode);
 
 	return LITM_CODE_OK;
 }//
 
 
 /**
- * Scans the subscription map for the subscriber that
- * follows ``current``.  If ``current`` is NULL (thus
- * indicating the start of the scan), then pull the
- * first subscriber from the subscription to bus ``bus_id``.
- *
- * Furthermore, we are implementing ``split horizon``
- *  forwarding ie. don't send the message back to the
- *  originator.
- *
- * If end of list is reached, return NULL.
- *
- * CASES:
- * ======
+ * This function just queues up the message in the
+ *  switch's input_queue without actually sending it
+ *  to recipients.
  *
- * 1- empty subscription list
- * 2- single subscriber
- *    a) the sender
- *    b) other subscriber
- * 3- more than 1 subscriber
+ *  This function blocks whilst accessing the switch's
+ *  ``input_queue`` but no deadlock scenario is possible
+ *  since the switch's thread does not block whilst dequeuing.
  *
  */
 	litm_code
-__switch_get_next_subscriber(	litm_connection **result,
-								int *result_index,
-								litm_connection *sender,
-								int  current,
-								litm_bus bus_id) {
-
-	litm_code returnCode = LITM_CODE_OK; //optimistic
+switch_send(litm_connection *conn, litm_bus bus_id, void *msg,
+			void (*cleaner)(void *msg), int type) {
 
-	*result = NULL; //precaution
+	if (NULL==conn) {
+		return LITM_CODE_ERROR_BAD_CONNECTION;
+	}
+
+	if (( LITM_BUSSES_MAX < bus_id ) || (0>=bus_id)) {
+		return LITM_CODE_ERROR_INVALID_BUS;
+	}
+
+	litm_envelope *e = __switch_envelope_create( conn, bus_id, msg, cleaner, type );
+	if (NULL==e) {
+		return LITM_CODE_ERROR_MALLOC;
+	}
+
+	return __switch_safe_send( e );
+}//
+
+/**
+ * Same as switch_send but with a ``priority``
+ */
+	litm_code
+switch_send_priority(litm_connection *conn, litm_bus bus_id, void *msg,
+			void (*cleaner)(void *msg), int type, int priority) {
+
+	if (NULL==conn) {
+		return LITM_CODE_ERROR_BAD_CONNECTION;
+	}
+
+	if (( LITM_BUSSES_MAX < bus_id ) || (0>=bus_id)) {
+		return LITM_CODE_ERROR_INVALID_BUS;
+	}
+
+	if ((LITM_PRIORITY_URGENT > priority) || (LITM_PRIORITY_LEVELS <= priority)) {
+		return LITM_CODE_ERROR_INVALID_PRIORITY;
+	}
+
+	litm_envelope *e = __switch_envelope_create( conn, bus_id, msg, cleaner, type );
+	if (NULL==e) {
+		return LITM_CODE_ERROR_MALLOC;
+	}
+
+	e->priority = priority;
+
+	return __switch_safe_send( e );
+}//
+
+/**
+ * Same as switch_send but for a ``topic``
+ *
+ *  The topic handle designates the subscribers table
+ *  resolved by the topic router: no string matching
+ *  takes place on this path.
+ */
+	litm_code
+switch_send_topic(litm_connection *conn, litm_topic topic, void *msg,
+			void (*cleaner)(void *msg), int type) {
+
+	if (NULL==conn) {
+		return LITM_CODE_ERROR_BAD_CONNECTION;
+	}
+
+	if ((LITM_TOPICS_MAX <= topic) || (0>topic)) {
+		return LITM_CODE_ERROR_INVALID_TOPIC;
+	}
+
+	litm_envelope *e = __switch_envelope_create( conn, LITM_SWITCH_TOPIC_TABLE(topic), msg, cleaner, type );
+	if (NULL==e) {
+		return LITM_CODE_ERROR_MALLOC;
+	}
+
+	return __switch_safe_send( e );
+}//
+
+/**
+ * Same as switch_send but the envelope carries
+ *  a ``key``: on a *partitioned* bus, envelopes
+ *  with the same key always go to the same subscriber.
+ */
+	litm_code
+switch_send_keyed(litm_connection *conn, litm_bus bus_id, unsigned int key,
+			void *msg, void (*cleaner)(void *msg), int type) {
+
+	if (NULL==conn) {
+		return LITM_CODE_ERROR_BAD_CONNECTION;
+	}
+
+	if (( LITM_BUSSES_MAX < bus_id ) || (0>=bus_id)) {
+		return LITM_CODE_ERROR_INVALID_BUS;
+	}
+
+	litm_envelope *e = __switch_envelope_create( conn, bus_id, msg, cleaner, type );
+	if (NULL==e) {
+		return LITM_CODE_ERROR_MALLOC;
+	}
+
+	(e->routes).key = key;
+
+	return __switch_safe_send( e );
+}//
+
+
+/**
+ * Same as switch_send but the envelope expires
+ *  ``ttl_usec`` microseconds from now
+ */
+	litm_code
+switch_send_ttl(litm_connection *conn, litm_bus bus_id, void *msg,
+			void (*cleaner)(void *msg), int type, int ttl_usec) {
+
+	if (NULL==conn) {
+		return LITM_CODE_ERROR_BAD_CONNECTION;
+	}
+
+	if (( LITM_BUSSES_MAX < bus_id ) || (0>=bus_id)) {
+		return LITM_CODE_ERROR_INVALID_BUS;
+	}
+
+	if (0>=ttl_usec) {
+		return LITM_CODE_ERROR_INVALID_TTL;
+	}
+
+	litm_envelope *e = __switch_envelope_create( conn, bus_id, msg, cleaner, type );
+	if (NULL==e) {
+		return LITM_CODE_ERROR_MALLOC;
+	}
+
+	e->deadline = monotonic_ns() + (unsigned long long) ttl_usec * 1000ULL;
+
+	return __switch_safe_send( e );
+}//
+
+/**
+ * Same as switch_send but the envelope carries a
+ *  completion token, resolved in __switch_finalize
+ */
+	litm_code
+switch_send_tracked(litm_connection *conn, litm_bus bus_id, void *msg,
+			void (*cleaner)(void *msg), int type, litm_token **token) {
+
+	if (NULL==conn) {
+		return LITM_CODE_ERROR_BAD_CONNECTION;
+	}
+
+	if (( LITM_BUSSES_MAX < bus_id ) || (0>=bus_id)) {
+		return LITM_CODE_ERROR_INVALID_BUS;
+	}
+
+	litm_token *t = __litm_token_get();
+	if (NULL==t) {
+		return LITM_CODE_ERROR_MALLOC;
+	}
+
+	litm_envelope *e = __switch_envelope_create( conn, bus_id, msg, cleaner, type );
+	if (NULL==e) {
+		alloc_free( LITM_ALLOC_TOKEN, t, sizeof(litm_token) );
+		return LITM_CODE_ERROR_MALLOC;
+	}
+
+	e->token = t;
+
+	litm_code code = __switch_safe_send( e );
+	if (LITM_CODE_OK!=code) {
+		// the envelope was recycled: both references go
+		__litm_token_put( t );
+		__litm_token_put( t );
+		t = NULL;
+	}
+
+	*token = t;
+
+	return code;
+}//
+
+/**
+ * Sends a message on all the busses of ``bus_set``
+ *
+ * The envelope is routed through the union of their
+ *  subscribers; ``bus_id`` is set to the first bus
+ *  of the set.
+ */
+	litm_code
+switch_send_multi(litm_connection *conn, litm_bus_set bus_set, void *msg,
+			void (*cleaner)(void *msg), int type) {
+
+	litm_bus bus_id, first = 0;
+
+	if (NULL==conn) {
+		return LITM_CODE_ERROR_BAD_CONNECTION;
+	}
+
+	if ((0==bus_set) || (0!=(bus_set & ~((LITM_BUS_SET(LITM_BUSSES_MAX+1) - 1) & ~LITM_BUS_SET(0))))) {
+		return LITM_CODE_ERROR_INVALID_BUS;
+	}
+
+	for (bus_id=LITM_BUSSES_MAX; bus_id>0; bus_id--) {
+		if (0==(LITM_BUS_SET(bus_id) & bus_set))
+			continue;
+		if (LITM_BUS_MODE_BROADCAST!=_busses[bus_id].mode)
+			return LITM_CODE_ERROR_INVALID_MODE;
+		first = bus_id;
+	}
+
+	litm_envelope *e = __switch_envelope_create( conn, first, msg, cleaner, type );
+	if (NULL==e) {
+		return LITM_CODE_ERROR_MALLOC;
+	}
+
+	(e->routes).bus_set = bus_set;
+
+	return __switch_safe_send( e );
+}//
+
+/**
+ * Sends a message directly to the connection ``target_id``
+ *
+ * The envelope is addressed to the pseudo bus 0: the switch
+ *  presents it to its target only, without looking at the
+ *  subscription map.
+ */
+	litm_code
+switch_send_to(litm_connection *conn, int target_id, void *msg,
+			void (*cleaner)(void *msg), int type) {
+
+	if (NULL==conn) {
+		return LITM_CODE_ERROR_BAD_CONNECTION;
+	}
+
+	litm_connection *target = _litm_connection_find( target_id );
+	if (NULL==target) {
+		return LITM_CODE_ERROR_INVALID_TARGET;
+	}
+
+	litm_envelope *e = __switch_envelope_create( conn, 0, msg, cleaner, type );
+	if (NULL==e) {
+		return LITM_CODE_ERROR_MALLOC;
+	}
+
+	(e->routes).target = target;
+
+	return __switch_safe_send( e );
+}//
+
+/**
+ * Same as switch_send but the envelope carries
+ *  the ``correlation`` id of a pending request
+ */
+	litm_code
+switch_send_request(litm_connection *conn, litm_bus bus_id, void *msg,
+			void (*cleaner)(void *msg), int type, unsigned int correlation) {
+
+	if (NULL==conn) {
+		return LITM_CODE_ERROR_BAD_CONNECTION;
+	}
+
+	if (( LITM_BUSSES_MAX < bus_id ) || (0>=bus_id)) {
+		return LITM_CODE_ERROR_INVALID_BUS;
+	}
+
+	litm_envelope *e = __switch_envelope_create( conn, bus_id, msg, cleaner, type );
+	if (NULL==e) {
+		return LITM_CODE_ERROR_MALLOC;
+	}
+
+	e->correlation = correlation;
+
+	return __switch_safe_send( e );
+}//
+
+/**
+ * Hands a reply over to the sender of ``request``
+ *
+ * The reply bypasses the switch on its way: it is marked
+ *  as delivered to its target so that, once released by
+ *  the requester, the switch only finalizes it.
+ */
+	litm_code
+switch_reply(litm_connection *conn, litm_envelope *request, void *msg,
+			void (*cleaner)(void *msg), int type) {
+
+	if (NULL==conn) {
+		return LITM_CODE_ERROR_BAD_CONNECTION;
+	}
+
+	if ((NULL==request) || (0==request->correlation)) {
+		return LITM_CODE_ERROR_INVALID_ENVELOPE;
+	}
+
+	litm_connection *requester = (request->routes).sender;
+
+	litm_envelope *e = __switch_envelope_create( conn, (request->routes).bus_id, msg, cleaner, type );
+	if (NULL==e) {
+		return LITM_CODE_ERROR_MALLOC;
+	}
+
+	(e->routes).target       = requester;
+	(e->routes).current      = 0;
+	(e->routes).current_conn = requester;
+	e->correlation    = request->correlation;
+	e->delivery_count = 1;
+
+	__sync_fetch_and_add( &requester->in_flight, 1 );
+
+	int weight = traffic_due();
+	size_t size = ((0!=weight) && (&slab_free==e->cleaner)) ? slab_size( e->msg ) : 0;
+
+	if (!rpc_deliver( e->correlation, e )) {
+		__sync_fetch_and_sub( &requester->in_flight, 1 );
+		__switch_finalize( e );
+		return LITM_CODE_ERROR_REQUEST_EXPIRED;
+	}
+
+	conn->sent++;
+	if (0!=weight)
+		traffic_record_send( conn->id, (request->routes).bus_id, type, size, weight );
+
+	return LITM_CODE_OK;
+}//
+
+/**
+ * Delivers a shared ``payload`` to a single subscriber of a bus
+ *
+ * The envelope is tagged with ``conn`` as both sender and
+ *  target: the split-horizon rule doesn't apply to it and
+ *  it doesn't count as sent by the connection.
+ *  The caller's reference on the payload is handed to the
+ *  envelope (and dropped on failure).
+ *
+ * Switch thread only: the message is put in the input queue of
+ *  ``conn`` ahead of the envelopes still in the switch's queue
+ *  (unless the input queue is full).
+ */
+	litm_code
+switch_deliver_targeted(litm_connection *conn, litm_bus bus_id, litm_payload *payload,
+			int type, int priority) {
+
+	litm_code code;
+	int index;
+
+	// the payload's cleaner is settled already: no slab lookup,
+	//  the slab of ``conn`` belongs to its own thread
+	litm_envelope *e = __switch_envelope_prepare( conn, bus_id, payload->msg, payload->cleaner, type );
+	if (NULL==e) {
+		__litm_payload_release( payload );
+		return LITM_CODE_ERROR_MALLOC;
+	}
+
+	e->payload  = payload;
+	e->priority = priority;
+	(e->routes).target = conn;
+
+	index = __switch_find_target( conn, bus_id, type );
+	if (0==index) {
+		__switch_finalize( e );
+		return LITM_CODE_ERROR_SUBSCRIPTION_NOT_FOUND;
+	}
+
+	if (0!=(e->stamps).sent)
+		(e->stamps).dispatched = monotonic_ns();
+	flight_record( LITM_FLIGHT_DISPATCH, e->id, 0 );
+
+	(e->routes).current      = index;
+	(e->routes).current_conn = conn;
+
+	code = __switch_try_sending_or_requeue( conn, e );
+
+	switch(code) {
+	case LITM_CODE_OK:
+		_switch_stats.delivered++;
+		break;
+
+	// requeued
+	case LITM_CODE_BUSY_OUTPUT_QUEUE:
+		_switch_stats.busy++;
+		break;
+	case LITM_CODE_ERROR_CONNECTION_NOT_ACTIVE:
+		break;
+
+	default:
+		__switch_finalize( e );
+		break;
+	}
+
+	return code;
+}//
+
+/**
+ * Verifies if an envelope on its way will still reach ``conn``
+ *  on ``bus_id`` (or, for a multi-bus envelope, reaches it on
+ *  another bus of the set)
+ *
+ * Switch thread only.
+ */
+	int
+switch_will_reach(litm_envelope *e, litm_bus bus_id, litm_connection *conn) {
+
+	int width = LITM_CONNECTION_MAX + 1;
+	int index, other, i;
+
+	if ((NULL!=(e->routes).target) || (conn==(e->routes).sender))
+		return 0;
+
+	index = __switch_find_target( conn, bus_id, e->type );
+	if (0==index)
+		return 0;
+
+	if (0!=(e->routes).bus_set) {
+
+		if (bus_id * width + index > (e->routes).current)
+			return 1;
+
+		for (other=1; other<=LITM_BUSSES_MAX; other++) {
+			if ((other==bus_id) || (0==(LITM_BUS_SET(other) & (e->routes).bus_set)))
+				continue;
+			for (i=1; i<=LITM_CONNECTION_MAX; i++)
+				if (conn==_subscribers[other][i])
+					return 1;
+		}
+
+		return 0;
+	}
+
+	// a single recipient, already picked
+	if ((LITM_BUS_MODE_BROADCAST!=_busses[bus_id].mode) && (LITM_BUS_MODE_CONFLATING!=_busses[bus_id].mode))
+		return 0;
+
+	return (index > (e->routes).current);
+}//
+
+/**
+ * Installs a subscription waiting for the switch
+ *
+ * @return the subscriber's index, 0 if it unsubscribed meanwhile
+ */
+	int
+__switch_install(litm_connection *conn, litm_bus bus_id) {
+
+	int index, result = 0;
+
+	LITM_MUTEX_LOCK( &_subscribers_mutex, LITM_LOCK_SUBSCRIBERS );
+
+		for (index=1; index<=LITM_CONNECTION_MAX; index++) {
+			if (conn==_joining[bus_id][index]) {
+				_joining[bus_id][index] = NULL;
+				_subscribers[bus_id][index] = conn;
+				__switch_build_ring( bus_id );
+				result = index;
+				break;
+			}
+		}
+
+	LITM_MUTEX_UNLOCK( &_subscribers_mutex, LITM_LOCK_SUBSCRIBERS );
+
+	DEBUG_LOG(LOG_DEBUG,"__switch_install: conn[%x] bus_id[%i] index[%i]", conn, bus_id, result);
+
+	return result;
+}//
+
+/**
+ * Handles a LITM_MESSAGE_TYPE_JOIN envelope: the subscription
+ *  is installed then primed with the replay cache of the bus
+ *
+ * The envelopes dispatched before are recorded in the cache
+ *  already whereas those dispatched afterwards reach the new
+ *  subscriber on their way: neither missed nor duplicated.
+ */
+	void
+__switch_join(litm_envelope *e) {
+
+	litm_connection *conn = (e->routes).target;
+	litm_bus bus_id = (e->routes).bus_id;
+
+	if ((NULL!=conn) && (0<bus_id) && (LITM_BUSSES_MAX>=bus_id))
+		if (0!=__switch_install( conn, bus_id ))
+			replay_prime( conn, bus_id );
+
+	__switch_finalize( e );
+}//
+
+/**
+ * Copies the switch's statistics
+ */
+	void
+switch_get_stats(litm_switch_stats *stats) {
+
+	*stats = _switch_stats;
+}//
+
+/**
+ * Enables / disables the envelope timestamps
+ *
+ * Only the envelopes created afterwards are affected.
+ */
+	void
+switch_set_timestamps(int enable) {
+
+	_switch_timestamps = (0!=enable);
+}//
+
+
+/**
+ * Prepares an ``envelope`` for the initial submission
+ *  of a message to the switch.
+ *
+ * Sender's thread only: a message allocated through
+ *  litm_msg_alloc gets the slab's cleaner.
+ *
+ * @return NULL on malloc error
+ */
+	litm_envelope *
+__switch_envelope_create(	litm_connection *sender,
+							litm_bus bus_id,
+							void *msg,
+							void (*cleaner)(void *msg),
+							int type ) {
+
+	// litm_msg_alloc memory goes back to its slab
+	if ((NULL==cleaner) && (NULL!=sender->slab) && slab_owns(sender, msg))
+		cleaner = &slab_free;
+
+	return __switch_envelope_prepare( sender, bus_id, msg, cleaner, type );
+}//
+
+/**
+ * Prepares an ``envelope`` for a message whose
+ *  ``cleaner`` is already settled
+ *
+ * @return NULL on malloc error
+ */
+	litm_envelope *
+__switch_envelope_prepare(	litm_connection *sender,
+							litm_bus bus_id,
+							void *msg,
+							void (*cleaner)(void *msg),
+							int type ) {
+
+	litm_envelope *e=__litm_pool_get();
+	if (NULL==e) {
+		return NULL;
+	}
+
+	e->cleaner = cleaner;
+	(e->routes).pending = 0; //FALSE
+	(e->routes).bus_id = bus_id;
+	(e->routes).sender = sender;
+	(e->routes).current = -1;  // First time sent
+	(e->routes).current_conn = NULL;  // First time sent
+	(e->routes).key = 0;
+	(e->routes).slot = -1;
+	(e->routes).target = NULL;
+	(e->routes).bus_set = 0;
+
+	e->type = type;
+	e->priority = LITM_PRIORITY_NORMAL;
+	e->deadline = 0;
+	e->msg = msg;
+	e->payload = NULL;
+	e->token = NULL;
+	e->correlation = 0;
+	e->delivery_count = 0;
+	e->released_count = 0;
+	e->requeued = 0;
+
+	(e->stamps).sent       = _switch_timestamps ? monotonic_ns() : 0;
+	(e->stamps).dispatched = 0;
+	(e->stamps).delivered  = 0;
+	(e->stamps).received   = 0;
+
+	e->held  = LITM_HELD_NONE;
+	e->watch = -1;
+
+	e->id = __sync_add_and_fetch( &_switch_envelope_ids, 1 );
+	flight_record( LITM_FLIGHT_SEND, e->id, sender->index );
+
+	DEBUG_LOG(LOG_DEBUG, "__SWITCH_SAFE_SEND: sender[%x][%i] bus[%i] sent[%i] env[%x]", sender, sender->id, bus_id, sender->sent, e);
+
+	#ifdef _DEBUG
+		e->sent_time = (struct timeval *) alloc_malloc( LITM_ALLOC_DEBUG, sizeof(struct timeval) );
+		gettimeofday( e->sent_time, NULL );
+	#endif
+
+	return e;
+}//
+
+/**
+ * Submits an ``envelope`` prepared through
+ *  __switch_envelope_create to the switch's input_queue.
+ *
+ *  Initial message submission: if something goes
+ *  wrong, we need to get rid of envelope.
+ */
+	litm_code
+__switch_safe_send( litm_envelope *e ) {
+
+	litm_connection *sender = (e->routes).sender;
+	int type = e->type;
+	int result;
+
+	// more pressing....
+	// NOTE: don't use the '_wait' functions as it
+	//       might cause race conditions.
+	//		 It is better to throttle the senders
+	//		 then the receivers.
+	if (LITM_MESSAGE_TYPE_SHUTDOWN==type)
+		e->priority = LITM_PRIORITY_URGENT;
+
+	// the envelope belongs to the switch once queued
+	int weight = traffic_due();
+	litm_bus bus_id = (e->routes).bus_id;
+	size_t size = ((0!=weight) && (&slab_free==e->cleaner)) ? slab_size( e->msg ) : 0;
+
+	result = queue_put_prio(_switch_queue, (void *) e, e->priority);
+
+	litm_code code;
+	switch(result) {
+
+	// BUSY
+	//  The client will have to re-submit
+	case -1:
+		code = LITM_CODE_BUSY;
+		flight_record( LITM_FLIGHT_SEND_FAILED, e->id, sender->index );
+		__litm_pool_recycle( e );
+		break;
+
+	// OK
+	case 1:
+		code = LITM_CODE_OK;
+		sender->sent++;
+		if (0!=weight)
+			traffic_record_send( sender->id, bus_id, type, size, weight );
+		break;
+
+	default:
+		code = LITM_CODE_ERROR_MALLOC;
+		flight_record( LITM_FLIGHT_SEND_FAILED, e->id, sender->index );
+		__litm_pool_recycle( e );
+		break;
+	}
+
+	// NOTE:  we need to leave more CPU cycles to the
+	//        receivers since there is a probable multiplication
+	//        factor involved due to the nature of the
+	//        communication patterns supported (1-to-many)
+	//		  This requirement is supported through the
+	//		  backoff procedure highlighted at the beginning of
+	//		  this function.
+
+	//usleep(10*1000);
+
+	return code;
+}//
+
+/**
+ * Finalizes a message contained
+ * in an envelope & recycles the
+ * envelope
+ *
+ */
+	litm_code
+__switch_finalize(litm_envelope *envlp) {
+
+	if (NULL==envlp) {
+		return LITM_CODE_ERROR_INVALID_ENVELOPE;
+	}
+
+	//DEBUG_LOG(LOG_DEBUG, "__switch_finalize: envlp[%x] rel[%i] del[%i]", envlp, envlp->released_count, envlp->delivery_count );
+
+	flight_record( LITM_FLIGHT_FINALIZE, envlp->id, 0 );
+
+	// the next value for the key can now follow
+	if (-1!=(envlp->routes).slot)
+		__switch_conflation_done( envlp );
+
+	if (NULL!=envlp->token)
+		__switch_resolve( envlp );
+
+	// a shared message goes when its last reference does
+	if (NULL!=envlp->payload) {
+		replay_relink( envlp, NULL );
+		__litm_payload_release( envlp->payload );
+		__litm_pool_recycle( envlp );
+		return LITM_CODE_OK;
+	}
+
+	void (*cleaner)(void *msg) = envlp->cleaner;
+
+	if (NULL==cleaner) {
+		DEBUG_LOG(LOG_DEBUG, "__switch_finalize: envelope[%x] freeing", envlp );
+		free( envlp->msg );
+	} else {
+		(*cleaner)( (void *) envlp->msg );
+	}
+
+	__litm_pool_recycle( envlp );
+
+	return LITM_CODE_OK;
+}//
+
+
+/**
+ * Resolves the completion token of an envelope
+ *  and drops the envelope's reference to it
+ *
+ * The futex is only woken if someone waits.
+ */
+	void
+__switch_resolve(litm_envelope *envlp) {
+
+	litm_token *token = envlp->token;
+
+	token->delivered = envlp->delivery_count;
+	token->released  = envlp->released_count;
+
+	__atomic_store_n( &token->state, 1, __ATOMIC_SEQ_CST );
+	if (0 != __atomic_load_n( &token->waiters, __ATOMIC_SEQ_CST ))
+		futex_wake( &token->state );
+
+	envlp->token = NULL;
+	__litm_token_put( token );
+}//
+
+
+/**
+ * Scans the subscription map for the subscriber that
+ * follows ``current``.  If ``current`` is NULL (thus
+ * indicating the start of the scan), then pull the
+ * first subscriber from the subscription to bus ``bus_id``.
+ *
+ * Furthermore, we are implementing ``split horizon``
+ *  forwarding ie. don't send the message back to the
+ *  originator.
+ *
+ * If end of list is reached, return NULL.
+ *
+ * CASES:
+ * ======
+ *
+ * 1- empty subscription list
+ * 2- single subscriber
+ *    a) the sender
+ *    b) other subscriber
+ * 3- more than 1 subscriber
+ *
+ * On a *work-queue* bus, a single recipient is picked
+ *  on the first pass (``current`` == -1) and the
+ *  end-of-list is reached on the following one.
+ *  The same goes for targeted envelopes; on the pseudo bus 0
+ *  (direct sends) the target is taken as is, provided it is
+ *  still active.
+ *
+ */
+	litm_code
+__switch_get_next_subscriber(	litm_connection **result,
+								int *result_index,
+								litm_envelope *e) {
+
+	litm_code returnCode = LITM_CODE_OK; //optimistic
+
+	litm_connection *sender = (e->routes).sender;
+	int current             = (e->routes).current;
+	litm_bus bus_id         = (e->routes).bus_id;
+
+	*result = NULL; //precaution
 	int ref;
 
 
@@ -746,7 +1850,52 @@ __switch_get_next_subscriber(	litm_connection **result,
 	// at this point, we are looking for the recipient
 	// after ``current`` but that isn't ``sender`` nor NULL, end-of-subscribers
 
-	int foundMatch = __switch_find_match(sender, ref, bus_id);
+	int foundMatch;
+
+	// direct send: no subscription map to look at
+	if ((0==bus_id) && (NULL!=(e->routes).target)) {
+
+		if ((-1!=current) || (LITM_CONNECTION_STATUS_ACTIVE!=((e->routes).target)->status)) {
+			*result = NULL;
+			*result_index = -1;
+			return LITM_CODE_ERROR_END_OF_SUBSCRIBERS_LIST;
+		}
+
+		*result = (e->routes).target;
+		*result_index = 0;
+		return LITM_CODE_OK;
+	}
+
+	// multi-bus: ``current`` encodes the bus & the index
+	if (0!=(e->routes).bus_set) {
+
+		foundMatch = __switch_find_multi(sender, ref, (e->routes).bus_set, e->type);
+		if (0==foundMatch) {
+			*result = NULL;
+			*result_index = -1;
+			return LITM_CODE_ERROR_END_OF_SUBSCRIBERS_LIST;
+		}
+
+		*result = _subscribers[foundMatch / (LITM_CONNECTION_MAX+1)][foundMatch % (LITM_CONNECTION_MAX+1)];
+		*result_index = foundMatch;
+		return LITM_CODE_OK;
+	}
+
+	// a targeted envelope has a single recipient, whatever the bus mode
+	if (NULL!=(e->routes).target) {
+		foundMatch = (-1==current) ? __switch_find_target((e->routes).target, bus_id, e->type) : 0;
+	} else switch(_busses[bus_id].mode) {
+	case LITM_BUS_MODE_BROADCAST:
+	case LITM_BUS_MODE_CONFLATING:
+		foundMatch = __switch_find_match(sender, ref, bus_id, e->type);
+		break;
+	case LITM_BUS_MODE_PARTITIONED:
+		foundMatch = (-1==current) ? __switch_find_partition(sender, bus_id, (e->routes).key, e->type) : 0;
+		break;
+	default:
+		foundMatch = (-1==current) ? __switch_find_worker(sender, bus_id, e->type) : 0;
+		break;
+	}
 
 	if (0==foundMatch) {
 		*result = NULL;
@@ -767,6 +1916,27 @@ __switch_get_next_subscriber(	litm_connection **result,
 	return returnCode;
 }//
 
+/**
+ * Verifies if the subscriber at ``index`` accepts
+ *  messages of type ``type``
+ *
+ * @return 1 if accepted
+ */
+	static inline int
+__switch_accepts(litm_bus bus_id, int index, int type) {
+
+	if (0==_filtered[bus_id][index])
+		return 1;
+
+	if ((LITM_MESSAGE_TYPE_SHUTDOWN==type) || (LITM_MESSAGE_TYPE_TIMER==type))
+		return 1;
+
+	if ((0>type) || (LITM_TYPE_SET_MAX<=type))
+		return 0;
+
+	return (_filters[bus_id][index].bits[type / 32] >> (type % 32)) & 1;
+}//
+
 /**
  * Find ``match``
  *
@@ -775,7 +1945,7 @@ __switch_get_next_subscriber(	litm_connection **result,
  *
  */
 	int
-__switch_find_match(litm_connection *sender, int ref, litm_bus bus_id) {
+__switch_find_match(litm_connection *sender, int ref, litm_bus bus_id, int type) {
 
 	//DEBUG_LOG(LOG_DEBUG, "__switch_find_match: BEGIN");
 
@@ -785,7 +1955,7 @@ __switch_find_match(litm_connection *sender, int ref, litm_bus bus_id) {
 	for (index=ref+1; index<=LITM_CONNECTION_MAX; index++) {
 
 		sub=_subscribers[bus_id][index];
-		if ((sub!=sender) && (sub!=NULL)) {
+		if ((sub!=sender) && (sub!=NULL) && __switch_accepts(bus_id, index, type)) {
 			result = index;
 			break;
 		}
@@ -796,6 +1966,422 @@ __switch_find_match(litm_connection *sender, int ref, litm_bus bus_id) {
 	return result;
 }//
 
+/**
+ * Find the index of ``target`` in the subscription map
+ *
+ * @return 0 if ``target`` isn't (anymore) subscribed or
+ *         doesn't accept ``type``
+ *
+ * THIS FUNCTION IS NOT *CONNECTION SAFE*: @see __switch_find_match
+ */
+	int
+__switch_find_target(litm_connection *target, litm_bus bus_id, int type) {
+
+	int index;
+
+	for (index=1; index<=LITM_CONNECTION_MAX; index++) {
+
+		if (target==_subscribers[bus_id][index])
+			return __switch_accepts(bus_id, index, type) ? index : 0;
+	}
+
+	return 0;
+}//
+
+/**
+ * Find the next recipient of a multi-bus envelope
+ *
+ * Positions are ``bus_id * (LITM_CONNECTION_MAX+1) + index``
+ *  and the scan resumes after ``ref``.  A subscriber is skipped
+ *  if it was (or will have been) served on a lower bus of the set:
+ *  each connection receives the message once.
+ *
+ * @return 0 at the end of the scan
+ *
+ * THIS FUNCTION IS NOT *CONNECTION SAFE*: @see __switch_find_match
+ */
+	int
+__switch_find_multi(litm_connection *sender, int ref, litm_bus_set bus_set, int type) {
+
+	int width = LITM_CONNECTION_MAX + 1;
+	int pos, bus_id, index, other, i;
+	litm_connection *sub;
+
+	for (pos=ref+1; pos<(LITM_BUSSES_MAX+1)*width; pos++) {
+
+		bus_id = pos / width;
+		index  = pos % width;
+
+		if (0==(LITM_BUS_SET(bus_id) & bus_set)) {
+			pos = (bus_id+1) * width - 1;
+			continue;
+		}
+
+		sub = _subscribers[bus_id][index];
+		if ((0==index) || (NULL==sub) || (sub==sender) || !__switch_accepts(bus_id, index, type))
+			continue;
+
+		// served through a lower bus?
+		for (other=1; other<bus_id; other++) {
+			if (0==(LITM_BUS_SET(other) & bus_set))
+				continue;
+			for (i=1; i<=LITM_CONNECTION_MAX; i++)
+				if ((sub==_subscribers[other][i]) && __switch_accepts(other, i, type))
+					break;
+			if (i<=LITM_CONNECTION_MAX)
+				break;
+		}
+
+		if (other==bus_id)
+			return pos;
+	}
+
+	return 0;
+}//
+
+/**
+ * Find the ``worker`` for an envelope on a *work-queue* bus
+ *
+ * The scan starts right after the last recipient picked on
+ *  the bus so that ties are broken in a round-robin fashion.
+ *  The split-horizon rule applies here too.
+ *
+ * @return 0 if no recipient is available
+ *
+ * THIS FUNCTION IS NOT *CONNECTION SAFE*: @see __switch_find_match
+ */
+	int
+__switch_find_worker(litm_connection *sender, litm_bus bus_id, int type) {
+
+	__litm_bus_config *bus = &_busses[bus_id];
+	int i, index, load, best = 0, result = 0;
+	litm_connection *sub;
+
+	for (i=1; i<=LITM_CONNECTION_MAX; i++) {
+
+		index = 1 + ((bus->last + i - 1) % LITM_CONNECTION_MAX);
+
+		sub=_subscribers[bus_id][index];
+		if ((sub==sender) || (sub==NULL) || !__switch_accepts(bus_id, index, type))
+			continue;
+
+		switch(bus->mode) {
+		case LITM_BUS_MODE_WORK_SHORTEST_QUEUE:
+			load = queue_count( sub->input_queue );
+			break;
+		case LITM_BUS_MODE_WORK_LEAST_IN_FLIGHT:
+			load = sub->in_flight;
+			break;
+		default:
+			load = 0;
+			break;
+		}
+
+		if ((0==result) || (load < best)) {
+			result = index;
+			best   = load;
+		}
+
+		// can't do any better
+		if (0==best)
+			break;
+	}
+
+	if (0!=result)
+		bus->last = result;
+
+	return result;
+}//
+
+/**
+ * Find the subscriber owning ``key`` on a *partitioned* bus
+ *
+ * The key is hashed onto the bus' ring and the first point
+ *  at or after it designates the subscriber.  If that subscriber
+ *  is the sender (split-horizon), the walk continues on the ring.
+ *
+ * No locking: the ring is immutable once published and is
+ *  only freed by the switch thread itself, between dispatches
+ *  (@see __switch_build_ring).
+ *
+ * @return 0 if no recipient is available
+ *
+ * THIS FUNCTION IS NOT *CONNECTION SAFE*: @see __switch_find_match
+ */
+	int
+__switch_find_partition(litm_connection *sender, litm_bus bus_id, unsigned int key, int type) {
+
+	__litm_ring *ring = __atomic_load_n( &_busses[bus_id].ring, __ATOMIC_ACQUIRE );
+	unsigned int h = __switch_hash( key );
+	int lo, hi, mid, i, index;
+	litm_connection *sub;
+
+	if (NULL==ring)
+		return 0;
+
+	// first point >= h
+	lo = 0;
+	hi = ring->size;
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (ring->points[mid].point < h)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	for (i=0; i<ring->size; i++) {
+		index = ring->points[ (lo + i) % ring->size ].index;
+		sub = _subscribers[bus_id][index];
+		if ((sub!=sender) && (sub!=NULL) && __switch_accepts(bus_id, index, type))
+			return index;
+	}
+
+	return 0;
+}//
+
+	static int
+__switch_ring_compare(const void *a, const void *b) {
+
+	unsigned int pa = ((__litm_ring_point *) a)->point;
+	unsigned int pb = ((__litm_ring_point *) b)->point;
+
+	return (pa > pb) - (pa < pb);
+}//
+
+/**
+ * Rebuilds the consistent hashing ring of a bus
+ *
+ * Each subscriber is placed on the ring at LITM_PARTITION_VNODES
+ *  points derived from its connection reference (and not from its
+ *  index in the subscription map) so that adding or removing a
+ *  subscriber only remaps the keys falling next to its own points.
+ *
+ * The ring is built aside then swapped in: the switch thread
+ *  reads either the previous ring or the new one, never a ring
+ *  in the making.  The previous ring is retired, not freed.
+ *  If the new ring can't be allocated, the previous one stays.
+ *
+ * MUST be called whilst holding the _subscribers_mutex.
+ */
+	void
+__switch_build_ring(litm_bus bus_id) {
+
+	__litm_ring *ring = NULL, *old;
+	litm_connection *sub;
+	unsigned int seed;
+	int index, v, n = 0;
+
+	for (index=1; index<=LITM_CONNECTION_MAX; index++)
+		n += (NULL!=_subscribers[bus_id][index]);
+
+	if (0<n) {
+		ring = (__litm_ring *) alloc_malloc( LITM_ALLOC_SWITCH,
+							sizeof(__litm_ring) + n * LITM_PARTITION_VNODES * sizeof(__litm_ring_point) );
+		if (NULL==ring) {
+			DEBUG_LOG(LOG_ERR, "__switch_build_ring: MALLOC ERROR, bus_id[%i]", bus_id);
+			return;
+		}
+
+		n = 0;
+		for (index=1; index<=LITM_CONNECTION_MAX; index++) {
+
+			sub = _subscribers[bus_id][index];
+			if (NULL==sub)
+				continue;
+
+			seed = __switch_hash( (unsigned int) (unsigned long) sub );
+			for (v=0; v<LITM_PARTITION_VNODES; v++) {
+				ring->points[n].point = __switch_hash( seed + v * 0x9e3779b9U );
+				ring->points[n].index = index;
+				n++;
+			}
+		}
+
+		qsort( ring->points, n, sizeof(__litm_ring_point), &__switch_ring_compare );
+		ring->size    = n;
+		ring->retired = NULL;
+	}
+
+	old = __atomic_exchange_n( &_busses[bus_id].ring, ring, __ATOMIC_ACQ_REL );
+	if (NULL==old)
+		return;
+
+	old->retired = __atomic_load_n( &_switch_retired_rings, __ATOMIC_RELAXED );
+	while (!__atomic_compare_exchange_n( &_switch_retired_rings, &old->retired, old, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED ));
+}//
+
+/**
+ * Frees the retired rings
+ *
+ * MUST be called by the switch thread, outside of
+ *  any dispatch: a retired ring might otherwise still
+ *  be in use by __switch_find_partition.
+ */
+	void
+__switch_free_retired_rings(void) {
+
+	__litm_ring *ring, *next;
+
+	ring = __atomic_exchange_n( &_switch_retired_rings, NULL, __ATOMIC_ACQUIRE );
+
+	for (; NULL!=ring; ring=next) {
+		next = ring->retired;
+		alloc_free( LITM_ALLOC_SWITCH, ring, sizeof(__litm_ring) + ring->size * sizeof(__litm_ring_point) );
+	}
+}//
+
+/**
+ * 32bit integer mixing function (murmur3 finalizer)
+ */
+	unsigned int
+__switch_hash(unsigned int h) {
+
+	h ^= h >> 16;
+	h *= 0x85ebca6bU;
+	h ^= h >> 13;
+	h *= 0xc2b2ae35U;
+	h ^= h >> 16;
+
+	return h;
+}//
+
+/**
+ * Conflation of a newly submitted envelope
+ *
+ * The first envelope for a ``key`` takes the slot and goes on
+ *  its way.  Whilst it is on its way, a newer envelope either:
+ *  - replaces its message in place if it wasn't delivered yet
+ *  - or waits in the slot, superseding the one waiting already
+ *
+ * Past LITM_CONFLATION_KEYS keys in flight or for a reserved
+ *  message type, the envelope goes on its way unconflated.
+ *
+ * @return 1 if the envelope was absorbed
+ */
+	int
+__switch_conflate(litm_envelope *e) {
+
+	__litm_bus_config *bus = &_busses[(e->routes).bus_id];
+	__litm_conflation_slot *slots = bus->slots;
+	__litm_conflation_slot *slot;
+	litm_envelope *active;
+	unsigned int key = (e->routes).key;
+	unsigned int mask = LITM_CONFLATION_SLOTS - 1;
+	unsigned int i;
+
+	if ((NULL==slots) || (LITM_MESSAGE_TYPE_USER_START > e->type))
+		return 0;
+
+	i = __switch_hash( key ) & mask;
+
+	while (slots[i].used) {
+
+		if (key != slots[i].key) {
+			i = (i + 1) & mask;
+			continue;
+		}
+
+		slot   = &slots[i];
+		active = slot->active;
+
+		// not delivered to anyone yet: only the switch
+		//  holds the active envelope, swap the message
+		if ((0==active->delivery_count) && ((active->routes).sender==(e->routes).sender)
+				&& (NULL==active->payload)) {
+
+			if (NULL==active->cleaner)
+				free( active->msg );
+			else
+				(*active->cleaner)( active->msg );
+
+			// the superseded message is done with
+			if (NULL!=active->token)
+				__switch_resolve( active );
+
+			active->msg      = e->msg;
+			active->cleaner  = e->cleaner;
+			active->type     = e->type;
+			active->deadline = e->deadline;
+			active->priority = e->priority;
+			active->token    = e->token;
+
+			_switch_stats.conflated++;
+			__litm_pool_recycle( e );
+			return 1;
+		}
+
+		if (NULL!=slot->stash) {
+			_switch_stats.conflated++;
+			__switch_finalize( slot->stash );
+		}
+
+		slot->stash = e;
+		return 1;
+	}
+
+	if (LITM_CONFLATION_KEYS <= bus->slots_used)
+		return 0;
+
+	bus->slots_used++;
+	slots[i].used   = 1;
+	slots[i].key    = key;
+	slots[i].active = e;
+	slots[i].stash  = NULL;
+	(e->routes).slot = i;
+
+	return 0;
+}//
+
+/**
+ * The active envelope of a conflation slot is finalized:
+ *  the one waiting (if any) is submitted, otherwise the
+ *  slot is freed (backward shift deletion: the active
+ *  envelopes of the moved slots are updated).
+ */
+	void
+__switch_conflation_done(litm_envelope *e) {
+
+	__litm_bus_config *bus = &_busses[(e->routes).bus_id];
+	__litm_conflation_slot *slots = bus->slots;
+	litm_envelope *next;
+	unsigned int mask = LITM_CONFLATION_SLOTS - 1;
+	unsigned int i, j, home;
+
+	i = (unsigned int) (e->routes).slot;
+	(e->routes).slot = -1;
+
+	next = slots[i].stash;
+	if (NULL!=next) {
+		slots[i].active = next;
+		slots[i].stash  = NULL;
+		(next->routes).slot = i;
+		queue_put_prio( _switch_queue, next, next->priority );
+		return;
+	}
+
+	j = i;
+	while (1) {
+		j = (j + 1) & mask;
+		if (!slots[j].used)
+			break;
+
+		// stays if its home lies cyclically in (i, j]
+		home = __switch_hash( slots[j].key ) & mask;
+		if ((i<=j) ? ((i<home) && (home<=j)) : ((i<home) || (home<=j)))
+			continue;
+
+		slots[i] = slots[j];
+		(slots[i].active->routes).slot = i;
+		i = j;
+	}
+
+	slots[i].used   = 0;
+	slots[i].active = NULL;
+	slots[i].stash  = NULL;
+	bus->slots_used--;
+}//
+
 	litm_connection *
 __switch_index_to_connection( int bus_id, int index ) {
 
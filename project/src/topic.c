@@ -0,0 +1,466 @@
+/**
+ * @file   topic.c
+ *
+ * @date   2026-10-19
+ * @author Jean-Lou Dupont
+ *
+ * \section Overview
+ *
+ *			This module implements the *topic router*: hierarchical topic
+ *			names (e.g. ``orders.eu.fills``) are registered in a *trie*
+ *			and each topic is given an integer handle which designates a
+ *			subscription table of the switch.
+ *
+ *			Subscription patterns (e.g. ``orders.*.fills``, ``orders.#``)
+ *			are resolved against the trie when subscribing and against
+ *			each new topic when registering it: the switch only ever
+ *			deals with the per-topic subscriber tables thus no string
+ *			matching happens whilst messages flow.
+ *
+ *			Wildcards:
+ *
+ *			- ``*`` matches exactly one level
+ *			- ``#`` matches zero or more levels
+ *
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "litm.h"
+#include "switch.h"
+#include "topic.h"
+#include "logger.h"
+#include "alloc.h"
+#include "lockprof.h"
+
+#define LITM_TOPIC_LEVELS_MAX (LITM_TOPIC_NAME_MAX/2 + 1)
+
+
+/**
+ * Node of the topics ``trie``
+ *
+ * @param label   the level's name
+ * @param topic   the topic handle, -1 if the node isn't a topic itself
+ * @param child   first child node
+ * @param sibling next sibling node
+ */
+typedef struct _litm_topic_node {
+	char *label;
+	litm_topic topic;
+	struct _litm_topic_node *child;
+	struct _litm_topic_node *sibling;
+} __litm_topic_node;
+
+/**
+ * Subscription pattern
+ *
+ * @param conn    the subscriber, NULL if the entry is free
+ * @param pattern the pattern
+ */
+typedef struct {
+	litm_connection *conn;
+	char pattern[LITM_TOPIC_NAME_MAX];
+} __litm_topic_pattern;
+
+
+// PRIVATE
+// -------
+pthread_mutex_t _topics_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+__litm_topic_node    _topics_root = { NULL, -1, NULL, NULL };
+char                *_topic_names[LITM_TOPICS_MAX];
+int                  _topics_count = 0;
+__litm_topic_pattern _topic_patterns[LITM_TOPIC_PATTERNS_MAX];
+
+
+int  __topic_split(char *buffer, const char *name, char *levels[]);
+int  __topic_validate(char *levels[], int count, int wildcards);
+int  __topic_match(char *pattern[], int np, char *name[], int nn);
+void __topic_resolve(__litm_topic_node *node, char *levels[], int count, litm_connection *conn,
+					litm_code (*visit)(litm_connection *conn, litm_topic topic), litm_code *code);
+int  __topic_conn_matches(litm_connection *conn, litm_topic topic);
+litm_code __topic_visit_remove(litm_connection *conn, litm_topic topic);
+__litm_topic_node *__topic_get_child(__litm_topic_node *node, const char *label, int create);
+
+
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+
+
+/**
+ * Registers a topic
+ *
+ * The existing subscription patterns are matched against
+ *  the new topic: this is the only place (along with subscribing)
+ *  where string matching is performed.
+ */
+	litm_code
+topic_register(const char *name, litm_topic *topic) {
+
+	char buffer[LITM_TOPIC_NAME_MAX];
+	char *levels[LITM_TOPIC_LEVELS_MAX];
+	char *plevels[LITM_TOPIC_LEVELS_MAX];
+	char pbuffer[LITM_TOPIC_NAME_MAX];
+	int count, pcount, i;
+
+	if (NULL==topic) {
+		return LITM_CODE_ERROR_INVALID_TOPIC;
+	}
+
+	count = __topic_split(buffer, name, levels);
+	if ((0>=count) || (0==__topic_validate(levels, count, 0))) {
+		return LITM_CODE_ERROR_INVALID_TOPIC;
+	}
+
+	litm_code code = LITM_CODE_OK;
+	__litm_topic_node *node = &_topics_root;
+
+	LITM_MUTEX_LOCK( &_topics_mutex, LITM_LOCK_TOPICS );
+
+		for (i=0; (i<count) && (NULL!=node); i++)
+			node = __topic_get_child(node, levels[i], 1);
+
+		if (NULL==node) {
+			code = LITM_CODE_ERROR_MALLOC;
+
+		} else if (-1==node->topic) {
+
+			if (LITM_TOPICS_MAX <= _topics_count) {
+				code = LITM_CODE_ERROR_NO_MORE_TOPICS;
+			} else {
+				_topic_names[_topics_count] = strdup( name );
+				if (NULL==_topic_names[_topics_count]) {
+					code = LITM_CODE_ERROR_MALLOC;
+				} else {
+					node->topic = _topics_count++;
+
+					DEBUG_LOG(LOG_DEBUG, "topic_register: name[%s] topic[%i]", name, node->topic);
+
+					// resolve the existing patterns
+					for (i=0; i<LITM_TOPIC_PATTERNS_MAX; i++) {
+
+						if (NULL==_topic_patterns[i].conn)
+							continue;
+
+						pcount = __topic_split(pbuffer, _topic_patterns[i].pattern, plevels);
+						if (__topic_match(plevels, pcount, levels, count))
+							switch_add_topic_subscriber( _topic_patterns[i].conn, node->topic );
+					}
+				}
+			}
+		}
+
+		if (LITM_CODE_OK==code)
+			*topic = node->topic;
+
+	LITM_MUTEX_UNLOCK( &_topics_mutex, LITM_LOCK_TOPICS );
+
+	return code;
+}//
+
+/**
+ * Subscribes a connection to a topic pattern
+ *
+ * The pattern is kept so that topics registered later on
+ *  can be matched against it.
+ */
+	litm_code
+topic_subscribe(litm_connection *conn, const char *pattern) {
+
+	char buffer[LITM_TOPIC_NAME_MAX];
+	char *levels[LITM_TOPIC_LEVELS_MAX];
+	int count, i, free_index = -1;
+
+	if (NULL==conn) {
+		return LITM_CODE_ERROR_BAD_CONNECTION;
+	}
+
+	count = __topic_split(buffer, pattern, levels);
+	if ((0>=count) || (0==__topic_validate(levels, count, 1))) {
+		return LITM_CODE_ERROR_INVALID_TOPIC;
+	}
+
+	litm_code code = LITM_CODE_OK;
+
+	LITM_MUTEX_LOCK( &_topics_mutex, LITM_LOCK_TOPICS );
+
+		for (i=0; i<LITM_TOPIC_PATTERNS_MAX; i++) {
+
+			// already subscribed with this very pattern?
+			if ((conn==_topic_patterns[i].conn) && (0==strcmp(pattern, _topic_patterns[i].pattern))) {
+				LITM_MUTEX_UNLOCK( &_topics_mutex, LITM_LOCK_TOPICS );
+				return LITM_CODE_OK;
+			}
+
+			if ((-1==free_index) && (NULL==_topic_patterns[i].conn))
+				free_index = i;
+		}
+
+		if (-1==free_index) {
+			code = LITM_CODE_ERROR_BUS_FULL;
+		} else {
+			_topic_patterns[free_index].conn = conn;
+			strcpy( _topic_patterns[free_index].pattern, pattern );
+
+			__topic_resolve(&_topics_root, levels, count, conn, &switch_add_topic_subscriber, &code);
+		}
+
+	LITM_MUTEX_UNLOCK( &_topics_mutex, LITM_LOCK_TOPICS );
+
+	DEBUG_LOG(LOG_DEBUG, "topic_subscribe: conn[%x] pattern[%s] code[%i]", conn, pattern, code);
+
+	return code;
+}//
+
+/**
+ * Unsubscribes a connection from a topic pattern
+ *
+ * A topic matched by the pattern is only dropped from the
+ *  connection's subscriptions if none of its other patterns
+ *  match it.
+ */
+	litm_code
+topic_unsubscribe(litm_connection *conn, const char *pattern) {
+
+	char buffer[LITM_TOPIC_NAME_MAX];
+	char *levels[LITM_TOPIC_LEVELS_MAX];
+	int count, i;
+
+	if (NULL==conn) {
+		return LITM_CODE_ERROR_BAD_CONNECTION;
+	}
+
+	count = __topic_split(buffer, pattern, levels);
+	if (0>=count) {
+		return LITM_CODE_ERROR_INVALID_TOPIC;
+	}
+
+	litm_code code = LITM_CODE_ERROR_SUBSCRIPTION_NOT_FOUND;
+
+	LITM_MUTEX_LOCK( &_topics_mutex, LITM_LOCK_TOPICS );
+
+		for (i=0; i<LITM_TOPIC_PATTERNS_MAX; i++) {
+			if ((conn==_topic_patterns[i].conn) && (0==strcmp(pattern, _topic_patterns[i].pattern))) {
+				_topic_patterns[i].conn = NULL;
+				code = LITM_CODE_OK;
+				break;
+			}
+		}
+
+		if (LITM_CODE_OK==code)
+			__topic_resolve(&_topics_root, levels, count, conn, &__topic_visit_remove, &code);
+
+	LITM_MUTEX_UNLOCK( &_topics_mutex, LITM_LOCK_TOPICS );
+
+	return code;
+}//
+
+
+/**
+ * Walks the trie along the levels of a pattern and
+ *  calls ``visit`` for each topic matched.
+ *
+ *  The first error returned by ``visit`` is kept in ``code``.
+ */
+	void
+__topic_resolve(__litm_topic_node *node, char *levels[], int count, litm_connection *conn,
+				litm_code (*visit)(litm_connection *conn, litm_topic topic), litm_code *code) {
+
+	__litm_topic_node *child;
+	litm_code result;
+
+	if (0==count) {
+		if (-1!=node->topic) {
+			result = (*visit)( conn, node->topic );
+			if ((LITM_CODE_OK!=result) && (LITM_CODE_OK==*code))
+				*code = result;
+		}
+		return;
+	}
+
+	if (0==strcmp("#", levels[0])) {
+
+		// zero level...
+		__topic_resolve(node, levels+1, count-1, conn, visit, code);
+
+		// ... or one more level
+		for (child=node->child; NULL!=child; child=child->sibling)
+			__topic_resolve(child, levels, count, conn, visit, code);
+
+	} else if (0==strcmp("*", levels[0])) {
+
+		for (child=node->child; NULL!=child; child=child->sibling)
+			__topic_resolve(child, levels+1, count-1, conn, visit, code);
+
+	} else {
+
+		child = __topic_get_child(node, levels[0], 0);
+		if (NULL!=child)
+			__topic_resolve(child, levels+1, count-1, conn, visit, code);
+	}
+
+}//
+
+/**
+ * Matches a topic name against a pattern, level by level
+ *
+ * @return 1 on match
+ */
+	int
+__topic_match(char *pattern[], int np, char *name[], int nn) {
+
+	if (0==np)
+		return (0==nn);
+
+	if (0==strcmp("#", pattern[0])) {
+		if (__topic_match(pattern+1, np-1, name, nn))
+			return 1;
+		return (0<nn) && __topic_match(pattern, np, name+1, nn-1);
+	}
+
+	if (0==nn)
+		return 0;
+
+	if ((0!=strcmp("*", pattern[0])) && (0!=strcmp(pattern[0], name[0])))
+		return 0;
+
+	return __topic_match(pattern+1, np-1, name+1, nn-1);
+}//
+
+/**
+ * Verifies if any of the patterns of ``conn`` matches ``topic``
+ *
+ * MUST be called whilst holding the _topics_mutex.
+ */
+	int
+__topic_conn_matches(litm_connection *conn, litm_topic topic) {
+
+	char buffer[LITM_TOPIC_NAME_MAX], pbuffer[LITM_TOPIC_NAME_MAX];
+	char *levels[LITM_TOPIC_LEVELS_MAX], *plevels[LITM_TOPIC_LEVELS_MAX];
+	int i, count, pcount;
+
+	count = __topic_split(buffer, _topic_names[topic], levels);
+
+	for (i=0; i<LITM_TOPIC_PATTERNS_MAX; i++) {
+
+		if (conn!=_topic_patterns[i].conn)
+			continue;
+
+		pcount = __topic_split(pbuffer, _topic_patterns[i].pattern, plevels);
+		if (__topic_match(plevels, pcount, levels, count))
+			return 1;
+	}
+
+	return 0;
+}//
+
+	litm_code
+__topic_visit_remove(litm_connection *conn, litm_topic topic) {
+
+	if (__topic_conn_matches(conn, topic))
+		return LITM_CODE_OK;
+
+	switch_remove_topic_subscriber( conn, topic );
+
+	return LITM_CODE_OK;
+}//
+
+/**
+ * Finds (or creates) the child node with label ``label``
+ *
+ * @return NULL if not found or on malloc error
+ */
+	__litm_topic_node *
+__topic_get_child(__litm_topic_node *node, const char *label, int create) {
+
+	__litm_topic_node *child;
+
+	for (child=node->child; NULL!=child; child=child->sibling) {
+		if (0==strcmp(label, child->label))
+			return child;
+	}
+
+	if (0==create)
+		return NULL;
+
+	child = (__litm_topic_node *) alloc_malloc( LITM_ALLOC_SWITCH, sizeof(__litm_topic_node) );
+	if (NULL==child)
+		return NULL;
+
+	child->label = strdup( label );
+	if (NULL==child->label) {
+		alloc_free( LITM_ALLOC_SWITCH, child, sizeof(__litm_topic_node) );
+		return NULL;
+	}
+
+	child->topic   = -1;
+	child->child   = NULL;
+	child->sibling = node->child;
+	node->child    = child;
+
+	return child;
+}//
+
+/**
+ * Splits a topic name / pattern in levels
+ *
+ * The levels point inside ``buffer``, which holds up to
+ *  LITM_TOPIC_LEVELS_MAX of them.
+ *
+ * @return the number of levels, -1 on error
+ */
+	int
+__topic_split(char *buffer, const char *name, char *levels[]) {
+
+	int count = 0;
+	char *p;
+
+	if ((NULL==name) || (LITM_TOPIC_NAME_MAX <= strlen(name)))
+		return -1;
+
+	strcpy( buffer, name );
+
+	levels[count++] = buffer;
+	for (p=buffer; '\0'!=*p; p++) {
+		if ('.'==*p) {
+			if (LITM_TOPIC_LEVELS_MAX <= count)
+				return -1;
+			*p = '\0';
+			levels[count++] = p+1;
+		}
+	}
+
+	return count;
+}//
+
+/**
+ * Validates the levels of a topic name / pattern
+ *
+ * Levels can not be empty and the wildcards ``*`` and ``#``
+ *  must stand alone on their level.
+ *
+ * @return 1 if valid
+ */
+	int
+__topic_validate(char *levels[], int count, int wildcards) {
+
+	int i;
+
+	for (i=0; i<count; i++) {
+
+		if ('\0'==levels[i][0])
+			return 0;
+
+		if ((NULL==strchr(levels[i], '*')) && (NULL==strchr(levels[i], '#')))
+			continue;
+
+		if (0==wildcards)
+			return 0;
+
+		if ((0!=strcmp("*", levels[i])) && (0!=strcmp("#", levels[i])))
+			return 0;
+	}
+
+	return 1;
+}//
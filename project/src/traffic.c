@@ -0,0 +1,316 @@
+/**
+ * @file   traffic.c
+ *
+ * @date   2026-10-19
+ * @author Jean-Lou Dupont
+ *
+ * \section Overview
+ *
+ *			This module implements the *traffic matrix*: messages,
+ *			bytes & switch time per (sender, bus, type).
+ *
+ *			One message out of ``rate`` is sampled: each thread counts
+ *			down on its own and records the sample, weighing ``rate``,
+ *			in its own table.  The count down is drawn at random, ``rate``
+ *			on average, so that a periodic pattern (e.g. a sender going
+ *			round-robin over its busses) doesn't bias the samples.
+ *
+ *			A table is only written by its thread thus without any lock
+ *			nor atomic; the snapshot merges the tables as they are.
+ *
+ *			A thread gets its table on its first sample: the tables are
+ *			never freed nor recycled, those of the threads gone still
+ *			counting in the snapshots.  Past LITM_TRAFFIC_TABLES_MAX
+ *			threads, the new ones aren't sampled at all.
+ *
+ *			A table is cleared by its thread: a reset only moves the
+ *			epoch on, the tables of an older epoch being ignored until
+ *			their thread clears them on its next sample.
+ *
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "litm.h"
+#include "traffic.h"
+#include "alloc.h"
+
+
+typedef struct {
+	int used;
+	litm_traffic_entry entry;
+} __traffic_slot;
+
+/**
+ * Table of a thread
+ *
+ * @param epoch   the reset it dates from
+ * @param dropped messages & dispatches left out, the table being full
+ */
+typedef struct {
+	volatile int epoch;
+	long dropped;
+	__traffic_slot slots[LITM_TRAFFIC_SLOTS];
+} __traffic_table;
+
+
+int _traffic_sampling = 0;
+int _traffic_epoch = 0;
+
+__traffic_table *_traffic_tables[LITM_TRAFFIC_TABLES_MAX];
+int _traffic_table_count = 0;
+
+static __thread __traffic_table *__traffic_table_self = NULL;
+static __thread int __traffic_table_none = 0;
+static __thread int __traffic_countdown = 0;
+static __thread unsigned int __traffic_seed = 0;
+
+
+// PRIVATE
+// -------
+__traffic_table    *__traffic_table_get(void);
+litm_traffic_entry *__traffic_entry(int sender, litm_bus bus_id, int type, int weight);
+int                 __traffic_compare(const void *a, const void *b);
+
+
+
+	void
+traffic_set_sampling(int rate) {
+
+	_traffic_sampling = (0<rate) ? rate : 0;
+}//
+
+	void
+traffic_reset(void) {
+
+	__sync_fetch_and_add( &_traffic_epoch, 1 );
+}//
+
+/**
+ * Counts down to the calling thread's next sample
+ *
+ * @return the weight of the sample, 0 if not sampling
+ */
+	int
+traffic_due(void) {
+
+	int rate = _traffic_sampling;
+
+	if (0==rate)
+		return 0;
+
+	if (0 < --__traffic_countdown)
+		return 0;
+
+	if (1 < rate) {
+		// xorshift32, seeded from the thread's own address
+		if (0==__traffic_seed)
+			__traffic_seed = (unsigned int) (size_t) &__traffic_seed | 1;
+
+		__traffic_seed ^= __traffic_seed << 13;
+		__traffic_seed ^= __traffic_seed >> 17;
+		__traffic_seed ^= __traffic_seed << 5;
+
+		// uniform over [1, 2*rate-1]: ``rate`` on average
+		__traffic_countdown = 1 + (int) (__traffic_seed % (unsigned int) (2 * rate - 1));
+	}
+
+	return rate;
+}//
+
+/**
+ * Records a sampled message
+ *
+ * @param size the message's size, 0 if unknown
+ */
+	void
+traffic_record_send(int sender, litm_bus bus_id, int type, size_t size, int weight) {
+
+	litm_traffic_entry *entry = __traffic_entry( sender, bus_id, type, weight );
+
+	if (NULL==entry)
+		return;
+
+	entry->messages += weight;
+	entry->bytes    += weight * (long) size;
+}//
+
+/**
+ * Records a sampled turn of the switch
+ */
+	void
+traffic_record_dispatch(int sender, litm_bus bus_id, int type, unsigned long long ns, int weight) {
+
+	litm_traffic_entry *entry = __traffic_entry( sender, bus_id, type, weight );
+
+	if (NULL==entry)
+		return;
+
+	entry->dispatches += weight;
+	entry->switch_ns  += weight * ns;
+}//
+
+/**
+ * Merges the tables of the current epoch
+ */
+	void
+traffic_get(litm_traffic_matrix *matrix) {
+
+	__traffic_table *table;
+	litm_traffic_entry *src, *dst;
+	int epoch = _traffic_epoch;
+	int tables, index, slot, found;
+
+	matrix->sampling = _traffic_sampling;
+	matrix->dropped  = 0;
+	matrix->count    = 0;
+
+	tables = _traffic_table_count;
+	if (LITM_TRAFFIC_TABLES_MAX < tables)
+		tables = LITM_TRAFFIC_TABLES_MAX;
+
+	for (index=0; index<tables; index++) {
+
+		table = _traffic_tables[index];
+		if ((NULL==table) || (epoch != table->epoch))
+			continue;
+
+		matrix->dropped += table->dropped;
+
+		for (slot=0; slot<LITM_TRAFFIC_SLOTS; slot++) {
+
+			if (!table->slots[slot].used)
+				continue;
+
+			src = &table->slots[slot].entry;
+
+			for (found=0; found<matrix->count; found++) {
+				dst = &matrix->entries[found];
+				if ((src->sender==dst->sender) && (src->bus_id==dst->bus_id) && (src->type==dst->type))
+					break;
+			}
+
+			if (found==matrix->count) {
+				if (LITM_TRAFFIC_ENTRIES_MAX==matrix->count) {
+					matrix->dropped += src->messages + src->dispatches;
+					continue;
+				}
+				dst = &matrix->entries[matrix->count++];
+				memset( dst, 0, sizeof(litm_traffic_entry) );
+				dst->sender = src->sender;
+				dst->bus_id = src->bus_id;
+				dst->type   = src->type;
+			}
+
+			dst->messages   += src->messages;
+			dst->bytes      += src->bytes;
+			dst->dispatches += src->dispatches;
+			dst->switch_ns  += src->switch_ns;
+		}
+	}
+
+	qsort( matrix->entries, matrix->count, sizeof(litm_traffic_entry), &__traffic_compare );
+}//
+
+
+/**
+ * Gets the calling thread's table, allocating it
+ *  on the first call and clearing it on a new epoch
+ *
+ * @return NULL if the tables are all taken
+ */
+	__traffic_table *
+__traffic_table_get(void) {
+
+	__traffic_table *table = __traffic_table_self;
+	int index;
+
+	if (NULL==table) {
+
+		if (__traffic_table_none)
+			return NULL;
+
+		index = __sync_fetch_and_add( &_traffic_table_count, 1 );
+		if (LITM_TRAFFIC_TABLES_MAX <= index) {
+			__traffic_table_none = 1;
+			return NULL;
+		}
+
+		table = (__traffic_table *) alloc_calloc( LITM_ALLOC_TRAFFIC, 1, sizeof(__traffic_table) );
+		if (NULL==table) {
+			__traffic_table_none = 1;
+			return NULL;
+		}
+
+		table->epoch = _traffic_epoch;
+		_traffic_tables[index] = table;
+		__traffic_table_self = table;
+	}
+
+	if (_traffic_epoch != table->epoch) {
+		memset( table->slots, 0, sizeof(table->slots) );
+		table->dropped = 0;
+		table->epoch = _traffic_epoch;
+	}
+
+	return table;
+}//
+
+/**
+ * Finds (or adds) the entry of a key in the calling
+ *  thread's table, open addressing
+ *
+ * @return NULL if the table is full
+ */
+	litm_traffic_entry *
+__traffic_entry(int sender, litm_bus bus_id, int type, int weight) {
+
+	__traffic_table *table = __traffic_table_get();
+	__traffic_slot *slot;
+	unsigned int mask = LITM_TRAFFIC_SLOTS - 1;
+	unsigned int i, probes;
+
+	if (NULL==table)
+		return NULL;
+
+	i = ((unsigned int) sender * 2654435761U) ^ ((unsigned int) bus_id * 40503U) ^ (unsigned int) type;
+
+	for (probes=0; probes<LITM_TRAFFIC_SLOTS; probes++, i++) {
+
+		slot = &table->slots[i & mask];
+
+		if (!slot->used) {
+			slot->entry.sender = sender;
+			slot->entry.bus_id = bus_id;
+			slot->entry.type   = type;
+			// the key is complete before a snapshot can see it
+			__sync_synchronize();
+			slot->used = 1;
+			return &slot->entry;
+		}
+
+		if ((sender==slot->entry.sender) && (bus_id==slot->entry.bus_id) && (type==slot->entry.type))
+			return &slot->entry;
+	}
+
+	table->dropped += weight;
+	return NULL;
+}//
+
+/**
+ * By decreasing switch time then messages
+ */
+	int
+__traffic_compare(const void *a, const void *b) {
+
+	const litm_traffic_entry *ea = (const litm_traffic_entry *) a;
+	const litm_traffic_entry *eb = (const litm_traffic_entry *) b;
+
+	if (ea->switch_ns != eb->switch_ns)
+		return (ea->switch_ns > eb->switch_ns) ? -1 : 1;
+
+	if (ea->messages != eb->messages)
+		return (ea->messages > eb->messages) ? -1 : 1;
+
+	return 0;
+}//
@@ -8,6 +8,12 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <sys/time.h>
+#include <time.h>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
 
 #include "utils.h"
 
@@ -45,3 +51,41 @@ int random_sleep_period(struct timeval *start, struct timeval *current, int max_
 
 	return 0;
 }//
+
+
+unsigned long long monotonic_ns(void) {
+
+	struct timespec now;
+
+	clock_gettime( CLOCK_MONOTONIC, &now );
+
+	return (unsigned long long) now.tv_sec * 1000000000ULL + now.tv_nsec;
+}//
+
+
+void futex_wait(volatile int *addr, int val, int usecs) {
+
+#ifdef __linux__
+	struct timespec timeout, *ptimeout = NULL;
+
+	if (0<=usecs) {
+		timeout.tv_sec  = usecs / 1000000;
+		timeout.tv_nsec = (usecs % 1000000) * 1000;
+		ptimeout = &timeout;
+	}
+
+	syscall( SYS_futex, (int *) addr, FUTEX_WAIT_PRIVATE, val, ptimeout, NULL, 0 );
+#else
+	// no futex: poll with a bounded sleep
+	if (val == *addr)
+		usleep( ((0<=usecs) && (usecs<100)) ? usecs : 100 );
+#endif
+}//
+
+
+void futex_wake(volatile int *addr) {
+
+#ifdef __linux__
+	syscall( SYS_futex, (int *) addr, FUTEX_WAKE_PRIVATE, 0x7fffffff, NULL, NULL, 0 );
+#endif
+}//
@@ -0,0 +1,259 @@
+/**
+ * @file   watchdog.c
+ *
+ * @date   2026-10-19
+ * @author Jean-Lou Dupont
+ *
+ * \section Overview
+ *
+ *			This module implements the *watchdog*: delivery being
+ *			turn-wise, a subscriber which doesn't release a message
+ *			holds it up for all the subscribers after it.
+ *
+ *			The switch thread tracks each delivery until the release
+ *			comes back to it and, every LITM_WATCHDOG_PERIOD_USECS,
+ *			checks for those held too long: past the threshold, they
+ *			are reported; past the release timeout of their bus (or
+ *			topic), they are reclaimed (@see switch_reclaim).
+ *
+ *			Only the switch thread accesses the entries: no locking.
+ *			The statistics are published at the end of each check,
+ *			under _watchdog_mutex, for litm_get_watchdog_stats.
+ *			The holders and the watchdog agree on the fate of an
+ *			envelope through its ``held`` state (@see litm_held_state).
+ *
+ */
+#include <string.h>
+#include <pthread.h>
+
+#include "litm.h"
+#include "watchdog.h"
+#include "switch.h"
+#include "alloc.h"
+#include "logger.h"
+#include "utils.h"
+#include "lockprof.h"
+
+
+/**
+ * Delivery in flight
+ *
+ * @param since     monotonic time of the delivery (ns)
+ * @param holder    the recipient's connection slot
+ * @param holder_id the recipient's id: the connection might be gone
+ * @param table     the switch table (bus or topic) whose release
+ *                  timeout applies, 0 for none
+ * @param reported  past the threshold already
+ */
+typedef struct {
+	litm_envelope *envelope;
+	unsigned long long since;
+	int holder;
+	int holder_id;
+	int table;
+	int reported;
+} __watchdog_entry;
+
+
+int _watchdog_threshold = 0;					// usecs
+int _watchdog_timeouts[LITM_SWITCH_TABLES];	// usecs, per switch table, index 0 is not used
+int _watchdog_timeouts_count = 0;				// atomic: set by the user threads
+
+__watchdog_entry *_watchdog_entries = NULL;
+int _watchdog_count = 0;
+int _watchdog_capacity = 0;
+
+unsigned long long _watchdog_next_check = 0;
+
+pthread_mutex_t _watchdog_mutex = PTHREAD_MUTEX_INITIALIZER;
+litm_watchdog_stats _watchdog_stats;			// written by the switch thread only
+
+// a switch table as "bus", bus_id or "topic", topic for the logs
+#define __WATCHDOG_TABLE(table) \
+	((LITM_BUSSES_MAX < (table)) ? "topic" : "bus"), \
+	((LITM_BUSSES_MAX < (table)) ? (table) - LITM_SWITCH_TOPIC_TABLE(0) : (table))
+
+
+
+	void
+watchdog_set_threshold(int usecs) {
+
+	_watchdog_threshold = (0<usecs) ? usecs : 0;
+}//
+
+/**
+ * Sets the release timeout of a switch table: a bus
+ *  or LITM_SWITCH_TOPIC_TABLE(topic)
+ */
+	litm_code
+watchdog_set_timeout(int table, int usecs) {
+
+	int previous;
+
+	if ((LITM_SWITCH_TABLES <= table) || (0>=table)) {
+		return LITM_CODE_ERROR_INVALID_BUS;
+	}
+
+	if (0>usecs)
+		usecs = 0;
+
+	// concurrent callers on the same table: each
+	//  accounts for the value it replaced
+	previous = __sync_lock_test_and_set( &_watchdog_timeouts[table], usecs );
+	__sync_fetch_and_add( &_watchdog_timeouts_count, (0!=usecs) - (0!=previous) );
+
+	DEBUG_LOG(LOG_DEBUG,"watchdog_set_timeout: table[%i] usecs[%i]", table, usecs);
+
+	return LITM_CODE_OK;
+}//
+
+/**
+ * @return 1 if there is something to watch for
+ */
+	int
+watchdog_active(void) {
+
+	return (0!=_watchdog_threshold) || (0!=_watchdog_timeouts_count);
+}//
+
+/**
+ * Starts tracking a delivery
+ *
+ * Called by the switch thread once the envelope is
+ *  in the holder's input queue.  Without memory for
+ *  the entry, the delivery goes untracked.
+ */
+	void
+watchdog_track(litm_envelope *e, litm_connection *holder, int table) {
+
+	__watchdog_entry *entries, *entry;
+	int capacity;
+
+	if (_watchdog_count == _watchdog_capacity) {
+		capacity = (0==_watchdog_capacity) ? 64 : 2 * _watchdog_capacity;
+		entries  = (__watchdog_entry *) alloc_realloc( LITM_ALLOC_SWITCH, _watchdog_entries,
+								_watchdog_capacity * sizeof(__watchdog_entry), capacity * sizeof(__watchdog_entry) );
+		if (NULL==entries)
+			return;
+
+		_watchdog_entries  = entries;
+		_watchdog_capacity = capacity;
+	}
+
+	entry = &_watchdog_entries[_watchdog_count];
+	entry->envelope  = e;
+	entry->since     = monotonic_ns();
+	entry->holder    = holder->index;
+	entry->holder_id = holder->id;
+	entry->table     = ((LITM_SWITCH_TABLES <= table) || (0>=table)) ? 0 : table;
+	entry->reported  = 0;
+
+	e->watch = _watchdog_count++;
+}//
+
+/**
+ * Stops tracking an envelope: released or reclaimed
+ */
+	void
+watchdog_untrack(litm_envelope *e) {
+
+	int index = e->watch;
+
+	e->watch = -1;
+
+	if ((0>index) || (_watchdog_count<=index))
+		return;
+
+	_watchdog_count--;
+	if (index != _watchdog_count) {
+		_watchdog_entries[index] = _watchdog_entries[_watchdog_count];
+		(_watchdog_entries[index].envelope)->watch = index;
+	}
+}//
+
+/**
+ * Checks the deliveries in flight, at most
+ *  every LITM_WATCHDOG_PERIOD_USECS
+ */
+	void
+watchdog_check(unsigned long long now) {
+
+	__watchdog_entry *entry;
+	litm_watchdog_holder *holder;
+	litm_watchdog_stats stats;
+	unsigned long long age;
+	int index, timeout;
+
+	if (now < _watchdog_next_check)
+		return;
+
+	_watchdog_next_check = now + LITM_WATCHDOG_PERIOD_USECS * 1000ULL;
+
+	// built aside: litm_get_watchdog_stats copies a whole check
+	stats = _watchdog_stats;
+	stats.stuck     = 0;
+	stats.oldest_ns = 0;
+	memset( stats.holders, 0, sizeof(stats.holders) );
+
+	// backwards: a reclaimed entry is replaced by the last one
+	for (index=_watchdog_count-1; index>=0; index--) {
+
+		entry = &_watchdog_entries[index];
+
+		// released, on its way back to the switch
+		if (LITM_HELD_BY_CLIENT != (entry->envelope)->held)
+			continue;
+
+		age = (now > entry->since) ? now - entry->since : 0;
+
+		timeout = (0!=entry->table) ? _watchdog_timeouts[entry->table] : 0;
+		if ((0!=timeout) && (age >= timeout * 1000ULL)) {
+
+			if (switch_reclaim( entry->envelope, entry->holder )) {
+				stats.reclaimed++;
+				doLog(LOG_WARNING, "watchdog: envelope[%u] reclaimed from connection id[%i] %s[%i] after [%llu] usecs",
+						(entry->envelope)->id, entry->holder_id, __WATCHDOG_TABLE(entry->table), age / 1000ULL);
+				watchdog_untrack( entry->envelope );
+				continue;
+			}
+		}
+
+		if (age > stats.oldest_ns)
+			stats.oldest_ns = age;
+
+		if ((0==_watchdog_threshold) || (age < _watchdog_threshold * 1000ULL))
+			continue;
+
+		if (!entry->reported) {
+			entry->reported = 1;
+			stats.reported++;
+			doLog(LOG_WARNING, "watchdog: connection id[%i] holds envelope[%u] of %s[%i] for [%llu] usecs",
+					entry->holder_id, (entry->envelope)->id, __WATCHDOG_TABLE(entry->table), age / 1000ULL);
+		}
+
+		stats.stuck++;
+
+		holder = &stats.holders[entry->holder];
+		holder->id = entry->holder_id;
+		holder->stuck++;
+		if (age > holder->oldest_ns)
+			holder->oldest_ns = age;
+	}
+
+	stats.in_flight = _watchdog_count;
+
+	LITM_MUTEX_LOCK( &_watchdog_mutex, LITM_LOCK_WATCHDOG );
+		_watchdog_stats = stats;
+	LITM_MUTEX_UNLOCK( &_watchdog_mutex, LITM_LOCK_WATCHDOG );
+}//
+
+/**
+ * Copies the watchdog's statistics
+ */
+	void
+watchdog_get_stats(litm_watchdog_stats *stats) {
+
+	LITM_MUTEX_LOCK( &_watchdog_mutex, LITM_LOCK_WATCHDOG );
+		*stats = _watchdog_stats;
+	LITM_MUTEX_UNLOCK( &_watchdog_mutex, LITM_LOCK_WATCHDOG );
+}//
@@ -0,0 +1,305 @@
+/*
+ * bench.c
+ *
+ *  Created on: 2026-10-19
+ *      Author: Jean-Lou Dupont
+ *
+ *
+ *  Throughput & scaling benchmark
+ *
+ *  Sweeps over the number of producers, busses, subscribers per
+ *  bus and per-message processing cost; for each configuration:
+ *
+ *  - ``producers`` threads send for ``duration`` ms, round-robin
+ *    over the busses, with at most ``window`` messages each not
+ *    yet finalized (closed loop on finalization, not on replies)
+ *
+ *  - each subscriber thread receives, spins ``cost`` ns and releases
+ *
+ *  and reports messages/s, deliveries/s, the send-to-receive latency
+ *  percentiles over all deliveries (hops) and the CPU time used.
+ *
+ *  Each configuration runs in its own process: closed connections
+ *  aren't reclaimed by the library.
+ *
+ *  Usage:
+ *    bench [-p 1,2,4] [-b 1,2] [-s 1,2,4] [-c 0,1000] [-d 1000] [-w 256] [-j] [-m rate]
+ *
+ *      -m: samples the traffic matrix, 1 message out of ``rate``,
+ *          and prints it on stderr after each configuration
+ *
+ *  Output: CSV on stdout (JSON with -j)
+ *
+ */
+
+#include <litm.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "bench_util.h"
+
+#define TYPE_BENCH LITM_MESSAGE_TYPE_USER_START
+
+typedef struct {
+	int producers;
+	int busses;
+	int subscribers;
+	int cost_ns;
+	int duration_ms;
+	int window;
+} bench_config;
+
+typedef struct {
+	unsigned long long sent_ns;
+	int producer;
+} bench_message;
+
+typedef struct {
+	int index;
+	litm_connection *conn;
+	pthread_t thread;
+	long count;
+	bench_hist *latency;
+} bench_worker;
+
+
+bench_config config;
+bench_worker producers[LITM_CONNECTION_MAX];
+bench_worker subscribers[LITM_CONNECTION_MAX];
+
+volatile int in_flight[LITM_CONNECTION_MAX];
+volatile int stop_producers = 0, stop_subscribers = 0;
+
+int json = 0, traffic = 0;
+
+void  run_config(bench_config *cfg, int first);
+void *producer_thread(void *params);
+void *subscriber_thread(void *params);
+void  bench_cleaner(void *msg);
+
+
+int main(int argc, char **argv) {
+
+	int p_list[BENCH_LIST_MAX] = {1, 2, 4}, p_count = 3;
+	int b_list[BENCH_LIST_MAX] = {1, 2},    b_count = 2;
+	int s_list[BENCH_LIST_MAX] = {1, 2, 4}, s_count = 3;
+	int c_list[BENCH_LIST_MAX] = {0, 1000}, c_count = 2;
+	int duration = 1000, window = 256;
+	int opt, p, b, s, c, first = 1;
+	bench_config cfg;
+
+	while (-1 != (opt = getopt(argc, argv, "p:b:s:c:d:w:jm:"))) {
+		switch (opt) {
+		case 'p': p_count = bench_parse_list( optarg, p_list, BENCH_LIST_MAX ); break;
+		case 'b': b_count = bench_parse_list( optarg, b_list, BENCH_LIST_MAX ); break;
+		case 's': s_count = bench_parse_list( optarg, s_list, BENCH_LIST_MAX ); break;
+		case 'c': c_count = bench_parse_list( optarg, c_list, BENCH_LIST_MAX ); break;
+		case 'd': duration = atoi( optarg ); break;
+		case 'w': window   = atoi( optarg ); break;
+		case 'j': json = 1; break;
+		case 'm': traffic  = atoi( optarg ); break;
+		default:
+			fprintf( stderr, "usage: %s [-p list] [-b list] [-s list] [-c list] [-d ms] [-w window] [-j] [-m rate]\n", argv[0] );
+			return 1;
+		}
+	}
+
+	if (json)
+		printf("[\n");
+	else
+		printf("producers,busses,subscribers,cost_ns,messages,seconds,msgs_per_s,deliveries_per_s,"
+				"lat_p50_ns,lat_p90_ns,lat_p99_ns,lat_p999_ns,lat_max_ns,cpu_s\n");
+	fflush( stdout );
+
+	for (p=0; p<p_count; p++)
+	for (b=0; b<b_count; b++)
+	for (s=0; s<s_count; s++)
+	for (c=0; c<c_count; c++) {
+
+		cfg.producers   = p_list[p];
+		cfg.busses      = b_list[b];
+		cfg.subscribers = s_list[s];
+		cfg.cost_ns     = c_list[c];
+		cfg.duration_ms = duration;
+		cfg.window      = window;
+
+		// connection slots 1..LITM_CONNECTION_MAX-1 and busses 1..LITM_BUSSES_MAX
+		if ((cfg.producers + cfg.busses * cfg.subscribers >= LITM_CONNECTION_MAX) || (cfg.busses > LITM_BUSSES_MAX)) {
+			fprintf( stderr, "# skipped p[%i] b[%i] s[%i]: too many connections\n", cfg.producers, cfg.busses, cfg.subscribers );
+			continue;
+		}
+
+		// a fresh library instance per configuration
+		pid_t pid = fork();
+		if (0==pid) {
+			run_config( &cfg, first );
+			exit( 0 );
+		}
+		waitpid( pid, NULL, 0 );
+		first = 0;
+	}
+
+	if (json)
+		printf("\n]\n");
+
+	return 0;
+}
+
+void run_config(bench_config *cfg, int first) {
+
+	unsigned long long start, end, deadline;
+	double cpu_start, cpu;
+	bench_hist *latency = bench_hist_create();
+	long messages = 0, deliveries = 0;
+	int i, count;
+
+	config = *cfg;
+
+	litm_traffic_set_sampling( traffic );
+
+	count = config.busses * config.subscribers;
+
+	for (i=0; i<config.producers; i++) {
+		producers[i].index = i;
+		litm_connect_ex( &producers[i].conn, 1 + i );
+	}
+
+	for (i=0; i<count; i++) {
+		subscribers[i].index = i;
+		subscribers[i].latency = bench_hist_create();
+		litm_connect_ex( &subscribers[i].conn, 100 + i );
+		litm_subscribe( subscribers[i].conn, 1 + i / config.subscribers );
+	}
+
+	cpu_start = bench_cpu_seconds();
+	start = bench_now_ns();
+
+	for (i=0; i<count; i++)
+		pthread_create( &subscribers[i].thread, NULL, &subscriber_thread, &subscribers[i] );
+	for (i=0; i<config.producers; i++)
+		pthread_create( &producers[i].thread, NULL, &producer_thread, &producers[i] );
+
+	usleep( config.duration_ms * 1000 );
+	stop_producers = 1;
+
+	for (i=0; i<config.producers; i++) {
+		pthread_join( producers[i].thread, NULL );
+		messages += producers[i].count;
+	}
+
+	// drain: everything sent must be finalized
+	deadline = bench_now_ns() + 5000000000ULL;
+	for (i=0; i<config.producers; i++)
+		while ((0 < in_flight[i]) && (bench_now_ns() < deadline))
+			usleep( 100 );
+
+	end = bench_now_ns();
+	stop_subscribers = 1;
+
+	for (i=0; i<count; i++) {
+		pthread_join( subscribers[i].thread, NULL );
+		deliveries += subscribers[i].count;
+		bench_hist_merge( latency, subscribers[i].latency );
+	}
+
+	cpu = bench_cpu_seconds() - cpu_start;
+
+	double seconds = (end - start) / 1e9;
+
+	if (json) {
+		printf("%s  {\"producers\": %i, \"busses\": %i, \"subscribers\": %i, \"cost_ns\": %i, "
+				"\"messages\": %li, \"seconds\": %.3f, \"msgs_per_s\": %.0f, \"deliveries_per_s\": %.0f, "
+				"\"lat_p50_ns\": %llu, \"lat_p90_ns\": %llu, \"lat_p99_ns\": %llu, \"lat_p999_ns\": %llu, "
+				"\"lat_max_ns\": %llu, \"cpu_s\": %.3f}",
+				first ? "" : ",\n",
+				config.producers, config.busses, config.subscribers, config.cost_ns,
+				messages, seconds, messages / seconds, deliveries / seconds,
+				bench_hist_percentile(latency, 50.0), bench_hist_percentile(latency, 90.0),
+				bench_hist_percentile(latency, 99.0), bench_hist_percentile(latency, 99.9),
+				latency->max, cpu );
+	} else {
+		printf("%i,%i,%i,%i,%li,%.3f,%.0f,%.0f,%llu,%llu,%llu,%llu,%llu,%.3f\n",
+				config.producers, config.busses, config.subscribers, config.cost_ns,
+				messages, seconds, messages / seconds, deliveries / seconds,
+				bench_hist_percentile(latency, 50.0), bench_hist_percentile(latency, 90.0),
+				bench_hist_percentile(latency, 99.0), bench_hist_percentile(latency, 99.9),
+				latency->max, cpu );
+	}
+	fflush( stdout );
+
+	if (0!=traffic)
+		bench_print_traffic( stderr );
+}//
+
+void *producer_thread(void *params) {
+
+	bench_worker *self = (bench_worker *) params;
+	bench_message *msg;
+	litm_code code;
+	int bus = 0;
+
+	while (!stop_producers) {
+
+		if (config.window <= in_flight[self->index]) {
+			sched_yield();
+			continue;
+		}
+
+		msg = (bench_message *) litm_msg_alloc( self->conn, sizeof(bench_message) );
+		msg->producer = self->index;
+
+		__sync_fetch_and_add( &in_flight[self->index], 1 );
+
+		do {
+			msg->sent_ns = bench_now_ns();
+			code = litm_send( self->conn, 1 + bus, msg, &bench_cleaner, TYPE_BENCH );
+		} while (LITM_CODE_BUSY==code);
+
+		if (LITM_CODE_OK!=code) {
+			__sync_fetch_and_sub( &in_flight[self->index], 1 );
+			litm_msg_free( msg );
+			continue;
+		}
+
+		self->count++;
+		bus = (bus + 1) % config.busses;
+	}
+
+	return NULL;
+}//
+
+void *subscriber_thread(void *params) {
+
+	bench_worker *self = (bench_worker *) params;
+	bench_message *msg;
+	litm_envelope *e;
+	int type;
+
+	while (!stop_subscribers) {
+
+		if (LITM_CODE_OK != litm_receive_wait_timer( self->conn, &e, 10*1000 ))
+			continue;
+
+		msg = (bench_message *) litm_get_message( e, &type );
+		bench_hist_record( self->latency, bench_now_ns() - msg->sent_ns );
+
+		bench_spin_ns( config.cost_ns );
+		self->count++;
+
+		litm_release( self->conn, e );
+	}
+
+	return NULL;
+}//
+
+void bench_cleaner(void *msg) {
+
+	__sync_fetch_and_sub( &in_flight[((bench_message *) msg)->producer], 1 );
+	litm_msg_free( msg );
+}
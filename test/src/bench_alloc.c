@@ -0,0 +1,188 @@
+/*
+ * bench_alloc.c
+ *
+ *  Created on: 2026-10-19
+ *      Author: Jean-Lou Dupont
+ *
+ *
+ *  Allocation & memory footprint report
+ *
+ *  A producer sends ``messages`` on bus 1 to ``subscribers``,
+ *  keeping at most ``window`` of them in flight.  The allocation
+ *  counters of the library (@see litm_get_alloc_stats) are read
+ *  once the ``warmup`` messages went through and again at the end:
+ *  the difference tells, per subsystem, how many heap allocations
+ *  steady-state messaging still costs.
+ *
+ *  The queue backends are chosen through the environment variables
+ *  LITM_SWITCH_QUEUE & LITM_CONNECTION_QUEUE: the list and MPSC
+ *  backends allocate a node per queued item.
+ *
+ *  Usage:
+ *    bench_alloc [-n 100000] [-w 10000] [-s 2] [-W 64] [-a]
+ *
+ *      -a: messages from litm_msg_alloc instead of static ones
+ *
+ *  Output: CSV, one line per subsystem, then the verdict.
+ *
+ */
+
+#include <litm.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TYPE_BENCH LITM_MESSAGE_TYPE_USER_START
+#define BUS_DATA   1
+
+typedef struct {
+	litm_connection *conn;
+	pthread_t thread;
+	long count;
+} bench_worker;
+
+int messages = 100000, warmup = 10000, subscribers_count = 2, window = 64, slab = 0;
+
+bench_worker subscribers[LITM_CONNECTION_MAX];
+
+volatile long finalized = 0;
+volatile int stop_subscribers = 0;
+int static_message;
+
+void *subscriber_thread(void *params);
+void  bench_cleaner(void *msg);
+void  send_messages(litm_connection *conn, int count);
+
+
+int main(int argc, char **argv) {
+
+	litm_alloc_stats before, after, end;
+	litm_alloc_counters *b, *a, *z;
+	litm_connection *producer;
+	long total = 0, leaked = 0;
+	int opt, i, cls;
+
+	while (-1 != (opt = getopt(argc, argv, "n:w:s:W:a"))) {
+		switch (opt) {
+		case 'n': messages          = atoi( optarg ); break;
+		case 'w': warmup            = atoi( optarg ); break;
+		case 's': subscribers_count = atoi( optarg ); break;
+		case 'W': window            = atoi( optarg ); break;
+		case 'a': slab = 1; break;
+		default:
+			fprintf( stderr, "usage: %s [-n messages] [-w warmup] [-s subscribers] [-W window] [-a]\n", argv[0] );
+			return 1;
+		}
+	}
+
+	if ((1 + subscribers_count >= LITM_CONNECTION_MAX) || (0 >= messages) || (0 >= window)) {
+		fprintf( stderr, "invalid configuration: at most %i connections\n", LITM_CONNECTION_MAX-1 );
+		return 1;
+	}
+
+	litm_connect_ex( &producer, 1 );
+
+	for (i=0; i<subscribers_count; i++) {
+		litm_connect_ex( &subscribers[i].conn, 100 + i );
+		litm_subscribe( subscribers[i].conn, BUS_DATA );
+		pthread_create( &subscribers[i].thread, NULL, &subscriber_thread, &subscribers[i] );
+	}
+
+	send_messages( producer, warmup );
+	litm_get_alloc_stats( &before );
+
+	send_messages( producer, messages );
+	litm_get_alloc_stats( &after );
+
+	stop_subscribers = 1;
+	for (i=0; i<subscribers_count; i++)
+		pthread_join( subscribers[i].thread, NULL );
+
+	litm_get_alloc_stats( &end );
+
+	printf("# messages[%i] warmup[%i] subscribers[%i] window[%i] msg_alloc[%i] switch_queue[%s] connection_queue[%s]\n",
+			messages, warmup, subscribers_count, window, slab,
+			getenv("LITM_SWITCH_QUEUE") ? getenv("LITM_SWITCH_QUEUE") : "default",
+			getenv("LITM_CONNECTION_QUEUE") ? getenv("LITM_CONNECTION_QUEUE") : "default");
+	printf("class,allocs,frees,steady_allocs,steady_frees,allocs_per_msg,live_bytes,peak_bytes\n");
+
+	for (cls=0; cls<LITM_ALLOC_CLASSES; cls++) {
+		b = &before.classes[cls];
+		a = &after.classes[cls];
+		z = &end.classes[cls];
+
+		printf("%s,%li,%li,%li,%li,%.4f,%li,%li\n", litm_translate_alloc_class( cls ),
+				z->allocs, z->frees, a->allocs - b->allocs, a->frees - b->frees,
+				(double) (a->allocs - b->allocs) / messages, z->live_bytes, z->peak_bytes);
+
+		total  += a->allocs - b->allocs;
+		leaked += (a->allocs - b->allocs) - (a->frees - b->frees);
+	}
+
+	printf("# steady state: allocations[%li] per_message[%.4f] not_freed[%li] %s\n",
+			total, (double) total / messages, leaked, (0==total) ? "ZERO-ALLOC" : "ALLOCATING");
+
+	return 0;
+}
+
+/**
+ * Sends, keeping at most ``window`` messages in flight
+ */
+void send_messages(litm_connection *conn, int count) {
+
+	long target = finalized + count;
+	long sent = finalized;
+	litm_code code;
+	void *msg;
+
+	while (sent < target) {
+
+		if (sent - finalized >= window) {
+			sched_yield();
+			continue;
+		}
+
+		msg = slab ? litm_msg_alloc( conn, sizeof(long) ) : (void *) &static_message;
+
+		do {
+			code = litm_send( conn, BUS_DATA, msg, &bench_cleaner, TYPE_BENCH );
+		} while (LITM_CODE_BUSY==code);
+
+		if (LITM_CODE_OK!=code) {
+			fprintf( stderr, "send failed: %s\n", litm_translate_code( code ) );
+			exit( 1 );
+		}
+		sent++;
+	}
+
+	while (finalized < target)
+		sched_yield();
+}//
+
+void *subscriber_thread(void *params) {
+
+	bench_worker *self = (bench_worker *) params;
+	litm_envelope *e;
+
+	while (!stop_subscribers) {
+
+		if (LITM_CODE_OK != litm_receive_wait_timer( self->conn, &e, 10*1000 ))
+			continue;
+
+		self->count++;
+		litm_release( self->conn, e );
+	}
+
+	return NULL;
+}//
+
+void bench_cleaner(void *msg) {
+
+	if (msg != (void *) &static_message)
+		litm_msg_free( msg );
+
+	__sync_fetch_and_add( &finalized, 1 );
+}//
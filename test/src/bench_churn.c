@@ -0,0 +1,444 @@
+/*
+ * bench_churn.c
+ *
+ *  Created on: 2026-10-19
+ *      Author: Jean-Lou Dupont
+ *
+ *
+ *  Connection & subscription churn benchmark
+ *
+ *  A producer sends on bus 1 at a steady ``rate`` to ``subscribers``
+ *  steady subscribers.  After a ``baseline`` period, ``churners``
+ *  threads each cycle at ``cycles`` per second through:
+ *
+ *    litm_connect_ex, litm_subscribe( bus 1 ), receive for a while,
+ *    litm_unsubscribe, litm_disconnect
+ *
+ *  When no connection slot is left (LITM_CODE_ERROR_NO_MORE_CONNECTIONS:
+ *  the slots of closed connections aren't reclaimed), a churner falls back to
+ *  subscribe / unsubscribe cycles on its own persistent connection
+ *  and the ``exhausted`` counter goes up.
+ *
+ *  Reported:
+ *
+ *  - latency of each control operation, BUSY retries included, and
+ *    the rate of LITM_CODE_BUSY returns
+ *  - send-to-receive latency of the steady subscribers, baseline
+ *    vs during the churn
+ *  - a time series of the process RSS & connection counters
+ *
+ *  Usage:
+ *    bench_churn [-r 20000] [-s 2] [-c 2] [-y 1000] [-d 2000] [-W 500] [-i 250] [-L]
+ *
+ *      -y: cycles per second, per churner
+ *      -i: sampling interval (ms) of the time series
+ *      -L: lock statistics since about the start of the churn (LITM_LOCK_PROFILE build)
+ *
+ *  Output: CSV sections, each preceded by its header.
+ *
+ */
+
+#include <litm.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bench_util.h"
+
+#define TYPE_BENCH LITM_MESSAGE_TYPE_USER_START
+#define BUS_DATA   1
+
+#define SAMPLES_MAX 1024
+
+enum {
+	OP_CONNECT = 0,
+	OP_SUBSCRIBE,
+	OP_UNSUBSCRIBE,
+	OP_DISCONNECT,
+	OP_COUNT
+};
+
+const char *op_names[OP_COUNT] = { "connect", "subscribe", "unsubscribe", "disconnect" };
+
+typedef struct {
+	unsigned long long sent_ns;
+} bench_message;
+
+typedef struct {
+	int index;
+	litm_connection *conn;
+	pthread_t thread;
+	long count;
+	bench_hist *baseline;
+	bench_hist *churn;
+	bench_hist *ops[OP_COUNT];
+	long calls[OP_COUNT];
+	long busy[OP_COUNT];
+	long exhausted;
+	long cycles;
+} bench_worker;
+
+typedef struct {
+	unsigned long long t_ms;
+	long rss_kb;
+	long connects;
+	long exhausted;
+	long cycles;
+} bench_sample;
+
+
+int rate = 20000, subscribers_count = 2, churners_count = 2, cycles_per_second = 1000;
+int duration_ms = 2000, warmup_ms = 500, interval_ms = 250, lock_stats = 0;
+
+unsigned long long record_from_ns, churn_from_ns;
+
+bench_worker producer;
+bench_worker subscribers[LITM_CONNECTION_MAX];
+bench_worker churners[LITM_CONNECTION_MAX];
+
+bench_sample samples[SAMPLES_MAX];
+int samples_count = 0;
+
+volatile int stop_producer = 0, stop_subscribers = 0, stop_churners = 0;
+
+void *producer_thread(void *params);
+void *subscriber_thread(void *params);
+void *churner_thread(void *params);
+void  drain(bench_worker *self, litm_connection *conn, int usecs);
+litm_code timed_op(bench_worker *self, int op, litm_connection **conn, int id);
+long  rss_kb(void);
+void  take_sample(unsigned long long start_ns);
+void  print_summary(const char *section, const char *name, long calls, long busy, bench_hist *h);
+
+
+int main(int argc, char **argv) {
+
+	bench_hist *baseline, *churn, *ops[OP_COUNT];
+	unsigned long long start_ns, end_ns;
+	long calls[OP_COUNT], busy[OP_COUNT], exhausted = 0;
+	int opt, i, op;
+
+	while (-1 != (opt = getopt(argc, argv, "r:s:c:y:d:W:i:L"))) {
+		switch (opt) {
+		case 'r': rate              = atoi( optarg ); break;
+		case 's': subscribers_count = atoi( optarg ); break;
+		case 'c': churners_count    = atoi( optarg ); break;
+		case 'y': cycles_per_second = atoi( optarg ); break;
+		case 'd': duration_ms       = atoi( optarg ); break;
+		case 'W': warmup_ms         = atoi( optarg ); break;
+		case 'i': interval_ms       = atoi( optarg ); break;
+		case 'L': lock_stats = 1; break;
+		default:
+			fprintf( stderr, "usage: %s [-r rate] [-s subscribers] [-c churners] [-y cycles/s] [-d ms] [-W warmup_ms] [-i sample_ms] [-L]\n", argv[0] );
+			return 1;
+		}
+	}
+
+	// the persistent connections: producer, subscribers & churners
+	if ((1 + subscribers_count + churners_count >= LITM_CONNECTION_MAX) || (0 >= rate) || (0 >= cycles_per_second) || (0 >= interval_ms)) {
+		fprintf( stderr, "invalid configuration: at most %i connections\n", LITM_CONNECTION_MAX-1 );
+		return 1;
+	}
+
+	litm_connect_ex( &producer.conn, 1 );
+
+	for (i=0; i<subscribers_count; i++) {
+		subscribers[i].index    = i;
+		subscribers[i].baseline = bench_hist_create();
+		subscribers[i].churn    = bench_hist_create();
+		litm_connect_ex( &subscribers[i].conn, 100 + i );
+		litm_subscribe( subscribers[i].conn, BUS_DATA );
+	}
+
+	for (i=0; i<churners_count; i++) {
+		churners[i].index = i;
+		for (op=0; op<OP_COUNT; op++)
+			churners[i].ops[op] = bench_hist_create();
+		litm_connect_ex( &churners[i].conn, 200 + i );
+	}
+
+	start_ns       = bench_now_ns();
+	record_from_ns = start_ns + (unsigned long long) warmup_ms * 1000000ULL;
+	churn_from_ns  = record_from_ns + (unsigned long long) duration_ms * 1000000ULL;
+	end_ns         = churn_from_ns + (unsigned long long) duration_ms * 1000000ULL;
+
+	for (i=0; i<subscribers_count; i++)
+		pthread_create( &subscribers[i].thread, NULL, &subscriber_thread, &subscribers[i] );
+	pthread_create( &producer.thread, NULL, &producer_thread, &producer );
+	for (i=0; i<churners_count; i++)
+		pthread_create( &churners[i].thread, NULL, &churner_thread, &churners[i] );
+
+	while (bench_now_ns() < end_ns) {
+		take_sample( start_ns );
+		usleep( interval_ms * 1000 );
+		if (lock_stats && (bench_now_ns() < churn_from_ns))
+			litm_reset_lock_stats();
+	}
+	take_sample( start_ns );
+
+	stop_churners = 1;
+	for (i=0; i<churners_count; i++)
+		pthread_join( churners[i].thread, NULL );
+
+	stop_producer = 1;
+	pthread_join( producer.thread, NULL );
+
+	// let the steady subscribers drain
+	usleep( 100*1000 );
+	stop_subscribers = 1;
+	for (i=0; i<subscribers_count; i++)
+		pthread_join( subscribers[i].thread, NULL );
+
+	// all the workers in one histogram per measure
+	baseline = bench_hist_create();
+	churn    = bench_hist_create();
+	for (i=0; i<subscribers_count; i++) {
+		bench_hist_merge( baseline, subscribers[i].baseline );
+		bench_hist_merge( churn, subscribers[i].churn );
+	}
+
+	for (op=0; op<OP_COUNT; op++) {
+		ops[op] = bench_hist_create();
+		calls[op] = busy[op] = 0;
+		for (i=0; i<churners_count; i++) {
+			bench_hist_merge( ops[op], churners[i].ops[op] );
+			calls[op] += churners[i].calls[op];
+			busy[op]  += churners[i].busy[op];
+		}
+	}
+	for (i=0; i<churners_count; i++)
+		exhausted += churners[i].exhausted;
+
+	printf("# rate[%i] subscribers[%i] churners[%i] cycles_per_second[%i] duration_ms[%i] sent[%li] connections_exhausted[%li]\n",
+			rate, subscribers_count, churners_count, cycles_per_second, duration_ms, producer.count, exhausted);
+
+	printf("section,name,calls,busy,busy_rate,p50_ns,p99_ns,p999_ns,max_ns\n");
+	for (op=0; op<OP_COUNT; op++)
+		print_summary( "control", op_names[op], calls[op], busy[op], ops[op] );
+	print_summary( "data", "baseline", baseline->total, 0, baseline );
+	print_summary( "data", "churn", churn->total, 0, churn );
+
+	printf("sample,t_ms,rss_kb,connects,exhausted,cycles\n");
+	for (i=0; i<samples_count; i++)
+		printf("sample,%llu,%li,%li,%li,%li\n", samples[i].t_ms, samples[i].rss_kb,
+				samples[i].connects, samples[i].exhausted, samples[i].cycles);
+
+	if (lock_stats && !bench_print_lock_stats( stdout ))
+		fprintf( stderr, "# no lock statistics: the library isn't a LITM_LOCK_PROFILE build\n" );
+
+	return 0;
+}
+
+void print_summary(const char *section, const char *name, long calls, long busy, bench_hist *h) {
+
+	printf("%s,%s,%li,%li,%.4f,%llu,%llu,%llu,%llu\n", section, name, calls, busy,
+			(0==calls) ? 0.0 : (double) busy / (calls + busy),
+			bench_hist_percentile(h, 50.0), bench_hist_percentile(h, 99.0),
+			bench_hist_percentile(h, 99.9), h->max );
+}//
+
+/**
+ * Resident set size, from /proc/self/statm
+ */
+long rss_kb(void) {
+
+	long size = 0, resident = 0;
+	FILE *f = fopen( "/proc/self/statm", "r" );
+
+	if (NULL==f)
+		return -1;
+	if (2 != fscanf( f, "%li %li", &size, &resident ))
+		resident = -1;
+	fclose( f );
+
+	return (0 > resident) ? -1 : resident * (sysconf(_SC_PAGESIZE) / 1024);
+}//
+
+void take_sample(unsigned long long start_ns) {
+
+	bench_sample *s;
+	int i;
+
+	if (SAMPLES_MAX <= samples_count)
+		return;
+
+	s = &samples[samples_count++];
+	memset( s, 0, sizeof(bench_sample) );
+	s->t_ms   = (bench_now_ns() - start_ns) / 1000000ULL;
+	s->rss_kb = rss_kb();
+
+	// indicative: the counters are read without synchronization
+	for (i=0; i<churners_count; i++) {
+		s->connects  += churners[i].calls[OP_CONNECT];
+		s->exhausted += churners[i].exhausted;
+		s->cycles    += churners[i].cycles;
+	}
+}//
+
+/**
+ * Sends at a steady rate
+ */
+void *producer_thread(void *params) {
+
+	bench_worker *self = (bench_worker *) params;
+	unsigned long long interval = 1000000000ULL / rate;
+	unsigned long long next = bench_now_ns(), now;
+	struct timespec pause;
+	bench_message *msg;
+	litm_code code;
+
+	while (!stop_producer) {
+
+		now = bench_now_ns();
+		if (now < next) {
+			if (next - now > 100000ULL) {
+				pause.tv_sec  = 0;
+				pause.tv_nsec = (long) (next - now - 50000ULL);
+				nanosleep( &pause, NULL );
+			}
+			continue;
+		}
+		next += interval;
+
+		msg = (bench_message *) litm_msg_alloc( self->conn, sizeof(bench_message) );
+		if (NULL==msg)
+			continue;
+		msg->sent_ns = bench_now_ns();
+
+		do {
+			code = litm_send( self->conn, BUS_DATA, msg, NULL, TYPE_BENCH );
+		} while (LITM_CODE_BUSY==code);
+
+		if (LITM_CODE_OK!=code)
+			litm_msg_free( msg );
+		else
+			self->count++;
+	}
+
+	return NULL;
+}//
+
+void *subscriber_thread(void *params) {
+
+	bench_worker *self = (bench_worker *) params;
+	bench_message *msg;
+	litm_envelope *e;
+	unsigned long long now;
+	int type;
+
+	while (!stop_subscribers) {
+
+		if (LITM_CODE_OK != litm_receive_wait_timer( self->conn, &e, 10*1000 ))
+			continue;
+
+		msg = (bench_message *) litm_get_message( e, &type );
+		now = bench_now_ns();
+
+		if (msg->sent_ns >= churn_from_ns)
+			bench_hist_record( self->churn, now - msg->sent_ns );
+		else if (msg->sent_ns >= record_from_ns)
+			bench_hist_record( self->baseline, now - msg->sent_ns );
+
+		self->count++;
+		litm_release( self->conn, e );
+	}
+
+	return NULL;
+}//
+
+/**
+ * Runs a control operation until it doesn't return LITM_CODE_BUSY
+ */
+litm_code timed_op(bench_worker *self, int op, litm_connection **conn, int id) {
+
+	unsigned long long t0 = bench_now_ns();
+	litm_code code;
+
+	while (1) {
+		switch (op) {
+		case OP_CONNECT:     code = litm_connect_ex( conn, id );           break;
+		case OP_SUBSCRIBE:   code = litm_subscribe( *conn, BUS_DATA );     break;
+		case OP_UNSUBSCRIBE: code = litm_unsubscribe( *conn, BUS_DATA );   break;
+		case OP_DISCONNECT:
+		default:             code = litm_disconnect( *conn );              break;
+		}
+		if (LITM_CODE_BUSY!=code)
+			break;
+		self->busy[op]++;
+	}
+
+	bench_hist_record( self->ops[op], bench_now_ns() - t0 );
+	self->calls[op]++;
+
+	return code;
+}//
+
+/**
+ * Receives & releases whatever is (or shortly becomes) pending:
+ *  an envelope kept would stall the turn-wise delivery of the bus
+ */
+void drain(bench_worker *self, litm_connection *conn, int usecs) {
+
+	litm_envelope *e;
+
+	while (LITM_CODE_OK == litm_receive_wait_timer( conn, &e, usecs )) {
+		self->count++;
+		litm_release( conn, e );
+	}
+}//
+
+void *churner_thread(void *params) {
+
+	bench_worker *self = (bench_worker *) params;
+	unsigned long long interval = 1000000000ULL / cycles_per_second;
+	unsigned long long next, now;
+	litm_connection *conn;
+	litm_code code;
+	int id = 1000 + self->index * 100000, dedicated = 1;
+
+	while (bench_now_ns() < churn_from_ns)
+		usleep( 1000 );
+
+	next = bench_now_ns();
+
+	while (!stop_churners) {
+
+		now = bench_now_ns();
+		if (now < next) {
+			drain( self, self->conn, 0 );
+			usleep( (next - now) / 1000 );
+			continue;
+		}
+		next += interval;
+
+		// a dedicated connection per cycle, while slots are left
+		conn = NULL;
+		if (dedicated) {
+			code = timed_op( self, OP_CONNECT, &conn, ++id );
+			if (LITM_CODE_ERROR_NO_MORE_CONNECTIONS==code) {
+				self->exhausted++;
+				dedicated = 0;
+				conn = NULL;
+			}
+		}
+		if (NULL==conn)
+			conn = self->conn;
+
+		if (LITM_CODE_OK == timed_op( self, OP_SUBSCRIBE, &conn, 0 )) {
+			drain( self, conn, 100 );
+			timed_op( self, OP_UNSUBSCRIBE, &conn, 0 );
+			// deliveries made before the removal
+			drain( self, conn, 1000 );
+		}
+
+		if (conn != self->conn)
+			timed_op( self, OP_DISCONNECT, &conn, 0 );
+
+		self->cycles++;
+	}
+
+	return NULL;
+}//
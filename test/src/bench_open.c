@@ -0,0 +1,276 @@
+/*
+ * bench_open.c
+ *
+ *  Created on: 2026-10-19
+ *      Author: Jean-Lou Dupont
+ *
+ *
+ *  Open-loop latency benchmark
+ *
+ *  Producers send on a fixed schedule (``rate`` messages/s overall,
+ *  round-robin over the busses) whatever the state of the switch:
+ *  latencies are measured against the *intended* send time thus a
+ *  stalled producer doesn't hide the queuing delay (coordinated
+ *  omission correction).
+ *
+ *  Recorded, past the warm-up period:
+ *
+ *  - send-to-receive latency per bus and per subscriber *position*:
+ *    turn-wise delivery makes the last subscriber's latency grow
+ *    with the number of subscribers
+ *
+ *  - send-to-finalize latency per bus (all subscribers released)
+ *
+ *  Usage:
+ *    bench_open [-r 100000] [-p 1] [-b 1] [-s 4] [-c 0] [-d 5000] [-W 1000] [-H]
+ *
+ *  Output: one summary line per histogram (CSV), followed with -H
+ *  by the full percentile distributions (HdrHistogram style).
+ *
+ */
+
+#include <litm.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bench_util.h"
+
+#define TYPE_BENCH LITM_MESSAGE_TYPE_USER_START
+
+typedef struct {
+	unsigned long long intended_ns;
+	int bus;
+} bench_message;
+
+typedef struct {
+	int index;
+	int bus;
+	int position;
+	litm_connection *conn;
+	pthread_t thread;
+	long count;
+	bench_hist *latency;
+} bench_worker;
+
+
+int rate = 100000, producers_count = 1, busses = 1, subscribers_count = 4, cost_ns = 0;
+int duration_ms = 5000, warmup_ms = 1000, full = 0;
+
+unsigned long long start_ns, record_from_ns;
+
+bench_worker producers[LITM_CONNECTION_MAX];
+bench_worker subscribers[LITM_CONNECTION_MAX];
+bench_hist  *finalized[LITM_BUSSES_MAX+1];
+
+volatile int finalize_lock = 0;
+volatile long in_flight = 0, late = 0;
+volatile int stop_producers = 0, stop_subscribers = 0;
+
+void *producer_thread(void *params);
+void *subscriber_thread(void *params);
+void  bench_cleaner(void *msg);
+void  print_summary(const char *name, int bus, int position, bench_hist *h);
+
+
+int main(int argc, char **argv) {
+
+	int opt, i, b, count;
+	unsigned long long deadline;
+
+	while (-1 != (opt = getopt(argc, argv, "r:p:b:s:c:d:W:H"))) {
+		switch (opt) {
+		case 'r': rate              = atoi( optarg ); break;
+		case 'p': producers_count   = atoi( optarg ); break;
+		case 'b': busses            = atoi( optarg ); break;
+		case 's': subscribers_count = atoi( optarg ); break;
+		case 'c': cost_ns           = atoi( optarg ); break;
+		case 'd': duration_ms       = atoi( optarg ); break;
+		case 'W': warmup_ms         = atoi( optarg ); break;
+		case 'H': full = 1; break;
+		default:
+			fprintf( stderr, "usage: %s [-r rate] [-p producers] [-b busses] [-s subscribers] [-c cost_ns] [-d ms] [-W warmup_ms] [-H]\n", argv[0] );
+			return 1;
+		}
+	}
+
+	count = busses * subscribers_count;
+	if ((producers_count + count >= LITM_CONNECTION_MAX) || (busses > LITM_BUSSES_MAX) || (0 >= rate)) {
+		fprintf( stderr, "invalid configuration: at most %i connections & %i busses\n", LITM_CONNECTION_MAX-1, LITM_BUSSES_MAX );
+		return 1;
+	}
+
+	for (b=1; b<=busses; b++)
+		finalized[b] = bench_hist_create();
+
+	for (i=0; i<producers_count; i++) {
+		producers[i].index = i;
+		litm_connect_ex( &producers[i].conn, 1 + i );
+	}
+
+	// subscription order is the delivery order
+	for (i=0; i<count; i++) {
+		subscribers[i].index    = i;
+		subscribers[i].bus      = 1 + i / subscribers_count;
+		subscribers[i].position = 1 + i % subscribers_count;
+		subscribers[i].latency  = bench_hist_create();
+		litm_connect_ex( &subscribers[i].conn, 100 + i );
+		litm_subscribe( subscribers[i].conn, subscribers[i].bus );
+	}
+
+	for (i=0; i<count; i++)
+		pthread_create( &subscribers[i].thread, NULL, &subscriber_thread, &subscribers[i] );
+
+	start_ns = bench_now_ns() + 10000000ULL;
+	record_from_ns = start_ns + (unsigned long long) warmup_ms * 1000000ULL;
+
+	for (i=0; i<producers_count; i++)
+		pthread_create( &producers[i].thread, NULL, &producer_thread, &producers[i] );
+
+	usleep( (warmup_ms + duration_ms) * 1000 + 10000 );
+	stop_producers = 1;
+
+	for (i=0; i<producers_count; i++)
+		pthread_join( producers[i].thread, NULL );
+
+	deadline = bench_now_ns() + 5000000000ULL;
+	while ((0 < in_flight) && (bench_now_ns() < deadline))
+		usleep( 100 );
+
+	stop_subscribers = 1;
+	for (i=0; i<count; i++)
+		pthread_join( subscribers[i].thread, NULL );
+
+	printf("# rate[%i] producers[%i] busses[%i] subscribers[%i] cost_ns[%i] duration_ms[%i] late_sends[%li] unfinalized[%li]\n",
+			rate, producers_count, busses, subscribers_count, cost_ns, duration_ms, late, in_flight);
+	printf("histogram,bus,position,count,p50_ns,p90_ns,p99_ns,p999_ns,p9999_ns,max_ns\n");
+
+	for (i=0; i<count; i++)
+		print_summary( "receive", subscribers[i].bus, subscribers[i].position, subscribers[i].latency );
+	for (b=1; b<=busses; b++)
+		print_summary( "finalize", b, 0, finalized[b] );
+
+	if (full) {
+		char name[64];
+		for (i=0; i<count; i++) {
+			snprintf( name, sizeof(name), "receive bus[%i] position[%i]", subscribers[i].bus, subscribers[i].position );
+			bench_hist_print( stdout, name, subscribers[i].latency );
+		}
+		for (b=1; b<=busses; b++) {
+			snprintf( name, sizeof(name), "finalize bus[%i]", b );
+			bench_hist_print( stdout, name, finalized[b] );
+		}
+	}
+
+	return 0;
+}
+
+void print_summary(const char *name, int bus, int position, bench_hist *h) {
+
+	printf("%s,%i,%i,%llu,%llu,%llu,%llu,%llu,%llu,%llu\n", name, bus, position, h->total,
+			bench_hist_percentile(h, 50.0), bench_hist_percentile(h, 90.0),
+			bench_hist_percentile(h, 99.0), bench_hist_percentile(h, 99.9),
+			bench_hist_percentile(h, 99.99), h->max );
+}//
+
+/**
+ * Sends on schedule: the i-th message of a producer is due at
+ *  start + (i * producers + index) / rate, late or not
+ */
+void *producer_thread(void *params) {
+
+	bench_worker *self = (bench_worker *) params;
+	unsigned long long interval = 1000000000ULL * producers_count / rate;
+	unsigned long long intended = start_ns + self->index * (1000000000ULL / rate);
+	unsigned long long now;
+	struct timespec pause;
+	bench_message *msg;
+	litm_code code;
+	int bus = 0;
+
+	while (!stop_producers) {
+
+		now = bench_now_ns();
+		if (now < intended) {
+			// sleep most of the way, spin the rest
+			if (intended - now > 100000ULL) {
+				pause.tv_sec  = 0;
+				pause.tv_nsec = (long) (intended - now - 50000ULL);
+				nanosleep( &pause, NULL );
+			}
+			continue;
+		}
+
+		if (now - intended > interval)
+			late++;
+
+		msg = (bench_message *) litm_msg_alloc( self->conn, sizeof(bench_message) );
+		msg->intended_ns = intended;
+		msg->bus = 1 + bus;
+
+		__sync_fetch_and_add( &in_flight, 1 );
+
+		do {
+			code = litm_send( self->conn, msg->bus, msg, &bench_cleaner, TYPE_BENCH );
+		} while (LITM_CODE_BUSY==code);
+
+		if (LITM_CODE_OK!=code) {
+			__sync_fetch_and_sub( &in_flight, 1 );
+			litm_msg_free( msg );
+		}
+
+		self->count++;
+		intended += interval;
+		bus = (bus + 1) % busses;
+	}
+
+	return NULL;
+}//
+
+void *subscriber_thread(void *params) {
+
+	bench_worker *self = (bench_worker *) params;
+	bench_message *msg;
+	litm_envelope *e;
+	int type;
+
+	while (!stop_subscribers) {
+
+		if (LITM_CODE_OK != litm_receive_wait_timer( self->conn, &e, 10*1000 ))
+			continue;
+
+		msg = (bench_message *) litm_get_message( e, &type );
+		if (msg->intended_ns >= record_from_ns)
+			bench_hist_record( self->latency, bench_now_ns() - msg->intended_ns );
+
+		bench_spin_ns( cost_ns );
+		self->count++;
+
+		litm_release( self->conn, e );
+	}
+
+	return NULL;
+}//
+
+/**
+ * Finalization normally happens on the switch thread:
+ *  the lock is there for the odd one out
+ */
+void bench_cleaner(void *msg) {
+
+	bench_message *m = (bench_message *) msg;
+	unsigned long long now = bench_now_ns();
+
+	if (m->intended_ns >= record_from_ns) {
+		while (__sync_lock_test_and_set( &finalize_lock, 1 ))
+			;
+		bench_hist_record( finalized[m->bus], now - m->intended_ns );
+		__sync_lock_release( &finalize_lock );
+	}
+
+	__sync_fetch_and_sub( &in_flight, 1 );
+	litm_msg_free( msg );
+}
@@ -0,0 +1,281 @@
+/*
+ * bench_pingpong.c
+ *
+ *  Created on: 2026-10-19
+ *      Author: Jean-Lou Dupont
+ *
+ *
+ *  Ping-pong round-trip latency benchmark
+ *
+ *  One ``ping`` thread sends on bus 1 and waits for the reply on
+ *  bus 2; the ``pong`` thread receives, releases and replies.  A
+ *  single message is ever in flight thus the measure is the
+ *  minimum latency of an exchange.
+ *
+ *  The round trip is broken into components through the envelope
+ *  timestamps of the library (@see litm_set_timestamps), for each
+ *  leg:
+ *
+ *  - send:   the litm_send call (ping leg: timed by the benchmark)
+ *  - switch: sent -> dispatched, i.e. switch queue & wake-up
+ *  - route:  dispatched -> delivered, i.e. subscriber lookup
+ *  - wakeup: delivered -> received, i.e. input queue & receiver wake-up
+ *
+ *  and ``turnaround``: ping received -> pong sent (litm_release
+ *  included), ``release``: the ping thread's litm_release call.
+ *
+ *  Usage:
+ *    bench_pingpong [-n 100000] [-w 10000] [-m wait|timer|spin]
+ *                   [-a cpu] [-b cpu] [-x cpu] [-T] [-H]
+ *
+ *      -a / -b / -x: pin the ping / pong / switch threads
+ *      -m: litm_receive_wait, litm_receive_wait_timer or litm_receive_nb polling
+ *      -T: no timestamps, to measure their own cost on the round trip
+ *
+ *  Output: one line per component (CSV), followed with -H by the
+ *  full percentile distributions.
+ *
+ */
+
+#include <litm.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bench_util.h"
+
+#define TYPE_PING LITM_MESSAGE_TYPE_USER_START
+#define TYPE_PONG LITM_MESSAGE_TYPE_USER_START+1
+
+#define BUS_PING 1
+#define BUS_PONG 2
+
+enum {
+	C_RTT = 0,
+	C_PING_SEND,
+	C_PING_SWITCH,
+	C_PING_ROUTE,
+	C_PING_WAKEUP,
+	C_TURNAROUND,
+	C_PONG_SWITCH,
+	C_PONG_ROUTE,
+	C_PONG_WAKEUP,
+	C_RELEASE,
+	C_COUNT
+};
+
+const char *component_names[C_COUNT] = {
+	"rtt", "ping.send", "ping.switch", "ping.route", "ping.wakeup",
+	"turnaround", "pong.switch", "pong.route", "pong.wakeup", "release"
+};
+
+typedef enum {
+	MODE_WAIT = 0,
+	MODE_TIMER,
+	MODE_SPIN
+} receive_mode;
+
+// the pong carries the ping's timestamps back
+typedef struct {
+	litm_timestamps ping;
+} bench_pong;
+
+bench_hist *components[C_COUNT];
+
+litm_connection *ping_conn, *pong_conn;
+receive_mode mode = MODE_WAIT;
+int iterations = 100000, warmup = 10000, stamps = 1;
+int cpu_ping = -1, cpu_pong = -1;
+
+bench_pong pong_message;
+int ping_message;
+
+void *connect_thread(void *params);
+void *pong_thread(void *params);
+litm_code bench_receive(litm_connection *conn, litm_envelope **e);
+void bench_cleaner(void *msg);
+void print_summary(const char *name, bench_hist *h);
+
+
+int main(int argc, char **argv) {
+
+	litm_timestamps pong;
+	litm_envelope *e;
+	litm_code code;
+	pthread_t thread;
+	unsigned long long t0, t1, t2, t3;
+	int opt, i, type, full = 0, cpu_switch = -1;
+	bench_pong *reply;
+
+	while (-1 != (opt = getopt(argc, argv, "n:w:m:a:b:x:TH"))) {
+		switch (opt) {
+		case 'n': iterations = atoi( optarg ); break;
+		case 'w': warmup     = atoi( optarg ); break;
+		case 'm':
+			if      (0==strcmp(optarg, "wait"))  mode = MODE_WAIT;
+			else if (0==strcmp(optarg, "timer")) mode = MODE_TIMER;
+			else if (0==strcmp(optarg, "spin"))  mode = MODE_SPIN;
+			else goto usage;
+			break;
+		case 'a': cpu_ping   = atoi( optarg ); break;
+		case 'b': cpu_pong   = atoi( optarg ); break;
+		case 'x': cpu_switch = atoi( optarg ); break;
+		case 'T': stamps = 0; break;
+		case 'H': full = 1; break;
+		default:
+			goto usage;
+		}
+	}
+
+	for (i=0; i<C_COUNT; i++)
+		components[i] = bench_hist_create();
+
+	litm_set_timestamps( stamps );
+
+	// the switch thread is started by the first connection
+	//  and inherits the affinity of the connecting thread
+	pthread_create( &thread, NULL, &connect_thread, &cpu_switch );
+	pthread_join( thread, NULL );
+
+	litm_connect_ex( &pong_conn, 2 );
+	litm_subscribe( pong_conn, BUS_PING );
+	litm_subscribe( ping_conn, BUS_PONG );
+
+	bench_pin_thread( cpu_ping );
+
+	pthread_create( &thread, NULL, &pong_thread, NULL );
+
+	for (i=0; i<warmup + iterations; i++) {
+
+		t0 = bench_now_ns();
+		do {
+			code = litm_send( ping_conn, BUS_PING, &ping_message, &bench_cleaner, TYPE_PING );
+		} while (LITM_CODE_BUSY==code);
+		t1 = bench_now_ns();
+
+		if (LITM_CODE_OK != bench_receive( ping_conn, &e )) {
+			fprintf( stderr, "ping: receive failed\n" );
+			return 1;
+		}
+		t2 = bench_now_ns();
+
+		reply = (bench_pong *) litm_get_message( e, &type );
+		code  = litm_get_timestamps( e, &pong );
+		litm_release( ping_conn, e );
+		t3 = bench_now_ns();
+
+		if (i < warmup)
+			continue;
+
+		bench_hist_record( components[C_RTT],       t2 - t0 );
+		bench_hist_record( components[C_PING_SEND], t1 - t0 );
+		bench_hist_record( components[C_RELEASE],   t3 - t2 );
+
+		if (LITM_CODE_OK != code)
+			continue;
+
+		bench_hist_record( components[C_PING_SWITCH], reply->ping.dispatched - reply->ping.sent );
+		bench_hist_record( components[C_PING_ROUTE],  reply->ping.delivered  - reply->ping.dispatched );
+		bench_hist_record( components[C_PING_WAKEUP], reply->ping.received   - reply->ping.delivered );
+		bench_hist_record( components[C_TURNAROUND],  pong.sent              - reply->ping.received );
+		bench_hist_record( components[C_PONG_SWITCH], pong.dispatched        - pong.sent );
+		bench_hist_record( components[C_PONG_ROUTE],  pong.delivered         - pong.dispatched );
+		bench_hist_record( components[C_PONG_WAKEUP], pong.received          - pong.delivered );
+	}
+
+	pthread_join( thread, NULL );
+
+	printf("# iterations[%i] warmup[%i] mode[%s] timestamps[%i] cpu: ping[%i] pong[%i] switch[%i]\n",
+			iterations, warmup, (MODE_WAIT==mode) ? "wait" : (MODE_TIMER==mode) ? "timer" : "spin",
+			stamps, cpu_ping, cpu_pong, cpu_switch);
+	printf("component,count,min_ns,p50_ns,p99_ns,p999_ns,max_ns,mean_ns\n");
+
+	for (i=0; i<C_COUNT; i++)
+		print_summary( component_names[i], components[i] );
+
+	if (full)
+		for (i=0; i<C_COUNT; i++)
+			bench_hist_print( stdout, component_names[i], components[i] );
+
+	return 0;
+
+usage:
+	fprintf( stderr, "usage: %s [-n iterations] [-w warmup] [-m wait|timer|spin] [-a cpu] [-b cpu] [-x cpu] [-T] [-H]\n", argv[0] );
+	return 1;
+}
+
+void *connect_thread(void *params) {
+
+	bench_pin_thread( *(int *) params );
+	litm_connect_ex( &ping_conn, 1 );
+
+	return NULL;
+}//
+
+void *pong_thread(void *params) {
+
+	litm_envelope *e;
+	litm_code code;
+	int i;
+
+	bench_pin_thread( cpu_pong );
+
+	for (i=0; i<warmup + iterations; i++) {
+
+		if (LITM_CODE_OK != bench_receive( pong_conn, &e )) {
+			fprintf( stderr, "pong: receive failed\n" );
+			break;
+		}
+
+		// the envelope goes back to the switch on release
+		if (LITM_CODE_OK != litm_get_timestamps( e, &pong_message.ping ))
+			memset( &pong_message.ping, 0, sizeof(litm_timestamps) );
+		litm_release( pong_conn, e );
+
+		do {
+			code = litm_send( pong_conn, BUS_PONG, &pong_message, &bench_cleaner, TYPE_PONG );
+		} while (LITM_CODE_BUSY==code);
+	}
+
+	return NULL;
+}//
+
+litm_code bench_receive(litm_connection *conn, litm_envelope **e) {
+
+	litm_code code;
+
+	switch (mode) {
+	case MODE_WAIT:
+		return litm_receive_wait( conn, e );
+
+	case MODE_TIMER:
+		do {
+			code = litm_receive_wait_timer( conn, e, 1000 );
+		} while (LITM_CODE_NO_MESSAGE==code);
+		return code;
+
+	case MODE_SPIN:
+	default:
+		// yielding: the switch might share the CPU
+		while (LITM_CODE_NO_MESSAGE == (code = litm_receive_nb( conn, e )))
+			sched_yield();
+		return code;
+	}
+}//
+
+// the messages are static
+void bench_cleaner(void *msg) {
+}//
+
+void print_summary(const char *name, bench_hist *h) {
+
+	printf("%s,%llu,%llu,%llu,%llu,%llu,%llu,%.1f\n", name, h->total,
+			(0==h->total) ? 0 : h->min,
+			bench_hist_percentile( h, 50.0 ),
+			bench_hist_percentile( h, 99.0 ),
+			bench_hist_percentile( h, 99.9 ),
+			h->max, bench_hist_mean( h ));
+}//
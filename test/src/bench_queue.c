@@ -0,0 +1,285 @@
+/*
+ * bench_queue.c
+ *
+ *  Created on: 2026-10-19
+ *      Author: Jean-Lou Dupont
+ *
+ *
+ *  Queue primitives micro-benchmark
+ *
+ *  For each queue backend (list, mpsc, spsc, mpmc):
+ *
+ *  - uncontended: ns/op of each entry point, single thread,
+ *    in batches that fit the bounded backends
+ *
+ *  - contended: SPSC, MPSC and MPMC patterns (as supported by the
+ *    backend) with 1..N producers / consumers; producers use
+ *    queue_put_nb, consumers either spin on queue_get_nb or block
+ *    with queue_wait_timer when the queue looks empty.  Reported:
+ *    ns per transferred node, ``busy`` returns of queue_put_nb and
+ *    ``spurious`` NULL returns of queue_get_nb whilst nodes were
+ *    known to be queued
+ *
+ *  The untimed queue_wait of the list backend always blocks: it is
+ *  exercised through the blocking consumers (same backend operation).
+ *
+ *  Usage:
+ *    bench_queue [-n 1000000] [-t 1,2,4] [-B list,mpsc,spsc,mpmc]
+ *
+ *  Output: CSV on stdout
+ *
+ */
+
+#include <litm.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "queue.h"
+#include "bench_util.h"
+
+#define BATCH 128
+
+typedef struct {
+	const char *name;
+	litm_queue_backend backend;
+	int multi_producer;
+	int multi_consumer;
+} bench_backend;
+
+bench_backend backends[] = {
+	{ "list", LITM_QUEUE_BACKEND_LIST, 1, 1 },
+	{ "mpsc", LITM_QUEUE_BACKEND_MPSC, 1, 0 },
+	{ "spsc", LITM_QUEUE_BACKEND_SPSC, 0, 0 },
+	{ "mpmc", LITM_QUEUE_BACKEND_MPMC, 1, 1 },
+};
+#define BACKENDS ((int) (sizeof(backends) / sizeof(bench_backend)))
+
+typedef struct {
+	queue *q;
+	long items;
+	int blocking;
+	pthread_t thread;
+	long busy;
+	long spurious;
+	long waits;
+} bench_worker;
+
+volatile long produced = 0, consumed = 0, total = 0;
+volatile int go = 0;
+
+void  uncontended(bench_backend *b, long n);
+void  contended(bench_backend *b, int producers, int consumers, int blocking, long n);
+void *producer_thread(void *params);
+void *consumer_thread(void *params);
+void  report(const char *backend, const char *pattern, int producers, int consumers,
+				const char *op, long ops, unsigned long long ns, long busy, long spurious);
+
+
+int main(int argc, char **argv) {
+
+	int threads[BENCH_LIST_MAX] = {1, 2, 4}, threads_count = 3;
+	char *selected = NULL;
+	long n = 1000000;
+	int opt, i, t;
+
+	while (-1 != (opt = getopt(argc, argv, "n:t:B:"))) {
+		switch (opt) {
+		case 'n': n = atol( optarg ); break;
+		case 't': threads_count = bench_parse_list( optarg, threads, BENCH_LIST_MAX ); break;
+		case 'B': selected = optarg; break;
+		default:
+			fprintf( stderr, "usage: %s [-n ops] [-t list] [-B backends]\n", argv[0] );
+			return 1;
+		}
+	}
+
+	printf("backend,pattern,producers,consumers,op,ops,ns_per_op,busy,spurious\n");
+
+	for (i=0; i<BACKENDS; i++) {
+
+		if ((NULL!=selected) && (NULL==strstr(selected, backends[i].name)))
+			continue;
+
+		uncontended( &backends[i], n );
+
+		contended( &backends[i], 1, 1, 0, n );
+		contended( &backends[i], 1, 1, 1, n );
+
+		for (t=0; t<threads_count; t++) {
+			if (1 >= threads[t])
+				continue;
+			if (backends[i].multi_producer)
+				contended( &backends[i], threads[t], 1, 0, n );
+			if (backends[i].multi_producer && backends[i].multi_consumer)
+				contended( &backends[i], threads[t], threads[t], 0, n );
+		}
+	}
+
+	return 0;
+}
+
+void report(const char *backend, const char *pattern, int producers, int consumers,
+				const char *op, long ops, unsigned long long ns, long busy, long spurious) {
+
+	printf("%s,%s,%i,%i,%s,%li,%.1f,%li,%li\n", backend, pattern, producers, consumers,
+			op, ops, (double) ns / ops, busy, spurious);
+	fflush( stdout );
+}//
+
+/**
+ * Times ``n`` calls of an entry point: the queue is filled and
+ *  drained by batches so that the bounded backends never block
+ */
+#define TIME_OPS(NAME, FILL, DRAIN, OP) 									\
+	do {																	\
+		long done = 0, busy = 0;											\
+		unsigned long long elapsed = 0, t0;									\
+		int k;																\
+		while (done < n) {													\
+			for (k=0; k<(FILL); k++) queue_put_nb( q, (void *) 1L );		\
+			t0 = bench_now_ns();											\
+			for (k=0; k<BATCH; k++) { if (OP) busy++; }						\
+			elapsed += bench_now_ns() - t0;									\
+			for (k=0; k<(DRAIN); k++) queue_get_nb( q );					\
+			done += BATCH;													\
+		}																	\
+		report( b->name, "uncontended", 1, 1, NAME, done, elapsed, busy, 0 );	\
+	} while (0)
+
+void uncontended(bench_backend *b, long n) {
+
+	queue *q = queue_create_ex( 0, b->backend, LITM_QUEUE_RING_SIZE );
+	if (NULL==q) {
+		fprintf( stderr, "# %s: queue_create_ex failed\n", b->name );
+		return;
+	}
+
+	// puts: start empty, drain afterwards
+	TIME_OPS( "queue_put",           0, BATCH, 1 != queue_put( q, (void *) 1L ) );
+	TIME_OPS( "queue_put_nb",        0, BATCH, 1 != queue_put_nb( q, (void *) 1L ) );
+	TIME_OPS( "queue_put_wait",      0, BATCH, 1 != queue_put_wait( q, (void *) 1L ) );
+	TIME_OPS( "queue_put_prio",      0, BATCH, 1 != queue_put_prio( q, (void *) 1L, LITM_PRIORITY_HIGH ) );
+	TIME_OPS( "queue_put_head",      0, BATCH, 1 != queue_put_head( q, (void *) 1L ) );
+	TIME_OPS( "queue_put_head_nb",   0, BATCH, 1 != queue_put_head_nb( q, (void *) 1L ) );
+	TIME_OPS( "queue_put_head_wait", 0, BATCH, 1 != queue_put_head_wait( q, (void *) 1L ) );
+
+	// gets: start full
+	TIME_OPS( "queue_get",           BATCH, 0, NULL == queue_get( q ) );
+	TIME_OPS( "queue_get_nb",        BATCH, 0, NULL == queue_get_nb( q ) );
+
+	// non-destructive: one node present
+	TIME_OPS( "queue_peek",          1, 1, 1 != queue_peek( q ) );
+	TIME_OPS( "queue_count",         1, 1, 1 != queue_count( q ) );
+	TIME_OPS( "queue_wait_timer(0)", 1, 1, 0 != queue_wait_timer( q, 0 ) );
+	TIME_OPS( "queue_signal",        0, 0, (queue_signal( q ), 0) );
+
+	queue_destroy( q );
+}//
+
+void contended(bench_backend *b, int producers, int consumers, int blocking, long n) {
+
+	bench_worker p[BENCH_LIST_MAX], c[BENCH_LIST_MAX];
+	unsigned long long t0, elapsed;
+	long busy = 0, spurious = 0;
+	char pattern[32];
+	int i;
+
+	queue *q = queue_create_ex( 0, b->backend, LITM_QUEUE_RING_SIZE );
+	if (NULL==q)
+		return;
+
+	produced = 0;
+	consumed = 0;
+	total    = (n / producers) * producers;
+	go       = 0;
+
+	for (i=0; i<producers; i++) {
+		memset( &p[i], 0, sizeof(bench_worker) );
+		p[i].q = q;
+		p[i].items = n / producers;
+		pthread_create( &p[i].thread, NULL, &producer_thread, &p[i] );
+	}
+	for (i=0; i<consumers; i++) {
+		memset( &c[i], 0, sizeof(bench_worker) );
+		c[i].q = q;
+		c[i].blocking = blocking;
+		pthread_create( &c[i].thread, NULL, &consumer_thread, &c[i] );
+	}
+
+	t0 = bench_now_ns();
+	go = 1;
+
+	for (i=0; i<producers; i++) {
+		pthread_join( p[i].thread, NULL );
+		busy += p[i].busy;
+	}
+	for (i=0; i<consumers; i++) {
+		pthread_join( c[i].thread, NULL );
+		spurious += c[i].spurious;
+	}
+
+	elapsed = bench_now_ns() - t0;
+
+	snprintf( pattern, sizeof(pattern), "%s%s",
+			(1==producers && 1==consumers) ? "spsc" : (1==consumers) ? "mpsc" : "mpmc",
+			blocking ? "-blocking" : "" );
+
+	report( b->name, pattern, producers, consumers, "transfer", total, elapsed, busy, spurious );
+
+	queue_destroy( q );
+}//
+
+void *producer_thread(void *params) {
+
+	bench_worker *self = (bench_worker *) params;
+	long i;
+
+	while (!go)
+		sched_yield();
+
+	for (i=0; i<self->items; i++) {
+		while (1 != queue_put_nb( self->q, (void *) 1L )) {
+			self->busy++;
+			sched_yield();
+		}
+		__sync_fetch_and_add( &produced, 1 );
+	}
+
+	// the blocking consumers might all be asleep
+	queue_signal( self->q );
+
+	return NULL;
+}//
+
+void *consumer_thread(void *params) {
+
+	bench_worker *self = (bench_worker *) params;
+
+	while (!go)
+		sched_yield();
+
+	while (consumed < total) {
+
+		if (NULL != queue_get_nb( self->q )) {
+			__sync_fetch_and_add( &consumed, 1 );
+			continue;
+		}
+
+		// NULL although something was put and not taken yet
+		if (produced > consumed)
+			self->spurious++;
+
+		if (self->blocking) {
+			self->waits++;
+			queue_wait_timer( self->q, 1000 );
+		} else {
+			sched_yield();
+		}
+	}
+
+	return NULL;
+}//
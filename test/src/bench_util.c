@@ -0,0 +1,310 @@
+/*
+ * bench_util.c
+ *
+ *  Created on: 2026-10-19
+ *      Author: Jean-Lou Dupont
+ *
+ *
+ *  @see bench_util.h
+ *
+ */
+
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+
+#include <litm.h>
+
+#include "bench_util.h"
+
+
+unsigned long long bench_now_ns(void) {
+
+	struct timespec now;
+
+	clock_gettime( CLOCK_MONOTONIC, &now );
+
+	return (unsigned long long) now.tv_sec * 1000000000ULL + now.tv_nsec;
+}//
+
+/**
+ * User + system time of the whole process (all threads)
+ */
+double bench_cpu_seconds(void) {
+
+	struct rusage usage;
+
+	getrusage( RUSAGE_SELF, &usage );
+
+	return    usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6
+			+ usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+}//
+
+/**
+ * Simulates the processing cost of a message
+ */
+void bench_spin_ns(unsigned long long ns) {
+
+	unsigned long long end;
+
+	if (0==ns)
+		return;
+
+	end = bench_now_ns() + ns;
+	while (bench_now_ns() < end)
+		;
+}//
+
+
+static int __bench_hist_index(unsigned long long value) {
+
+	int msb;
+
+	if (value < BENCH_HIST_SUB)
+		return (int) value;
+
+	msb = 63 - __builtin_clzll( value );
+
+	return (msb - BENCH_HIST_SUB_BITS + 1) * BENCH_HIST_SUB
+			+ (int) ((value >> (msb - BENCH_HIST_SUB_BITS)) & (BENCH_HIST_SUB - 1));
+}//
+
+/**
+ * @return the highest value recorded in bucket ``index``
+ */
+static unsigned long long __bench_hist_value(int index) {
+
+	int shift;
+
+	if (index < BENCH_HIST_SUB)
+		return (unsigned long long) index;
+
+	shift = index / BENCH_HIST_SUB - 1;
+
+	return ((unsigned long long) (BENCH_HIST_SUB + index % BENCH_HIST_SUB + 1) << shift) - 1;
+}//
+
+bench_hist *bench_hist_create(void) {
+
+	bench_hist *h = (bench_hist *) malloc( sizeof(bench_hist) );
+	if (NULL!=h)
+		bench_hist_reset( h );
+
+	return h;
+}//
+
+void bench_hist_reset(bench_hist *h) {
+
+	memset( h, 0, sizeof(bench_hist) );
+	h->min = ~0ULL;
+}//
+
+void bench_hist_record(bench_hist *h, unsigned long long value) {
+
+	h->counts[ __bench_hist_index(value) ]++;
+	h->total++;
+	h->sum += (double) value;
+
+	if (value < h->min)
+		h->min = value;
+	if (value > h->max)
+		h->max = value;
+}//
+
+void bench_hist_merge(bench_hist *dst, const bench_hist *src) {
+
+	int i;
+
+	for (i=0; i<BENCH_HIST_BUCKETS; i++)
+		dst->counts[i] += src->counts[i];
+
+	dst->total += src->total;
+	dst->sum   += src->sum;
+
+	if (src->min < dst->min)
+		dst->min = src->min;
+	if (src->max > dst->max)
+		dst->max = src->max;
+}//
+
+/**
+ * @param percentile in [0, 100]
+ *
+ * @return 0 for an empty histogram
+ */
+unsigned long long bench_hist_percentile(const bench_hist *h, double percentile) {
+
+	unsigned long long rank, seen = 0;
+	int i;
+
+	if (0==h->total)
+		return 0;
+
+	rank = (unsigned long long) (percentile / 100.0 * h->total + 0.5);
+	if (rank < 1)
+		rank = 1;
+	if (rank > h->total)
+		rank = h->total;
+
+	for (i=0; i<BENCH_HIST_BUCKETS; i++) {
+		seen += h->counts[i];
+		if (seen >= rank) {
+			unsigned long long value = __bench_hist_value( i );
+			return (value > h->max) ? h->max : value;
+		}
+	}
+
+	return h->max;
+}//
+
+double bench_hist_mean(const bench_hist *h) {
+
+	return (0==h->total) ? 0.0 : h->sum / h->total;
+}//
+
+/**
+ * Prints the percentile distribution, HdrHistogram style
+ *  (value, percentile, total count)
+ */
+void bench_hist_print(FILE *out, const char *name, const bench_hist *h) {
+
+	unsigned long long seen = 0;
+	int i;
+
+	fprintf( out, "# histogram %s: count[%llu] min[%llu] mean[%.1f] max[%llu]\n",
+				name, h->total, (0==h->total) ? 0 : h->min, bench_hist_mean(h), h->max );
+	fprintf( out, "%12s %14s %12s\n", "Value(ns)", "Percentile", "TotalCount" );
+
+	for (i=0; i<BENCH_HIST_BUCKETS; i++) {
+		if (0==h->counts[i])
+			continue;
+		seen += h->counts[i];
+		fprintf( out, "%12llu %14.6f %12llu\n", __bench_hist_value(i), (double) seen / h->total, seen );
+	}
+}//
+
+/**
+ * Parses a comma-separated list of integers e.g. ``1,2,4``
+ *
+ * @return the number of values parsed
+ */
+int bench_parse_list(const char *arg, int *values, int max) {
+
+	char *copy = strdup( arg ), *token, *saveptr = NULL;
+	int count = 0;
+
+	for (token = strtok_r(copy, ",", &saveptr); (NULL!=token) && (count<max); token = strtok_r(NULL, ",", &saveptr))
+		values[count++] = atoi( token );
+
+	free( copy );
+
+	return count;
+}//
+
+/**
+ * Pins the calling thread to ``cpu``; negative: no pinning
+ *
+ * @return 0 on success
+ */
+int bench_pin_thread(int cpu) {
+
+	cpu_set_t set;
+
+	if (0>cpu)
+		return 0;
+
+	CPU_ZERO( &set );
+	CPU_SET( cpu, &set );
+
+	return pthread_setaffinity_np( pthread_self(), sizeof(set), &set );
+}//
+
+/**
+ * Approximate percentile of a log2 lock histogram:
+ *  the upper bound of the bucket holding it, at most ``max``
+ */
+static unsigned long long __bench_lock_percentile(const long *hist, unsigned long long max, double percentile) {
+
+	unsigned long long bound;
+
+	long total = 0, seen = 0, rank;
+	int i;
+
+	for (i=0; i<LITM_LOCK_HIST_BUCKETS; i++)
+		total += hist[i];
+	if (0==total)
+		return 0;
+
+	rank = (long) (total * percentile / 100.0);
+	for (i=0; i<LITM_LOCK_HIST_BUCKETS; i++) {
+		seen += hist[i];
+		if (seen > rank)
+			break;
+	}
+
+	bound = (2ULL << i) - 1;
+
+	return (bound < max) ? bound : max;
+}//
+
+/**
+ * Prints the library's lock statistics (CSV)
+ *
+ * @return 0 if the library isn't a LITM_LOCK_PROFILE build
+ */
+int bench_print_lock_stats(FILE *out) {
+
+	litm_lock_stats stats;
+	litm_lock_counters *c;
+	int lock;
+
+	if (LITM_CODE_OK != litm_get_lock_stats( &stats ))
+		return 0;
+
+	fprintf( out, "lock,name,acquisitions,contended,trylock_failures,wait_mean_ns,wait_p99_ns,wait_max_ns,hold_mean_ns,hold_p99_ns,hold_max_ns\n" );
+
+	for (lock=0; lock<LITM_LOCKS; lock++) {
+		c = &stats.locks[lock];
+		fprintf( out, "lock,%s,%li,%li,%li,%.1f,%llu,%llu,%.1f,%llu,%llu\n", litm_translate_lock( lock ),
+				c->acquisitions, c->contended, c->trylock_failures,
+				(0==c->contended) ? 0.0 : (double) c->wait_ns / c->contended,
+				__bench_lock_percentile( c->wait_hist, c->max_wait_ns, 99.0 ), c->max_wait_ns,
+				(0==c->acquisitions) ? 0.0 : (double) c->hold_ns / c->acquisitions,
+				__bench_lock_percentile( c->hold_hist, c->max_hold_ns, 99.0 ), c->max_hold_ns );
+	}
+
+	return 1;
+}//
+
+/**
+ * Prints the library's traffic matrix (CSV), by
+ *  decreasing switch time
+ */
+void bench_print_traffic(FILE *out) {
+
+	litm_traffic_matrix *matrix = (litm_traffic_matrix *) malloc( sizeof(litm_traffic_matrix) );
+	litm_traffic_entry *e;
+	int i;
+
+	if (NULL==matrix)
+		return;
+
+	litm_get_traffic( matrix );
+
+	fprintf( out, "traffic,sender,bus,type,messages,bytes,dispatches,switch_ns,switch_ns_per_dispatch\n" );
+
+	for (i=0; i<matrix->count; i++) {
+		e = &matrix->entries[i];
+		fprintf( out, "traffic,%i,%i,%i,%li,%li,%li,%llu,%.1f\n", e->sender, e->bus_id, e->type,
+				e->messages, e->bytes, e->dispatches, e->switch_ns,
+				(0==e->dispatches) ? 0.0 : (double) e->switch_ns / e->dispatches );
+	}
+
+	fprintf( out, "traffic,sampling[%i],dropped[%li]\n", matrix->sampling, matrix->dropped );
+
+	free( matrix );
+}//
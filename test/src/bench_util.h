@@ -0,0 +1,62 @@
+/*
+ * bench_util.h
+ *
+ *  Created on: 2026-10-19
+ *      Author: Jean-Lou Dupont
+ *
+ *
+ *  Helpers shared by the benchmark programs:
+ *
+ *  - monotonic time & CPU time
+ *  - HDR-style latency histograms (log-linear buckets)
+ *  - comma-separated option lists
+ *  - lock contention statistics (LITM_LOCK_PROFILE builds)
+ *
+ */
+
+#ifndef BENCH_UTIL_H_
+#define BENCH_UTIL_H_
+
+#include <stdio.h>
+
+#define BENCH_HIST_SUB_BITS  5                          // 32 sub-buckets: ~3% precision
+#define BENCH_HIST_SUB       (1 << BENCH_HIST_SUB_BITS)
+#define BENCH_HIST_BUCKETS   ((64 - BENCH_HIST_SUB_BITS + 1) * BENCH_HIST_SUB)
+
+#define BENCH_LIST_MAX       16
+
+
+	/**
+	 * Latency histogram
+	 *
+	 * Values (ns) below BENCH_HIST_SUB are exact, the others are
+	 *  recorded with BENCH_HIST_SUB_BITS bits of precision.
+	 */
+	typedef struct {
+		unsigned long long counts[BENCH_HIST_BUCKETS];
+		unsigned long long total;
+		unsigned long long min;
+		unsigned long long max;
+		double sum;
+	} bench_hist;
+
+
+	unsigned long long bench_now_ns(void);
+	double             bench_cpu_seconds(void);
+	void               bench_spin_ns(unsigned long long ns);
+
+	bench_hist        *bench_hist_create(void);
+	void               bench_hist_reset(bench_hist *h);
+	void               bench_hist_record(bench_hist *h, unsigned long long value);
+	void               bench_hist_merge(bench_hist *dst, const bench_hist *src);
+	unsigned long long bench_hist_percentile(const bench_hist *h, double percentile);
+	double             bench_hist_mean(const bench_hist *h);
+	void               bench_hist_print(FILE *out, const char *name, const bench_hist *h);
+
+	int                bench_parse_list(const char *arg, int *values, int max);
+	int                bench_pin_thread(int cpu);
+
+	int                bench_print_lock_stats(FILE *out);
+	void               bench_print_traffic(FILE *out);
+
+#endif /* BENCH_UTIL_H_ */
@@ -0,0 +1,214 @@
+/*
+ * flight_decode.c
+ *
+ *  Created on: 2026-10-19
+ *      Author: Jean-Lou Dupont
+ *
+ *
+ *  Flight recorder decoder
+ *
+ *  Reads a dump written by litm_flight_dump (or on a fatal signal,
+ *  @see litm_flight_dump_on_signal) and rebuilds the timeline of each
+ *  message from the events of all the threads: times are relative to
+ *  the message's first event.
+ *
+ *  The rings fill at their own pace: the events older than the oldest
+ *  one of the busiest full ring are dropped, the others being complete
+ *  only from then on.  A timeline not starting with ``send`` thus lost
+ *  its beginning; one not ending with ``finalize`` was still in flight
+ *  at the time of the dump.
+ *
+ *  Usage:
+ *    flight_decode [-e envelope] [-s slow_ns] [-i] dump_file
+ *
+ *      -e: only this envelope
+ *      -s: only the messages which took at least ``slow_ns``
+ *      -i: only the messages in flight
+ *
+ */
+
+#include <litm.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+
+int connection_ids[LITM_CONNECTION_MAX+1];
+int connection_known[LITM_CONNECTION_MAX+1];
+
+litm_flight_event *events = NULL;
+long events_count = 0;
+unsigned long long horizon = 0;
+
+int   load(const char *path);
+int   compare_events(const void *a, const void *b);
+void  print_timeline(litm_flight_event *first, long count);
+
+
+int main(int argc, char **argv) {
+
+	long envelope_filter = -1, index, start;
+	unsigned long long slow_ns = 0;
+	int incomplete_only = 0, opt;
+	long messages = 0, shown = 0, in_flight = 0, truncated = 0;
+
+	while (-1 != (opt = getopt(argc, argv, "e:s:i"))) {
+		switch (opt) {
+		case 'e': envelope_filter = atol(optarg); break;
+		case 's': slow_ns = strtoull(optarg, NULL, 10); break;
+		case 'i': incomplete_only = 1; break;
+		default:
+			fprintf(stderr, "usage: flight_decode [-e envelope] [-s slow_ns] [-i] dump_file\n");
+			return 1;
+		}
+	}
+
+	if (optind >= argc) {
+		fprintf(stderr, "usage: flight_decode [-e envelope] [-s slow_ns] [-i] dump_file\n");
+		return 1;
+	}
+
+	if (!load(argv[optind]))
+		return 1;
+
+	qsort(events, events_count, sizeof(litm_flight_event), &compare_events);
+
+	for (start=0; start<events_count; start=index) {
+
+		litm_flight_event *first = &events[start];
+
+		for (index=start; (index<events_count) && (events[index].envelope == first->envelope); index++);
+
+		litm_flight_event *last = &events[index-1];
+		int complete = (LITM_FLIGHT_FINALIZE == last->code);
+
+		messages++;
+		in_flight += !complete;
+		truncated += (LITM_FLIGHT_SEND != first->code);
+
+		if ((-1 != envelope_filter) && ((unsigned int) envelope_filter != first->envelope))
+			continue;
+		if (incomplete_only && complete)
+			continue;
+		if (slow_ns > last->ts - first->ts)
+			continue;
+
+		shown++;
+		print_timeline(first, index - start);
+	}
+
+	printf("messages[%li] shown[%li] in_flight[%li] truncated[%li] events[%li]\n",
+			messages, shown, in_flight, truncated, events_count);
+
+	free(events);
+
+	return 0;
+}
+
+/**
+ * Loads the connection table and the events of all the rings
+ */
+int load(const char *path) {
+
+	litm_flight_header header;
+	int pair[2], ring;
+	FILE *f = fopen(path, "rb");
+
+	if (NULL==f) {
+		perror(path);
+		return 0;
+	}
+
+	if ((1 != fread(&header, sizeof(header), 1, f)) || (0 != memcmp(header.magic, LITM_FLIGHT_MAGIC, sizeof(header.magic)))) {
+		fprintf(stderr, "%s: not a flight recorder dump\n", path);
+		fclose(f);
+		return 0;
+	}
+
+	while (header.connections-- > 0) {
+		if (1 != fread(pair, sizeof(pair), 1, f))
+			goto truncated;
+		if ((0 <= pair[0]) && (LITM_CONNECTION_MAX >= pair[0])) {
+			connection_ids[pair[0]]   = pair[1];
+			connection_known[pair[0]] = 1;
+		}
+	}
+
+	for (ring=0; ring<header.rings; ring++) {
+		if ((1 != fread(pair, sizeof(pair), 1, f)) || (0 > pair[1]))
+			goto truncated;
+
+		events = realloc(events, (events_count + pair[1]) * sizeof(litm_flight_event));
+		if ((NULL==events) && (0 < events_count + pair[1])) {
+			fprintf(stderr, "out of memory\n");
+			fclose(f);
+			return 0;
+		}
+
+		if ((size_t) pair[1] != fread(&events[events_count], sizeof(litm_flight_event), pair[1], f))
+			goto truncated;
+
+		// a full ring might have lost events
+		if ((LITM_FLIGHT_RING_SIZE == pair[1]) && (events[events_count].ts > horizon))
+			horizon = events[events_count].ts;
+
+		events_count += pair[1];
+	}
+
+	long index, kept = 0;
+	for (index=0; index<events_count; index++)
+		if (events[index].ts >= horizon)
+			events[kept++] = events[index];
+	events_count = kept;
+
+	fclose(f);
+	return 1;
+
+truncated:
+	fprintf(stderr, "%s: truncated dump\n", path);
+	fclose(f);
+	return 0;
+}
+
+/**
+ * By envelope then time
+ */
+int compare_events(const void *a, const void *b) {
+
+	const litm_flight_event *ea = (const litm_flight_event *) a;
+	const litm_flight_event *eb = (const litm_flight_event *) b;
+
+	if (ea->envelope != eb->envelope)
+		return (ea->envelope < eb->envelope) ? -1 : 1;
+
+	if (ea->ts != eb->ts)
+		return (ea->ts < eb->ts) ? -1 : 1;
+
+	return 0;
+}
+
+void print_timeline(litm_flight_event *first, long count) {
+
+	litm_flight_event *ev;
+	long index;
+
+	printf("envelope[%u] duration[%llu ns]%s%s\n", first->envelope, first[count-1].ts - first->ts,
+			(LITM_FLIGHT_SEND != first->code) ? " truncated" : "",
+			(LITM_FLIGHT_FINALIZE != first[count-1].code) ? " in_flight" : "");
+
+	for (index=0; index<count; index++) {
+		ev = &first[index];
+
+		printf("  +%12llu  %-12s thread[%u]", ev->ts - first->ts,
+				litm_translate_flight_code(ev->code), ev->ring);
+
+		if (0 != ev->conn) {
+			if ((LITM_CONNECTION_MAX >= ev->conn) && connection_known[ev->conn])
+				printf(" conn[%i] id[%i]", ev->conn, connection_ids[ev->conn]);
+			else
+				printf(" conn[%i]", ev->conn);
+		}
+		printf("\n");
+	}
+}
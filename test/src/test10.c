@@ -0,0 +1,223 @@
+/*
+ * test10.c
+ *
+ *  Created on: 2026-10-19
+ *      Author: Jean-Lou Dupont
+ *
+ *
+ *  Watchdog / Release Timeout Test
+ *
+ *  - a subscriber holds the messages of bus 1 and never releases
+ *    them in time: the subscribers after it must get them past the
+ *    release timeout, each exactly once; the late releases must
+ *    finalize each message once (its cleaner runs once)
+ *
+ *  - a subscriber releasing around the timeout races the watchdog:
+ *    whoever wins, each message goes through once and is cleaned once
+ *
+ *  - the same holds on a topic with a release timeout of its own
+ *
+ */
+
+#include <litm.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define HELD       5
+#define RACED      2000
+#define TIMEOUT    50*1000 // 50ms
+
+#define TYPE_TEST  LITM_MESSAGE_TYPE_USER_START
+
+litm_connection *sender, *holder, *follower;
+
+volatile int cleaned = 0, stop = 0;
+int received[RACED];
+
+void counting_cleaner(void *msg);
+void *racer_thread(void *params);
+int  send_messages(litm_connection *conn, litm_bus bus_id, litm_topic topic, int count);
+int  follow(int count, int usecs);
+
+
+int main(int argc, char **argv) {
+	printf("#main: BEGIN\n");
+
+	litm_envelope *held[HELD], *e;
+	litm_watchdog_stats stats;
+	litm_topic topic;
+	pthread_t racer;
+	int i, count, errors, failures = 0;
+
+	litm_connect_ex( &sender,   1 );
+	litm_connect_ex( &holder,   2 );
+	litm_connect_ex( &follower, 3 );
+
+	// turn-wise: the holder comes first
+	litm_subscribe( holder,   1 );
+	litm_subscribe( follower, 1 );
+
+	litm_bus_set_release_timeout( 1, TIMEOUT );
+
+	// ---- a holder which never releases in time
+	send_messages( sender, 1, -1, HELD );
+
+	for (count=0; count<HELD; )
+		if (LITM_CODE_OK==litm_receive_wait_timer( holder, &held[count], 100*1000 ))
+			count++;
+
+	errors = follow( HELD, 2*1000*1000 );
+	litm_get_watchdog_stats( &stats );
+
+	printf("held: followed[%i] %s\n", HELD - errors, (0==errors) ? "OK":"FAILED");
+	printf("held: reclaimed[%li] %s\n", stats.reclaimed, (HELD==stats.reclaimed) ? "OK":"FAILED");
+	printf("held: cleaned before release[%i] %s\n", cleaned, (0==cleaned) ? "OK":"FAILED");
+	failures += (0!=errors) + (HELD!=stats.reclaimed) + (0!=cleaned);
+
+	for (i=0; i<HELD; i++)
+		litm_release( holder, held[i] );
+	usleep( 50*1000 );
+
+	printf("held: cleaned after release[%i] %s\n", cleaned, (HELD==cleaned) ? "OK":"FAILED");
+	failures += (HELD!=cleaned);
+
+	// ---- releases racing the watchdog
+	cleaned = 0;
+	litm_bus_set_release_timeout( 1, 1000 );
+
+	pthread_create( &racer, NULL, &racer_thread, NULL );
+	send_messages( sender, 1, -1, RACED );
+	errors = follow( RACED, 10*1000*1000 );
+	stop = 1;
+	pthread_join( racer, NULL );
+
+	// the holder's queue might still hold reclaimed ones
+	while (LITM_CODE_OK==litm_receive_wait_timer( holder, &e, 10*1000 ))
+		litm_release( holder, e );
+	usleep( 50*1000 );
+
+	litm_get_watchdog_stats( &stats );
+	printf("raced: followed once[%i] %s\n", RACED - errors, (0==errors) ? "OK":"FAILED");
+	printf("raced: cleaned[%i] reclaimed[%li] %s\n", cleaned, stats.reclaimed - HELD, (RACED==cleaned) ? "OK":"FAILED");
+	failures += (0!=errors) + (RACED!=cleaned);
+
+	litm_bus_set_release_timeout( 1, 0 );
+	litm_unsubscribe( holder,   1 );
+	litm_unsubscribe( follower, 1 );
+
+	// ---- on a topic
+	cleaned = 0;
+	litm_topic_register( "stuck.topic", &topic );
+	litm_subscribe_topic( holder,   "stuck.topic" );
+	litm_subscribe_topic( follower, "stuck.#" );
+
+	printf("topic: invalid %s\n", (LITM_CODE_ERROR_INVALID_TOPIC==litm_topic_set_release_timeout( LITM_TOPICS_MAX, TIMEOUT )) ? "OK":"FAILED");
+	litm_topic_set_release_timeout( topic, TIMEOUT );
+
+	send_messages( sender, 0, topic, 1 );
+	while (LITM_CODE_OK!=litm_receive_wait_timer( holder, &held[0], 100*1000 ));
+
+	errors = follow( 1, 2*1000*1000 );
+	printf("topic: followed %s\n", (0==errors) ? "OK":"FAILED");
+	failures += (0!=errors);
+
+	litm_release( holder, held[0] );
+	usleep( 50*1000 );
+	printf("topic: cleaned[%i] %s\n", cleaned, (1==cleaned) ? "OK":"FAILED");
+	failures += (1!=cleaned);
+
+	printf("%s\n", (0==failures) ? "OK":"FAILED");
+	printf("#main: END\n");
+	return 0;
+}
+
+/**
+ * Sends ``count`` numbered messages on a bus or,
+ *  with a bus 0, on a topic
+ */
+int send_messages(litm_connection *conn, litm_bus bus_id, litm_topic topic, int count) {
+
+	litm_code code;
+	int i, *msg;
+
+	for (i=0; i<count; i++) {
+
+		msg = (int *) malloc( sizeof(int) );
+		*msg = i;
+
+		do {
+			if (0!=bus_id)
+				code = litm_send( conn, bus_id, msg, &counting_cleaner, TYPE_TEST );
+			else
+				code = litm_send_topic( conn, topic, msg, &counting_cleaner, TYPE_TEST );
+			if (LITM_CODE_BUSY==code)
+				usleep( 100 );
+		} while (LITM_CODE_BUSY==code);
+	}
+
+	return 0;
+}//
+
+/**
+ * The follower receives ``count`` messages, each once
+ *
+ * @return the number of messages missed or received twice
+ */
+int follow(int count, int usecs) {
+
+	litm_envelope *e;
+	int i, type, errors = 0, got = 0, *msg;
+	int waited = 0;
+
+	memset( received, 0, sizeof(received) );
+
+	while ((got < count) && (waited < usecs)) {
+
+		if (LITM_CODE_OK!=litm_receive_wait_timer( follower, &e, 10*1000 )) {
+			waited += 10*1000;
+			continue;
+		}
+
+		msg = (int *) litm_get_message( e, &type );
+		if ((0 <= *msg) && (count > *msg))
+			received[*msg]++;
+		got++;
+
+		litm_release( follower, e );
+	}
+
+	for (i=0; i<count; i++)
+		errors += (1!=received[i]);
+
+	return errors;
+}//
+
+/**
+ * Releases after 0 to 2 ms: about half the releases
+ *  come after the release timeout
+ */
+void *racer_thread(void *params) {
+
+	litm_envelope *e;
+	unsigned int seed = 1;
+
+	while (!stop) {
+
+		if (LITM_CODE_OK!=litm_receive_wait_timer( holder, &e, 10*1000 ))
+			continue;
+
+		usleep( rand_r( &seed ) % 2000 );
+		litm_release( holder, e );
+	}
+
+	return NULL;
+}//
+
+void counting_cleaner(void *msg) {
+
+	free( msg );
+	__sync_fetch_and_add( &cleaned, 1 );
+}
@@ -0,0 +1,197 @@
+/*
+ * test11.c
+ *
+ *  Created on: 2026-10-19
+ *      Author: Jean-Lou Dupont
+ *
+ *
+ *  Conflating Bus Test
+ *
+ *  - a subscriber which doesn't keep up with a burst on a few
+ *    keys: at most one value per key is pending for it, the
+ *    newest value follows the first one and the cleaner of
+ *    each superseded value runs exactly once
+ *
+ *  - a slow subscriber receiving during the burst: per key,
+ *    the values come in order and the last one is the newest
+ *
+ */
+
+#include <litm.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define KEYS       8
+#define VALUES     500
+
+#define TYPE_TEST  LITM_MESSAGE_TYPE_USER_START
+
+typedef struct {
+	int key;
+	int value;
+} value_msg;
+
+litm_connection *sender, *slow;
+
+int cleaned[KEYS][VALUES];
+
+void  value_cleaner(void *msg);
+void  send_burst(void);
+void  wait_cleaned(int count);
+int   check_cleaned(void);
+
+
+int main(int argc, char **argv) {
+	printf("#main: BEGIN\n");
+
+	litm_envelope *e, *held[KEYS*2];
+	value_msg *msg;
+	int pending[KEYS], last[KEYS];
+	int i, type, count, errors, failures = 0;
+
+	litm_connect_ex( &sender, 1 );
+	litm_connect_ex( &slow,   2 );
+	litm_subscribe( slow, 1 );
+	litm_bus_set_mode( 1, LITM_BUS_MODE_CONFLATING );
+
+	// ---- not receiving at all during the burst
+	send_burst();
+	usleep( 50*1000 );
+
+	for (i=0; i<KEYS; i++)
+		pending[i] = 0;
+
+	for (count=0; (count<KEYS*2) && (LITM_CODE_OK==litm_receive_nb( slow, &held[count] )); count++) {
+		msg = (value_msg *) litm_get_message( held[count], &type );
+		pending[msg->key]++;
+	}
+
+	for (errors=0, i=0; i<KEYS; i++)
+		errors += (1!=pending[i]);
+	printf("held: one pending per key %s\n", (0==errors) ? "OK":"FAILED");
+	failures += (0!=errors);
+
+	for (i=0; i<count; i++)
+		litm_release( slow, held[i] );
+	usleep( 50*1000 );
+
+	for (i=0; i<KEYS; i++)
+		last[i] = -1;
+
+	for (count=0; LITM_CODE_OK==litm_receive_wait_timer( slow, &e, 10*1000 ); count++) {
+		msg = (value_msg *) litm_get_message( e, &type );
+		last[msg->key] = msg->value;
+		litm_release( slow, e );
+	}
+
+	for (errors=0, i=0; i<KEYS; i++)
+		errors += (VALUES-1!=last[i]);
+	printf("held: newest follows[%i] %s\n", count, ((0==errors) && (KEYS==count)) ? "OK":"FAILED");
+	failures += (0!=errors) || (KEYS!=count);
+
+	wait_cleaned( KEYS*VALUES );
+	errors = check_cleaned();
+	printf("held: cleaned once %s\n", (0==errors) ? "OK":"FAILED");
+	failures += (0!=errors);
+
+	// ---- receiving slowly during the burst
+	for (i=0; i<KEYS; i++)
+		last[i] = -1;
+	errors = 0;
+
+	send_burst();
+
+	while (LITM_CODE_OK==litm_receive_wait_timer( slow, &e, 50*1000 )) {
+		msg = (value_msg *) litm_get_message( e, &type );
+		errors += (msg->value <= last[msg->key]);
+		last[msg->key] = msg->value;
+		litm_release( slow, e );
+		usleep( 1000 );
+	}
+
+	for (i=0; i<KEYS; i++)
+		errors += (VALUES-1!=last[i]);
+	printf("slow: in order, newest last %s\n", (0==errors) ? "OK":"FAILED");
+	failures += (0!=errors);
+
+	wait_cleaned( KEYS*VALUES );
+	errors = check_cleaned();
+	printf("slow: cleaned once %s\n", (0==errors) ? "OK":"FAILED");
+	failures += (0!=errors);
+
+	printf("%s\n", (0==failures) ? "OK":"FAILED");
+	printf("#main: END\n");
+	return 0;
+}
+
+/**
+ * Sends VALUES values on each of KEYS keys, interleaved
+ */
+void send_burst(void) {
+
+	value_msg *msg;
+	litm_code code;
+	int i, j;
+
+	for (i=0; i<KEYS; i++)
+		for (j=0; j<VALUES; j++)
+			cleaned[i][j] = 0;
+
+	for (j=0; j<VALUES; j++)
+		for (i=0; i<KEYS; i++) {
+
+			msg = (value_msg *) malloc( sizeof(value_msg) );
+			msg->key   = i;
+			msg->value = j;
+
+			do {
+				code = litm_send_keyed( sender, 1, i, msg, &value_cleaner, TYPE_TEST );
+				if (LITM_CODE_BUSY==code)
+					usleep( 100 );
+			} while (LITM_CODE_BUSY==code);
+		}
+}//
+
+/**
+ * Waits, up to a second, for ``count`` cleaner runs
+ */
+void wait_cleaned(int count) {
+
+	int i, j, total, tries;
+
+	for (tries=0; tries<100; tries++) {
+
+		for (total=0, i=0; i<KEYS; i++)
+			for (j=0; j<VALUES; j++)
+				total += cleaned[i][j];
+
+		if (count<=total)
+			return;
+
+		usleep( 10*1000 );
+	}
+}//
+
+/**
+ * @return the number of values not cleaned exactly once
+ */
+int check_cleaned(void) {
+
+	int i, j, errors = 0;
+
+	for (i=0; i<KEYS; i++)
+		for (j=0; j<VALUES; j++)
+			errors += (1!=cleaned[i][j]);
+
+	return errors;
+}//
+
+void value_cleaner(void *msg) {
+
+	value_msg *m = (value_msg *) msg;
+
+	__sync_fetch_and_add( &cleaned[m->key][m->value], 1 );
+	free( msg );
+}
@@ -0,0 +1,171 @@
+/*
+ * test12.c
+ *
+ *  Created on: 2026-10-19
+ *      Author: Jean-Lou Dupont
+ *
+ *
+ *  Topics Test
+ *
+ *  - ``*`` matches exactly one level, ``#`` zero or more
+ *
+ *  - a topic registered after a wildcard subscription
+ *    reaches the subscriber
+ *
+ *  - nothing reaches a connection past its unsubscription
+ *
+ *  - a name made only of dots is rejected
+ *
+ */
+
+#include <litm.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TYPE_TEST  LITM_MESSAGE_TYPE_USER_START
+
+/*
+ * The topics and whether ``orders.*.fills`` and
+ *  ``orders.#`` should match them
+ */
+typedef struct {
+	const char *name;
+	int fills;
+	int all;
+	litm_topic topic;
+} topic_case;
+
+topic_case cases[] = {
+	{ "orders",                0, 1, -1 },
+	{ "orders.eu",             0, 1, -1 },
+	{ "orders.eu.fills",       1, 1, -1 },
+	{ "orders.eu.fills.late",  0, 1, -1 },
+	{ "orders.eu.us.fills",    0, 1, -1 },
+	{ "orders.us.quotes",      0, 1, -1 },
+	{ "trades.eu.fills",       0, 0, -1 },
+	{ "ordersx.eu.fills",      0, 0, -1 },
+	// registered after the subscriptions
+	{ "orders.asia.fills",     1, 1, -1 },
+	{ "orders.asia",           0, 1, -1 },
+};
+
+#define CASES      (sizeof(cases)/sizeof(topic_case))
+#define LATE_CASE  8
+
+litm_connection *sender, *fills, *all;
+
+int  send_all(void);
+int  check(litm_connection *conn, const char *name, int expect_fills, int expect_all);
+
+
+int main(int argc, char **argv) {
+	printf("#main: BEGIN\n");
+
+	char dots[LITM_TOPIC_NAME_MAX];
+	litm_topic topic;
+	litm_code codes[3];
+	unsigned int i;
+	int failures = 0;
+
+	litm_connect_ex( &sender, 1 );
+	litm_connect_ex( &fills,  2 );
+	litm_connect_ex( &all,    3 );
+
+	for (i=0; i<LATE_CASE; i++)
+		litm_topic_register( cases[i].name, &cases[i].topic );
+
+	litm_subscribe_topic( fills, "orders.*.fills" );
+	litm_subscribe_topic( all,   "orders.#" );
+
+	for (i=LATE_CASE; i<CASES; i++)
+		litm_topic_register( cases[i].name, &cases[i].topic );
+
+	// ---- subscribed
+	send_all();
+	failures += check( fills, "subscribed: orders.*.fills", 1, 0 );
+	failures += check( all,   "subscribed: orders.#",       0, 1 );
+
+	// ---- one of them unsubscribed
+	litm_unsubscribe_topic( all, "orders.#" );
+
+	send_all();
+	failures += check( fills, "unsubscribed: orders.*.fills", 1, 0 );
+	failures += check( all,   "unsubscribed: orders.#",       0, 0 );
+
+	// ---- both unsubscribed
+	litm_unsubscribe_topic( fills, "orders.*.fills" );
+
+	send_all();
+	failures += check( fills, "both unsubscribed: orders.*.fills", 0, 0 );
+	failures += check( all,   "both unsubscribed: orders.#",       0, 0 );
+
+	// ---- more levels than a name can hold
+	memset( dots, '.', sizeof(dots)-1 );
+	dots[sizeof(dots)-1] = '\0';
+
+	codes[0] = litm_topic_register( dots, &topic );
+	codes[1] = litm_subscribe_topic( fills, dots );
+	codes[2] = litm_unsubscribe_topic( fills, dots );
+
+	for (i=0; i<3; i++)
+		failures += (LITM_CODE_ERROR_INVALID_TOPIC!=codes[i]);
+	printf("dots: invalid %s\n", ((LITM_CODE_ERROR_INVALID_TOPIC==codes[0]) && (LITM_CODE_ERROR_INVALID_TOPIC==codes[1])
+			&& (LITM_CODE_ERROR_INVALID_TOPIC==codes[2])) ? "OK":"FAILED");
+
+	printf("%s\n", (0==failures) ? "OK":"FAILED");
+	printf("#main: END\n");
+	return (0==failures) ? 0 : 1;
+}
+
+/**
+ * Sends, on each topic, the index of its case
+ */
+int send_all(void) {
+
+	unsigned int i;
+	int *msg;
+
+	for (i=0; i<CASES; i++) {
+
+		msg = (int *) malloc( sizeof(int) );
+		*msg = i;
+
+		litm_send_topic( sender, cases[i].topic, msg, NULL, TYPE_TEST );
+	}
+
+	return 0;
+}//
+
+/**
+ * Verifies that ``conn`` got exactly one message per topic
+ *  matched by ``orders.*.fills`` (expect_fills) and/or
+ *  ``orders.#`` (expect_all)
+ *
+ * @return 1 on failure
+ */
+int check(litm_connection *conn, const char *name, int expect_fills, int expect_all) {
+
+	litm_envelope *e;
+	int received[CASES];
+	int i, type, errors = 0, *msg;
+
+	memset( received, 0, sizeof(received) );
+
+	while (LITM_CODE_OK==litm_receive_wait_timer( conn, &e, 50*1000 )) {
+
+		msg = (int *) litm_get_message( e, &type );
+		if ((0 <= *msg) && ((int) CASES > *msg))
+			received[*msg]++;
+
+		litm_release( conn, e );
+	}
+
+	for (i=0; i<(int) CASES; i++)
+		errors += (received[i] != ((expect_fills && cases[i].fills) || (expect_all && cases[i].all)));
+
+	printf("%s %s\n", name, (0==errors) ? "OK":"FAILED");
+
+	return (0!=errors);
+}//
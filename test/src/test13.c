@@ -0,0 +1,181 @@
+/*
+ * test13.c
+ *
+ *  Created on: 2026-10-19
+ *      Author: Jean-Lou Dupont
+ *
+ *
+ *  Replay Cache / Late Joiner Test
+ *
+ *  - a connection subscribes to a bus with a replay cache whilst
+ *    traffic flows: it must get the cached messages then the live
+ *    ones, each once, in order and without gaps
+ *
+ *  - both when it lies after the existing subscriber (the messages
+ *    on their way reach it) and before (the cache covers them)
+ *
+ */
+
+#include <litm.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define MESSAGES   3000
+#define JOIN_AT    1000
+#define DEPTH      16
+
+#define TYPE_TEST  LITM_MESSAGE_TYPE_USER_START
+
+typedef struct {
+	litm_connection *conn;
+	litm_bus bus_id;
+} sender_params;
+
+volatile int sent = 0, stop = 0;
+
+void *sender_thread(void *params);
+void *holder_thread(void *params);
+int  run(const char *name, litm_bus bus_id, int ahead, int base_id);
+
+
+int main(int argc, char **argv) {
+	printf("#main: BEGIN\n");
+
+	int failures = 0;
+
+	failures += run( "after", 1, 0, 10 );
+	failures += run( "before", 2, 1, 20 );
+
+	printf("%s\n", (0==failures) ? "OK":"FAILED");
+	printf("#main: END\n");
+	return 0;
+}
+
+/**
+ * A holder receives the messages of ``bus_id`` from the start;
+ *  the joiner subscribes once JOIN_AT messages are sent.
+ *
+ * With ``ahead``, a placeholder takes the first slot of the bus
+ *  and gives it up right before the joiner subscribes: the
+ *  joiner then comes before the holder.
+ *
+ * @return 1 on failure
+ */
+int run(const char *name, litm_bus bus_id, int ahead, int base_id) {
+
+	litm_connection *sender, *holder, *joiner, *placeholder = NULL;
+	litm_envelope *e;
+	pthread_t ts, th;
+	sender_params params;
+	int type, *msg, got = 0, first = -1, last = -1, errors = 0, joined_at, waited = 0;
+
+	litm_connect_ex( &sender, base_id );
+	litm_connect_ex( &holder, base_id+1 );
+	litm_connect_ex( &joiner, base_id+2 );
+
+	litm_bus_set_replay( bus_id, LITM_REPLAY_LAST_N, DEPTH );
+
+	if (ahead) {
+		litm_connect_ex( &placeholder, base_id+3 );
+		litm_subscribe( placeholder, bus_id );
+	}
+	litm_subscribe( holder, bus_id );
+
+	sent = 0;
+	stop = 0;
+	params.conn   = sender;
+	params.bus_id = bus_id;
+	pthread_create( &th, NULL, &holder_thread, (void *) holder );
+	pthread_create( &ts, NULL, &sender_thread, (void *) &params );
+
+	while (sent < JOIN_AT)
+		usleep( 100 );
+
+	if (ahead)
+		litm_unsubscribe( placeholder, bus_id );
+
+	joined_at = sent;
+	litm_subscribe( joiner, bus_id );
+
+	while ((last < MESSAGES-1) && (waited < 2*1000*1000)) {
+
+		if (LITM_CODE_OK!=litm_receive_wait_timer( joiner, &e, 10*1000 )) {
+			waited += 10*1000;
+			continue;
+		}
+
+		msg = (int *) litm_get_message( e, &type );
+
+		// once each, in order, without gaps
+		if (-1==first)
+			first = *msg;
+		else
+			errors += (last+1 != *msg);
+		last = *msg;
+		got++;
+
+		litm_release( joiner, e );
+	}
+
+	stop = 1;
+	pthread_join( ts, NULL );
+	pthread_join( th, NULL );
+
+	printf("%s: first[%i] joined at[%i] last[%i] got[%i] ", name, first, joined_at, last, got);
+
+	// the cache covers some of the messages sent before joining
+	errors += (-1==first) || (first >= joined_at) || (MESSAGES-1 != last);
+	printf("%s\n", (0==errors) ? "OK":"FAILED");
+
+	return (0!=errors);
+}//
+
+void *sender_thread(void *params) {
+
+	sender_params *p = (sender_params *) params;
+	litm_code code;
+	int i, *msg;
+
+	for (i=0; i<MESSAGES; i++) {
+
+		msg = (int *) malloc( sizeof(int) );
+		*msg = i;
+
+		do {
+			code = litm_send( p->conn, p->bus_id, msg, NULL, TYPE_TEST );
+			if (LITM_CODE_BUSY==code)
+				usleep( 100 );
+		} while (LITM_CODE_BUSY==code);
+
+		sent = i+1;
+
+		// paced: a full input queue would hold a message
+		//  back behind the following ones
+		usleep( 20 );
+	}
+
+	return NULL;
+}//
+
+/**
+ * Holds each message for a while: some of them are
+ *  still on their way when the joiner subscribes
+ */
+void *holder_thread(void *params) {
+
+	litm_connection *holder = (litm_connection *) params;
+	litm_envelope *e;
+
+	while (!stop) {
+
+		if (LITM_CODE_OK!=litm_receive_wait_timer( holder, &e, 10*1000 ))
+			continue;
+
+		usleep( 20 );
+		litm_release( holder, e );
+	}
+
+	return NULL;
+}//
@@ -0,0 +1,180 @@
+/*
+ * test14.c
+ *
+ *  Created on: 2026-10-19
+ *      Author: Jean-Lou Dupont
+ *
+ *
+ *  Message Slabs Test
+ *
+ *  - messages from litm_msg_alloc, sent without a cleaner, reach
+ *    the receiver intact and go back to the sender's slab: the
+ *    next allocations reuse the same blocks
+ *
+ *  - a block freed from another thread is reused
+ *
+ *  - a late joiner primed from a replay cache gets the slab
+ *    messages intact
+ *
+ */
+
+#include <litm.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define MESSAGES   64
+#define DEPTH      8
+#define MSG_SIZE   48
+
+#define TYPE_TEST  LITM_MESSAGE_TYPE_USER_START
+
+litm_connection *sender, *receiver, *joiner;
+
+int  receive_all(litm_connection *conn, int count, int first);
+int  send_all(litm_bus bus_id, void **sent);
+void *free_thread(void *params);
+
+
+int main(int argc, char **argv) {
+	printf("#main: BEGIN\n");
+
+	void *sent[MESSAGES], *msg;
+	pthread_t tf;
+	int i, j, reused, errors, failures = 0;
+
+	litm_connect_ex( &sender,   1 );
+	litm_connect_ex( &receiver, 2 );
+	litm_connect_ex( &joiner,   3 );
+	litm_subscribe( receiver, 1 );
+
+	// ---- sent, received, released
+	errors  = send_all( 1, sent );
+	errors += receive_all( receiver, MESSAGES, 0 );
+	printf("sent: received intact %s\n", (0==errors) ? "OK":"FAILED");
+	failures += (0!=errors);
+
+	// the switch finalizes the released envelopes
+	usleep( 50*1000 );
+
+	// ---- the blocks went back to the slab
+	for (reused=0, i=0; i<MESSAGES; i++) {
+		msg = litm_msg_alloc( sender, MSG_SIZE );
+		for (j=0; j<MESSAGES; j++)
+			reused += (msg==sent[j]);
+		sent[i] = msg;
+	}
+	printf("released: reused[%i] %s\n", reused, (MESSAGES==reused) ? "OK":"FAILED");
+	failures += (MESSAGES!=reused);
+
+	// ---- freed by another thread
+	pthread_create( &tf, NULL, &free_thread, (void *) sent );
+	pthread_join( tf, NULL );
+
+	for (reused=0, i=0; i<MESSAGES; i++) {
+		msg = litm_msg_alloc( sender, MSG_SIZE );
+		for (j=0; j<MESSAGES; j++)
+			reused += (msg==sent[j]);
+		litm_msg_free( msg );
+	}
+	printf("remote free: reused[%i] %s\n", reused, (MESSAGES==reused) ? "OK":"FAILED");
+	failures += (MESSAGES!=reused);
+
+	// ---- primed from a replay cache
+	litm_bus_set_replay( 2, LITM_REPLAY_LAST_N, DEPTH );
+	litm_subscribe( receiver, 2 );
+
+	errors  = send_all( 2, sent );
+	errors += receive_all( receiver, MESSAGES, 0 );
+
+	// the switch finalizes the released envelopes:
+	//  only the cache reaches the joiner
+	usleep( 50*1000 );
+
+	litm_subscribe( joiner, 2 );
+	errors += receive_all( joiner, DEPTH, MESSAGES-DEPTH );
+	printf("replayed: received intact %s\n", (0==errors) ? "OK":"FAILED");
+	failures += (0!=errors);
+
+	printf("%s\n", (0==failures) ? "OK":"FAILED");
+	printf("#main: END\n");
+	return (0==failures) ? 0 : 1;
+}
+
+/**
+ * Sends MESSAGES slab messages on ``bus_id``, each
+ *  filled with its index, without a cleaner
+ *
+ * @return the number of failed sends
+ */
+int send_all(litm_bus bus_id, void **sent) {
+
+	unsigned char *msg;
+	litm_code code;
+	int i, j, errors = 0;
+
+	for (i=0; i<MESSAGES; i++) {
+
+		msg = (unsigned char *) litm_msg_alloc( sender, MSG_SIZE );
+		if (NULL==msg) {
+			errors++;
+			continue;
+		}
+
+		for (j=0; j<MSG_SIZE; j++)
+			msg[j] = (unsigned char) i;
+		sent[i] = msg;
+
+		do {
+			code = litm_send( sender, bus_id, msg, NULL, TYPE_TEST );
+			if (LITM_CODE_BUSY==code)
+				usleep( 100 );
+		} while (LITM_CODE_BUSY==code);
+
+		errors += (LITM_CODE_OK!=code);
+	}
+
+	return errors;
+}//
+
+/**
+ * Receives ``count`` messages, the indexes
+ *  from ``first`` on, and releases them
+ *
+ * @return the number of messages missing or altered
+ */
+int receive_all(litm_connection *conn, int count, int first) {
+
+	litm_envelope *e;
+	unsigned char *msg;
+	int i, j, type, errors = 0;
+
+	for (i=0; i<count; i++) {
+
+		if (LITM_CODE_OK!=litm_receive_wait_timer( conn, &e, 100*1000 ))
+			return errors + (count-i);
+
+		msg = (unsigned char *) litm_get_message( e, &type );
+		for (j=0; j<MSG_SIZE; j++)
+			errors += (msg[j] != (unsigned char) (first+i));
+
+		litm_release( conn, e );
+	}
+
+	return errors;
+}//
+
+/**
+ * Frees the blocks allocated by the main thread
+ */
+void *free_thread(void *params) {
+
+	void **blocks = (void **) params;
+	int i;
+
+	for (i=0; i<MESSAGES; i++)
+		litm_msg_free( blocks[i] );
+
+	return NULL;
+}//
@@ -0,0 +1,132 @@
+/*
+ * test15.c
+ *
+ *  Created on: 2026-10-19
+ *      Author: Jean-Lou Dupont
+ *
+ *
+ *  Type Filter Test
+ *
+ *  - a subscriber with a type filter receives only the
+ *    messages of those types, the others go on to the
+ *    next subscriber
+ *
+ *  - once the filter is removed, it receives every type
+ *
+ */
+
+#include <litm.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TYPES      6
+#define ROUNDS     20
+
+#define TYPE_TEST  LITM_MESSAGE_TYPE_USER_START
+
+litm_connection *sender, *filtered, *plain;
+
+int  send_all(void);
+int  check(litm_connection *conn, const char *name, const litm_type_set *expect);
+
+
+int main(int argc, char **argv) {
+	printf("#main: BEGIN\n");
+
+	litm_type_set wanted, all;
+	int i, failures = 0;
+
+	litm_connect_ex( &sender,   1 );
+	litm_connect_ex( &filtered, 2 );
+	litm_connect_ex( &plain,    3 );
+
+	litm_type_set_clear( &wanted );
+	litm_type_set_add( &wanted, TYPE_TEST+1 );
+	litm_type_set_add( &wanted, TYPE_TEST+3 );
+
+	litm_type_set_clear( &all );
+	for (i=0; i<TYPES; i++)
+		litm_type_set_add( &all, TYPE_TEST+i );
+
+	// the filtered subscriber comes first: the
+	//  messages it skips must still reach the other
+	litm_subscribe_filtered( filtered, 1, &wanted );
+	litm_subscribe( plain, 1 );
+
+	// ---- filtered
+	send_all();
+	failures += check( filtered, "filtered: wanted types only", &wanted );
+	failures += check( plain,    "filtered: others get all",    &all );
+
+	// ---- filter removed
+	litm_subscribe_filtered( filtered, 1, NULL );
+
+	send_all();
+	failures += check( filtered, "unfiltered: all types", &all );
+	failures += check( plain,    "unfiltered: others get all", &all );
+
+	printf("%s\n", (0==failures) ? "OK":"FAILED");
+	printf("#main: END\n");
+	return (0==failures) ? 0 : 1;
+}
+
+/**
+ * Sends ROUNDS messages of each of the TYPES types
+ */
+int send_all(void) {
+
+	litm_code code;
+	int i, j, *msg;
+
+	for (i=0; i<ROUNDS; i++)
+		for (j=0; j<TYPES; j++) {
+
+			msg = (int *) malloc( sizeof(int) );
+			*msg = j;
+
+			do {
+				code = litm_send( sender, 1, msg, NULL, TYPE_TEST+j );
+				if (LITM_CODE_BUSY==code)
+					usleep( 100 );
+			} while (LITM_CODE_BUSY==code);
+		}
+
+	return 0;
+}//
+
+/**
+ * Verifies that ``conn`` got ROUNDS messages of each
+ *  type in ``expect`` and none of the others
+ *
+ * @return 1 on failure
+ */
+int check(litm_connection *conn, const char *name, const litm_type_set *expect) {
+
+	litm_envelope *e;
+	int received[TYPES];
+	int i, type, errors = 0, *msg;
+
+	memset( received, 0, sizeof(received) );
+
+	while (LITM_CODE_OK==litm_receive_wait_timer( conn, &e, 50*1000 )) {
+
+		msg = (int *) litm_get_message( e, &type );
+
+		// the type and the message must agree
+		if ((0 <= *msg) && (TYPES > *msg) && (TYPE_TEST+*msg == type))
+			received[*msg]++;
+		else
+			errors++;
+
+		litm_release( conn, e );
+	}
+
+	for (i=0; i<TYPES; i++)
+		errors += (received[i] != (litm_type_set_has( expect, TYPE_TEST+i ) ? ROUNDS : 0));
+
+	printf("%s %s\n", name, (0==errors) ? "OK":"FAILED");
+
+	return (0!=errors);
+}//
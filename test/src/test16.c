@@ -0,0 +1,125 @@
+/*
+ * test16.c
+ *
+ *  Created on: 2026-10-19
+ *      Author: Jean-Lou Dupont
+ *
+ *
+ *  Priority Lanes Test
+ *
+ *  - messages queued up on all the lanes are received in
+ *    priority order, FIFO inside each lane
+ *
+ *  - a bulk message waiting behind a stream of high priority
+ *    messages gets through after LITM_PRIORITY_QUOTA of them
+ *
+ */
+
+#include <litm.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define PER_LANE   2
+#define STREAM     (3*LITM_PRIORITY_QUOTA)
+
+#define TYPE_TEST  LITM_MESSAGE_TYPE_USER_START
+
+// a message: its lane and its rank inside the lane
+#define MSG(lane, rank)  ((lane)*1000 + (rank))
+#define MSG_LANE(msg)    ((msg)/1000)
+#define MSG_RANK(msg)    ((msg)%1000)
+
+litm_connection *sender, *receiver;
+
+void send_one(int priority, int rank);
+int  receive_all(int *received, int max);
+
+
+int main(int argc, char **argv) {
+	printf("#main: BEGIN\n");
+
+	int received[STREAM+PER_LANE*LITM_PRIORITY_LEVELS];
+	int next[LITM_PRIORITY_LEVELS];
+	int i, count, lane, errors, failures = 0;
+
+	litm_connect_ex( &sender,   1 );
+	litm_connect_ex( &receiver, 2 );
+	litm_subscribe( receiver, 1 );
+
+	// ---- all lanes, lowest priority sent first
+	for (lane=LITM_PRIORITY_BULK; lane>=LITM_PRIORITY_URGENT; lane--)
+		for (i=0; i<PER_LANE; i++)
+			send_one( lane, i );
+
+	count = receive_all( received, PER_LANE*LITM_PRIORITY_LEVELS );
+
+	// few enough for the quota not to kick in
+	for (errors=0, i=0; i<count; i++)
+		errors += (received[i] != MSG(i/PER_LANE, i%PER_LANE));
+
+	errors += (PER_LANE*LITM_PRIORITY_LEVELS != count);
+	printf("lanes: priority order, FIFO inside a lane %s\n", (0==errors) ? "OK":"FAILED");
+	failures += (0!=errors);
+
+	// ---- bulk messages behind a high priority stream
+	send_one( LITM_PRIORITY_BULK, 0 );
+	send_one( LITM_PRIORITY_BULK, 1 );
+	for (i=0; i<STREAM; i++)
+		send_one( LITM_PRIORITY_HIGH, i );
+
+	count = receive_all( received, STREAM+2 );
+
+	for (lane=0; lane<LITM_PRIORITY_LEVELS; lane++)
+		next[lane] = 0;
+
+	for (errors=0, i=0; i<count; i++) {
+		lane = MSG_LANE(received[i]);
+		errors += (MSG_RANK(received[i]) != next[lane]++);
+	}
+
+	// the first bulk message overtakes the rest of the stream
+	errors += (STREAM+2 != count) || (MSG(LITM_PRIORITY_BULK, 0) != received[LITM_PRIORITY_QUOTA]);
+	printf("quota: bulk at[%i] %s\n", LITM_PRIORITY_QUOTA, (0==errors) ? "OK":"FAILED");
+	failures += (0!=errors);
+
+	printf("%s\n", (0==failures) ? "OK":"FAILED");
+	printf("#main: END\n");
+	return (0==failures) ? 0 : 1;
+}
+
+void send_one(int priority, int rank) {
+
+	litm_code code;
+	int *msg;
+
+	msg = (int *) malloc( sizeof(int) );
+	*msg = MSG(priority, rank);
+
+	do {
+		code = litm_send_priority( sender, 1, msg, NULL, TYPE_TEST, priority );
+		if (LITM_CODE_BUSY==code)
+			usleep( 100 );
+	} while (LITM_CODE_BUSY==code);
+}//
+
+/**
+ * Lets the switch fill the receiver's input queue
+ *  then receives up to ``max`` messages
+ *
+ * @return the number of messages received
+ */
+int receive_all(int *received, int max) {
+
+	litm_envelope *e;
+	int count, type;
+
+	usleep( 50*1000 );
+
+	for (count=0; (count<max) && (LITM_CODE_OK==litm_receive_nb( receiver, &e )); count++) {
+		received[count] = *((int *) litm_get_message( e, &type ));
+		litm_release( receiver, e );
+	}
+
+	return count;
+}//
@@ -0,0 +1,117 @@
+/*
+ * test17.c
+ *
+ *  Created on: 2026-10-19
+ *      Author: Jean-Lou Dupont
+ *
+ *
+ *  Completion Tokens Test
+ *
+ *  - whilst a recipient holds the message, the token polls
+ *    as busy and a timed wait times out
+ *
+ *  - a thread blocked on the token wakes up once the last
+ *    recipient releases the message, with the counts
+ *
+ */
+
+#include <litm.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#define TIMEOUT    (20*1000)
+
+#define TYPE_TEST  LITM_MESSAGE_TYPE_USER_START
+
+litm_connection *sender, *first, *second;
+
+volatile int woken = 0;
+
+void *waiter_thread(void *params);
+long elapsed_usecs(struct timeval *start);
+
+
+int main(int argc, char **argv) {
+	printf("#main: BEGIN\n");
+
+	litm_envelope *e1, *e2;
+	litm_token *token;
+	litm_code code;
+	pthread_t tw;
+	struct timeval start;
+	long elapsed;
+	int *msg, delivered = -1, released = -1, errors, failures = 0;
+
+	litm_connect_ex( &sender, 1 );
+	litm_connect_ex( &first,  2 );
+	litm_connect_ex( &second, 3 );
+	litm_subscribe( first,  1 );
+	litm_subscribe( second, 1 );
+
+	msg = (int *) malloc( sizeof(int) );
+	*msg = 1;
+	litm_send_tracked( sender, 1, msg, &free, TYPE_TEST, &token );
+
+	// ---- held by the first recipient
+	errors = (LITM_CODE_OK!=litm_receive_wait_timer( first, &e1, 100*1000 ));
+	errors += (LITM_CODE_BUSY!=litm_token_poll( token ));
+
+	gettimeofday( &start, NULL );
+	code = litm_token_wait( token, TIMEOUT );
+	elapsed = elapsed_usecs( &start );
+
+	errors += (LITM_CODE_BUSY!=code) || (TIMEOUT > elapsed);
+	printf("held: poll busy, wait timed out after[%li] %s\n", elapsed, (0==errors) ? "OK":"FAILED");
+	failures += (0!=errors);
+
+	// ---- a waiter blocked until the last release
+	pthread_create( &tw, NULL, &waiter_thread, (void *) token );
+
+	litm_release( first, e1 );
+	errors = (LITM_CODE_OK!=litm_receive_wait_timer( second, &e2, 100*1000 ));
+
+	usleep( 10*1000 );
+	errors += (0!=woken);
+
+	litm_release( second, e2 );
+	pthread_join( tw, NULL );
+
+	errors += (1!=woken) || (LITM_CODE_OK!=litm_token_poll( token ));
+	litm_token_get_counts( token, &delivered, &released );
+	errors += (2!=delivered) || (2!=released);
+	printf("released: waiter woken, delivered[%i] released[%i] %s\n", delivered, released, (0==errors) ? "OK":"FAILED");
+	failures += (0!=errors);
+
+	litm_token_release( token );
+
+	printf("%s\n", (0==failures) ? "OK":"FAILED");
+	printf("#main: END\n");
+	return (0==failures) ? 0 : 1;
+}
+
+/**
+ * Waits on the token without a time limit
+ */
+void *waiter_thread(void *params) {
+
+	litm_token *token = (litm_token *) params;
+
+	if (LITM_CODE_OK==litm_token_wait( token, -1 ))
+		woken = 1;
+	else
+		woken = -1;
+
+	return NULL;
+}//
+
+long elapsed_usecs(struct timeval *start) {
+
+	struct timeval now;
+
+	gettimeofday( &now, NULL );
+
+	return (now.tv_sec - start->tv_sec) * 1000000L + (now.tv_usec - start->tv_usec);
+}//
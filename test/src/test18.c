@@ -0,0 +1,116 @@
+/*
+ * test18.c
+ *
+ *  Created on: 2026-10-19
+ *      Author: Jean-Lou Dupont
+ *
+ *
+ *  Direct Send Test
+ *
+ *  - litm_send_to reaches the connection with the target id,
+ *    and only it, without any subscription; the ids collide
+ *    in the connections' index
+ *
+ *  - an unknown id, or one whose connection is closed, is
+ *    refused
+ *
+ */
+
+#include <litm.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define TARGETS    3
+#define TYPE_TEST  LITM_MESSAGE_TYPE_USER_START
+
+// multiples of the index size: same home slot
+int ids[TARGETS] = { 32, 64, 96 };
+
+litm_connection *sender, *targets[TARGETS];
+
+litm_code send_to(int target_id);
+int  check(int index, int expect);
+
+
+int main(int argc, char **argv) {
+	printf("#main: BEGIN\n");
+
+	litm_code codes[2];
+	int i, errors, failures = 0;
+
+	litm_connect_ex( &sender, 1 );
+	for (i=0; i<TARGETS; i++)
+		litm_connect_ex( &targets[i], ids[i] );
+
+	// ---- by id
+	for (errors=0, i=0; i<TARGETS; i++)
+		errors += (LITM_CODE_OK!=send_to( ids[i] ));
+
+	for (i=0; i<TARGETS; i++)
+		errors += check( i, ids[i] );
+	printf("by id: each to its target %s\n", (0==errors) ? "OK":"FAILED");
+	failures += (0!=errors);
+
+	// ---- unknown & closed
+	litm_disconnect( targets[1] );
+
+	codes[0] = send_to( 999 );
+	codes[1] = send_to( ids[1] );
+
+	errors  = (LITM_CODE_ERROR_INVALID_TARGET!=codes[0]) || (LITM_CODE_ERROR_INVALID_TARGET!=codes[1]);
+	printf("unknown: refused %s\n", (0==errors) ? "OK":"FAILED");
+	failures += (0!=errors);
+
+	// ---- the others still found past the removed one
+	errors  = (LITM_CODE_OK!=send_to( ids[2] ));
+	errors += check( 2, ids[2] );
+	printf("closed: others still found %s\n", (0==errors) ? "OK":"FAILED");
+	failures += (0!=errors);
+
+	printf("%s\n", (0==failures) ? "OK":"FAILED");
+	printf("#main: END\n");
+	return (0==failures) ? 0 : 1;
+}
+
+/**
+ * Sends the ``target_id`` to itself
+ */
+litm_code send_to(int target_id) {
+
+	litm_code code;
+	int *msg;
+
+	msg = (int *) malloc( sizeof(int) );
+	*msg = target_id;
+
+	// refused before any envelope: the cleaner doesn't run
+	code = litm_send_to( sender, target_id, msg, &free, TYPE_TEST );
+	if (LITM_CODE_ERROR_INVALID_TARGET==code)
+		free( msg );
+
+	return code;
+}//
+
+/**
+ * Verifies that the target ``index`` got a single
+ *  message, holding ``expect``
+ *
+ * @return 1 on failure
+ */
+int check(int index, int expect) {
+
+	litm_envelope *e;
+	int type, got = 0, errors = 0, *msg;
+
+	while (LITM_CODE_OK==litm_receive_wait_timer( targets[index], &e, 50*1000 )) {
+
+		msg = (int *) litm_get_message( e, &type );
+		errors += (expect != *msg);
+		got++;
+
+		litm_release( targets[index], e );
+	}
+
+	return (0!=errors) || (1!=got);
+}//
@@ -0,0 +1,106 @@
+/*
+ * test19.c
+ *
+ *  Created on: 2026-10-19
+ *      Author: Jean-Lou Dupont
+ *
+ *
+ *  Multi-Bus Send Test
+ *
+ *  - a message sent on several busses reaches a subscriber
+ *    of more than one of them once, and every subscriber
+ *    of any of them
+ *
+ *  - the cleaner runs once, after the last release
+ *
+ */
+
+#include <litm.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define MESSAGES   50
+
+#define TYPE_TEST  LITM_MESSAGE_TYPE_USER_START
+
+litm_connection *sender, *both, *single;
+
+volatile int cleaned = 0;
+
+void counting_cleaner(void *msg);
+int  check(litm_connection *conn, const char *name);
+
+
+int main(int argc, char **argv) {
+	printf("#main: BEGIN\n");
+
+	litm_bus_set bus_set = LITM_BUS_SET(1) | LITM_BUS_SET(2) | LITM_BUS_SET(3);
+	litm_code code;
+	int i, *msg, errors, failures = 0;
+
+	litm_connect_ex( &sender, 1 );
+	litm_connect_ex( &both,   2 );
+	litm_connect_ex( &single, 3 );
+
+	litm_subscribe( both,   1 );
+	litm_subscribe( both,   2 );
+	litm_subscribe( single, 3 );
+
+	for (i=0; i<MESSAGES; i++) {
+
+		msg = (int *) malloc( sizeof(int) );
+		*msg = i;
+
+		do {
+			code = litm_send_multi( sender, bus_set, msg, &counting_cleaner, TYPE_TEST );
+			if (LITM_CODE_BUSY==code)
+				usleep( 100 );
+		} while (LITM_CODE_BUSY==code);
+	}
+
+	failures += check( both,   "two busses: once each" );
+	failures += check( single, "one bus: once each" );
+
+	// the switch finalizes the last released envelopes
+	usleep( 50*1000 );
+
+	errors = (MESSAGES!=cleaned);
+	printf("cleaned once[%i] %s\n", cleaned, (0==errors) ? "OK":"FAILED");
+	failures += (0!=errors);
+
+	printf("%s\n", (0==failures) ? "OK":"FAILED");
+	printf("#main: END\n");
+	return (0==failures) ? 0 : 1;
+}
+
+/**
+ * Verifies that ``conn`` got each message once, in order
+ *
+ * @return 1 on failure
+ */
+int check(litm_connection *conn, const char *name) {
+
+	litm_envelope *e;
+	int type, got = 0, errors = 0, *msg;
+
+	while (LITM_CODE_OK==litm_receive_wait_timer( conn, &e, 50*1000 )) {
+
+		msg = (int *) litm_get_message( e, &type );
+		errors += (got != *msg);
+		got++;
+
+		litm_release( conn, e );
+	}
+
+	errors += (MESSAGES!=got);
+	printf("%s, got[%i] %s\n", name, got, (0==errors) ? "OK":"FAILED");
+
+	return (0!=errors);
+}//
+
+void counting_cleaner(void *msg) {
+
+	__sync_fetch_and_add( &cleaned, 1 );
+	free( msg );
+}
@@ -0,0 +1,173 @@
+/*
+ * test7.c
+ *
+ *  Created on: 2026-10-19
+ *      Author: Jean-Lou Dupont
+ *
+ *
+ *  Work-Queue & Partitioned busses Test
+ *
+ *  - bus #1 is a ``work-queue`` bus: each message must be
+ *    received by exactly one worker
+ *
+ *  - bus #2 is a ``partitioned`` bus: all messages with the
+ *    same key must be received by the same worker
+ *
+ */
+
+#include <litm.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#define WORKERS  4
+#define MESSAGES 1000
+#define KEYS     64
+
+typedef struct {
+
+	int thread_id;
+	litm_connection *conn;
+
+} thread_params;
+
+pthread_t threads[WORKERS+1];
+litm_connection *conns[WORKERS+1];
+thread_params params[WORKERS+1];
+
+volatile int _exit_threads = 0;
+
+int work_received[WORKERS+1];
+int key_owner[KEYS];
+int key_errors = 0;
+
+typedef struct _message {
+	int code;
+	unsigned int key;
+} message;
+
+message messages[MESSAGES];
+
+void create_connections(void);
+void create_threads(void);
+void *threadFunction(void *params);
+void void_cleaner(void *msg);
+
+
+int main(int argc, char **argv) {
+	printf("#main: BEGIN\n");
+
+	int i, total=0;
+	litm_code code;
+
+	create_connections();
+
+	litm_bus_set_mode(1, LITM_BUS_MODE_WORK_ROUND_ROBIN);
+	litm_bus_set_mode(2, LITM_BUS_MODE_PARTITIONED);
+
+	create_threads();
+
+	for (i=0;i<MESSAGES;i++) {
+		messages[i].code = i;
+		messages[i].key  = i % KEYS;
+
+		do {
+			code = litm_send( conns[0], 1, &messages[i], &void_cleaner, LITM_MESSAGE_TYPE_USER_START );
+		} while (LITM_CODE_BUSY==code);
+
+		do {
+			code = litm_send_keyed( conns[0], 2, messages[i].key, &messages[i], &void_cleaner, LITM_MESSAGE_TYPE_USER_START+1 );
+		} while (LITM_CODE_BUSY==code);
+	}
+
+	sleep(2);
+	_exit_threads = 1;
+
+	for (i=1;i<=WORKERS;i++) {
+		pthread_join( threads[i], NULL );
+		printf("Worker [%u] work received[%i]\n", i, work_received[i]);
+		total += work_received[i];
+	}
+
+	printf("work-queue: sent[%i] received[%i] %s\n", MESSAGES, total, (MESSAGES==total) ? "OK":"FAILED");
+	printf("partitioned: key errors[%i] %s\n", key_errors, (0==key_errors) ? "OK":"FAILED");
+
+	printf("#main: END\n");
+	return ((MESSAGES==total) && (0==key_errors)) ? 0 : 1;
+}
+
+
+void create_connections(void) {
+
+	int i;
+	litm_code code;
+
+	for (i=0;i<=WORKERS;i++) {
+
+		code = litm_connect_ex( &conns[i], 100+i );
+		if (LITM_CODE_OK!=code)
+			printf("* CREATE CONNECTION, code[%s] id[%u]\n", litm_translate_code(code), i);
+	}
+
+}
+
+void create_threads(void) {
+
+	int i;
+
+	for (i=1;i<=WORKERS;i++) {
+
+		params[i].thread_id = i;
+		params[i].conn = conns[i];
+
+		litm_subscribe( conns[i], 1 );
+		litm_subscribe( conns[i], 2 );
+
+		pthread_create( &threads[i], NULL, &threadFunction, (void *) &params[i] );
+	}
+
+}//
+
+
+void *threadFunction(void *params) {
+
+	thread_params *tp = (thread_params *) params;
+
+	int thread_id, type;
+	litm_connection *conn;
+	litm_envelope *e;
+	litm_code code;
+	message *msg;
+
+	thread_id = tp->thread_id;
+	conn      = tp->conn;
+
+	while (0==_exit_threads) {
+
+		code = litm_receive_wait_timer(conn, &e, 10*1000);
+		if (LITM_CODE_OK!=code)
+			continue;
+
+		msg = (message *) litm_get_message(e, &type);
+
+		if (LITM_MESSAGE_TYPE_USER_START==type) {
+			work_received[thread_id]++;
+		} else {
+			// only this worker ever touches the slots of its keys
+			if (0==key_owner[msg->key])
+				key_owner[msg->key] = thread_id;
+			else if (thread_id!=key_owner[msg->key])
+				key_errors++;
+		}
+
+		litm_release(conn, e);
+	}
+
+	return NULL;
+}//
+
+void void_cleaner(void *msg) {
+}
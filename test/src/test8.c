@@ -0,0 +1,119 @@
+/*
+ * test8.c
+ *
+ *  Created on: 2026-10-19
+ *      Author: Jean-Lou Dupont
+ *
+ *
+ *  Time-To-Live Test
+ *
+ *  - a slow subscriber starts receiving long after a
+ *    burst of short-lived messages was sent: none of them
+ *    must be presented, yet every cleaner must run
+ *
+ *  - messages with a generous TTL must all be received
+ *
+ *  - the short-lived ones count as expired and the
+ *    subscriber's received & released counts agree
+ *
+ */
+
+#include <litm.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#define MESSAGES   100
+#define SHORT_TTL  1000         // 1ms
+#define LONG_TTL   10*1000*1000 // 10s
+
+#define TYPE_SHORT LITM_MESSAGE_TYPE_USER_START
+#define TYPE_LONG  LITM_MESSAGE_TYPE_USER_START+1
+
+litm_connection *sender, *receiver;
+
+volatile int cleaned = 0;
+int received_short = 0, received_long = 0;
+
+int messages[MESSAGES];
+
+void counting_cleaner(void *msg);
+void receive_for(int usecs);
+
+
+int main(int argc, char **argv) {
+	printf("#main: BEGIN\n");
+
+	int i, failures = 0;
+	litm_code code;
+	litm_switch_stats stats;
+
+	litm_connect_ex( &sender,   1 );
+	litm_connect_ex( &receiver, 2 );
+	litm_subscribe( receiver, 1 );
+
+	for (i=0;i<MESSAGES;i++) {
+		do {
+			code = litm_send_ttl( sender, 1, &messages[i], &counting_cleaner, TYPE_SHORT, SHORT_TTL );
+		} while (LITM_CODE_BUSY==code);
+	}
+
+	// the subscriber is busy elsewhere...
+	usleep( 50*1000 );
+
+	for (i=0;i<MESSAGES;i++) {
+		do {
+			code = litm_send_ttl( sender, 1, &messages[i], &counting_cleaner, TYPE_LONG, LONG_TTL );
+		} while (LITM_CODE_BUSY==code);
+	}
+
+	receive_for( 500*1000 );
+
+	litm_get_switch_stats( &stats );
+
+	printf("short: received[%i] %s\n", received_short, (0==received_short) ? "OK":"FAILED");
+	printf("long:  received[%i] %s\n", received_long, (MESSAGES==received_long) ? "OK":"FAILED");
+	printf("cleaned[%i] %s\n", cleaned, (2*MESSAGES==cleaned) ? "OK":"FAILED");
+	printf("switch: delivered[%li] expired[%li] busy[%li] %s\n", stats.delivered, stats.expired, stats.busy,
+			(MESSAGES==stats.expired) ? "OK":"FAILED");
+	printf("receiver: received[%i] released[%i] %s\n", receiver->received, receiver->released,
+			(receiver->received==receiver->released) ? "OK":"FAILED");
+
+	failures += (0!=received_short) + (MESSAGES!=received_long) + (2*MESSAGES!=cleaned);
+	failures += (MESSAGES!=stats.expired) + (receiver->received!=receiver->released);
+
+	printf("#main: END\n");
+	return (0==failures) ? 0 : 1;
+}
+
+void receive_for(int usecs) {
+
+	litm_envelope *e;
+	litm_code code;
+	int type, waited = 0;
+
+	while (waited < usecs) {
+
+		code = litm_receive_wait_timer( receiver, &e, 10*1000 );
+		if (LITM_CODE_OK!=code) {
+			waited += 10*1000;
+			continue;
+		}
+
+		litm_get_message( e, &type );
+		if (TYPE_SHORT==type)
+			received_short++;
+		else
+			received_long++;
+
+		litm_release( receiver, e );
+	}
+
+}//
+
+void counting_cleaner(void *msg) {
+
+	__sync_fetch_and_add( &cleaned, 1 );
+}
@@ -0,0 +1,150 @@
+/*
+ * test9.c
+ *
+ *  Created on: 2026-10-19
+ *      Author: Jean-Lou Dupont
+ *
+ *
+ *  Request / Reply Test
+ *
+ *  - 2 clients issue requests concurrently to a server
+ *    on the same bus: each must get the replies to its own
+ *    requests, in order, without filtering
+ *
+ *  - a request left unanswered must time out and the late
+ *    reply must be dropped (its cleaner runs)
+ *
+ */
+
+#include <litm.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#define REQUESTS   1000
+#define TIMEOUT    1000*1000 // 1s
+#define SLOW       -1
+
+#define TYPE_REQUEST LITM_MESSAGE_TYPE_USER_START
+#define TYPE_REPLY   LITM_MESSAGE_TYPE_USER_START+1
+
+litm_connection *server, *client1, *client2;
+
+volatile int cleaned = 0, stop = 0;
+int errors[2] = {0, 0};
+litm_code late_code = LITM_CODE_OK;
+
+void counting_cleaner(void *msg);
+void *server_thread(void *params);
+void *client_thread(void *params);
+
+
+int main(int argc, char **argv) {
+	printf("#main: BEGIN\n");
+
+	pthread_t ts, t1, t2;
+	litm_envelope *reply;
+	litm_code code;
+	int *msg;
+
+	litm_connect_ex( &server,  1 );
+	litm_connect_ex( &client1, 2 );
+	litm_connect_ex( &client2, 3 );
+	litm_subscribe( server, 1 );
+
+	pthread_create( &ts, NULL, &server_thread, NULL );
+	pthread_create( &t1, NULL, &client_thread, (void *) 0 );
+	pthread_create( &t2, NULL, &client_thread, (void *) 1 );
+
+	pthread_join( t1, NULL );
+	pthread_join( t2, NULL );
+
+	// the server sleeps on this one
+	msg = (int *) malloc( sizeof(int) );
+	*msg = SLOW;
+	code = litm_request( client1, 1, msg, &counting_cleaner, TYPE_REQUEST, 10*1000, &reply );
+
+	usleep( 200*1000 );
+	stop = 1;
+	pthread_join( ts, NULL );
+	usleep( 50*1000 );
+
+	printf("client1: errors[%i] %s\n", errors[0], (0==errors[0]) ? "OK":"FAILED");
+	printf("client2: errors[%i] %s\n", errors[1], (0==errors[1]) ? "OK":"FAILED");
+	printf("timeout: code[%s] %s\n", litm_translate_code(code), (LITM_CODE_NO_MESSAGE==code) ? "OK":"FAILED");
+	printf("late reply: code[%s] %s\n", litm_translate_code(late_code), (LITM_CODE_ERROR_REQUEST_EXPIRED==late_code) ? "OK":"FAILED");
+	printf("cleaned[%i] %s\n", cleaned, (4*REQUESTS+2==cleaned) ? "OK":"FAILED");
+
+	printf("#main: END\n");
+	return 0;
+}
+
+void *client_thread(void *params) {
+
+	int index = (int) (long) params;
+	litm_connection *conn = (0==index) ? client1:client2;
+	litm_envelope *reply;
+	litm_code code;
+	int i, type, *msg, *answer;
+
+	for (i=1;i<=REQUESTS;i++) {
+
+		msg = (int *) malloc( sizeof(int) );
+		*msg = i;
+
+		do {
+			code = litm_request( conn, 1, msg, &counting_cleaner, TYPE_REQUEST, TIMEOUT, &reply );
+		} while (LITM_CODE_BUSY==code);
+
+		if (LITM_CODE_OK!=code) {
+			errors[index]++;
+			continue;
+		}
+
+		answer = (int *) litm_get_message( reply, &type );
+		if ((TYPE_REPLY!=type) || (2*i!=*answer))
+			errors[index]++;
+
+		litm_release( conn, reply );
+	}
+
+	return NULL;
+}//
+
+void *server_thread(void *params) {
+
+	litm_envelope *e;
+	litm_code code;
+	int type, *msg, *answer;
+
+	while (!stop) {
+
+		code = litm_receive_wait_timer( server, &e, 10*1000 );
+		if (LITM_CODE_OK!=code)
+			continue;
+
+		msg = (int *) litm_get_message( e, &type );
+
+		answer = (int *) malloc( sizeof(int) );
+		*answer = 2 * (*msg);
+
+		if (SLOW==*msg) {
+			usleep( 50*1000 );
+			late_code = litm_reply( server, e, answer, &counting_cleaner, TYPE_REPLY );
+		} else {
+			litm_reply( server, e, answer, &counting_cleaner, TYPE_REPLY );
+		}
+
+		litm_release( server, e );
+	}
+
+	return NULL;
+}//
+
+void counting_cleaner(void *msg) {
+
+	free( msg );
+	__sync_fetch_and_add( &cleaned, 1 );
+}